@@ -0,0 +1,265 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsAnalysis.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	/**
+	 * A move changes cells up to 2 from its block and the evaluation of a cell looks 1 further, so its gain only
+	 * depends on the cells up to 3 away. The capital bonus reaches 2 from a capital, so a move near a capital also
+	 * depends on the cells near it.
+	 */
+	const int32 MoveRadius = 3;
+	const int32 CapitalRadius = 2;
+
+	/** Fewest blocks worth giving a worker thread, each one copies the board */
+	const int32 MinBlocksPerTask = 16;
+
+	const int32 SlotOffsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+}
+
+const float FColourWarsAnalysis::NoMove = -MAX_flt;
+
+FColourWarsAnalysis::FColourWarsAnalysis(const FColourWarsEvalWeights& InWeights)
+	: Eval(InWeights)
+	, Size(0)
+	, NumberOfPlayers(0)
+	, NumEvaluated(0)
+{
+	FMemory::Memzero(AliveMasks);
+	FMemory::Memzero(LastBlockMasks);
+}
+
+void FColourWarsAnalysis::Reset()
+{
+	Size = 0;
+	NumberOfPlayers = 0;
+}
+
+/// <summary>
+/// Only the moves within MoveRadius of the cell can have changed, or within MoveRadius + CapitalRadius when a capital
+/// is close enough for its bonus to reach the cell. A capital that moved changes its own cell, which covers the moves
+/// that relied on where it was.
+/// </summary>
+void FColourWarsAnalysis::MarkCellChanged(const FColourWarsBoard& Board, int32 Index)
+{
+	if (Size != Board.GetSize() || NumberOfPlayers != Board.GetNumberOfPlayers())
+	{
+		return;
+	}
+
+	const int32 X = Index / Size;
+	const int32 Y = Index % Size;
+
+	bool bNearCapital = false;
+	for (int32 NearX = FMath::Max(X - CapitalRadius, 0); NearX <= FMath::Min(X + CapitalRadius, Size - 1) && !bNearCapital; NearX++)
+	{
+		for (int32 NearY = FMath::Max(Y - CapitalRadius, 0); NearY <= FMath::Min(Y + CapitalRadius, Size - 1); NearY++)
+		{
+			if (Board.IsCapitalBlock(Board.ToIndex(NearX, NearY)))
+			{
+				bNearCapital = true;
+				break;
+			}
+		}
+	}
+
+	MarkSquare(Index, bNearCapital ? MoveRadius + CapitalRadius : MoveRadius);
+}
+
+void FColourWarsAnalysis::MarkSquare(int32 Index, int32 Radius)
+{
+	const int32 X = Index / Size;
+	const int32 Y = Index % Size;
+	const int32 MinY = FMath::Max(Y - Radius, 0);
+	const int32 NumY = FMath::Min(Y + Radius, Size - 1) - MinY + 1;
+
+	for (int32 Player = 1; Player <= NumberOfPlayers; Player++)
+	{
+		for (int32 NearX = FMath::Max(X - Radius, 0); NearX <= FMath::Min(X + Radius, Size - 1); NearX++)
+		{
+			FMemory::Memset(&Dirty[Player][NearX * Size + MinY], 1, NumY);
+		}
+	}
+}
+
+FColourWarsMove FColourWarsAnalysis::GetSlotMove(const FColourWarsBoard& Board, int32 Index, int32 Slot) const
+{
+	const IntVector From = Board.ToCoord(Index);
+	if (Slot == 0)
+	{
+		return FColourWarsMove(eMoveType::AddOne, From);
+	}
+	if (Slot == 1)
+	{
+		return FColourWarsMove(eMoveType::Combine, From);
+	}
+
+	const IntVector To(From.X + SlotOffsets[Slot - 2][0], From.Y + SlotOffsets[Slot - 2][1]);
+	if (!Board.IsValidCoord(To.X, To.Y))
+	{
+		return FColourWarsMove();
+	}
+
+	const int32 ToIndex = Board.ToIndex(To);
+	if (Board.GetBlockType(ToIndex) != Board.GetBlockType(Index) && !Board.CanDefeat(Index, ToIndex))
+	{
+		return FColourWarsMove();
+	}
+
+	return FColourWarsMove(eMoveType::Move, From, To);
+}
+
+/// <summary>
+/// The gains of moves away from the changed cells still hold with one exception: a move that takes an opponent's
+/// last block changes who is left, which changes the whole evaluation, so those are always evaluated again, and so
+/// is everything once who is left, or who is down to one block, is not as it was.
+/// </summary>
+void FColourWarsAnalysis::Update(const FColourWarsBoard& Board)
+{
+	const int32 NumCells = Board.GetNumCells();
+	if (Size != Board.GetSize() || NumberOfPlayers != Board.GetNumberOfPlayers())
+	{
+		Size = Board.GetSize();
+		NumberOfPlayers = Board.GetNumberOfPlayers();
+		for (int32 Player = 1; Player <= NumberOfPlayers; Player++)
+		{
+			Gains[Player].Init(NoMove, NumCells * NumSlots);
+			Dirty[Player].Init(1, NumCells);
+			AliveMasks[Player] = 0;
+			LastBlockMasks[Player] = 0;
+		}
+	}
+
+	CellScores.Init(NoMove, NumCells);
+	NumEvaluated = 0;
+
+	const eBlockType Player = Board.GetCurrentPlayer();
+	const int32 PlayerInt = static_cast<int32>(Player);
+	if (Board.IsGameOver() || PlayerInt < 1 || PlayerInt > NumberOfPlayers)
+	{
+		return;
+	}
+
+	int32 Counts[5] = {};
+	int32 LastBlocks[5] = {};
+	for (int32 Index = 0; Index < NumCells; Index++)
+	{
+		const int32 Type = static_cast<int32>(Board.GetBlockType(Index));
+		Counts[Type]++;
+		LastBlocks[Type] = Index;
+	}
+
+	uint8 AliveMask = 0;
+	uint8 LastBlockMask = 0;
+	for (int32 Other = 1; Other <= NumberOfPlayers; Other++)
+	{
+		AliveMask |= Counts[Other] > 0 ? 1 << Other : 0;
+		LastBlockMask |= Counts[Other] == 1 ? 1 << Other : 0;
+	}
+
+	TArray<uint8>& PlayerDirty = Dirty[PlayerInt];
+	if (AliveMask != AliveMasks[PlayerInt] || LastBlockMask != LastBlockMasks[PlayerInt])
+	{
+		FMemory::Memset(PlayerDirty.GetData(), 1, NumCells);
+		AliveMasks[PlayerInt] = AliveMask;
+		LastBlockMasks[PlayerInt] = LastBlockMask;
+	}
+
+	for (int32 Other = 1; Other <= NumberOfPlayers; Other++)
+	{
+		if (Other != PlayerInt && Counts[Other] == 1)
+		{
+			Board.ForEachNeighbour(LastBlocks[Other], false, [&PlayerDirty](int32 NeighbourIndex) { PlayerDirty[NeighbourIndex] = 1; });
+		}
+	}
+
+	FColourWarsBoard Passed = Board;
+	Passed.ApplyTurn(FColourWarsMove());
+	const float PassScore = Eval.Evaluate(Passed, Player);
+
+	TArray<float>& PlayerGains = Gains[PlayerInt];
+	TArray<int32> Work;
+	for (int32 Index = 0; Index < NumCells; Index++)
+	{
+		if (!PlayerDirty[Index])
+		{
+			continue;
+		}
+
+		if (Board.GetBlockType(Index) == Player)
+		{
+			Work.Add(Index);
+		}
+		else
+		{
+			for (int32 Slot = 0; Slot < NumSlots; Slot++)
+			{
+				PlayerGains[Index * NumSlots + Slot] = NoMove;
+			}
+		}
+	}
+
+	const int32 NumTasks = FMath::Clamp(Work.Num() / MinBlocksPerTask, 1, FPlatformMisc::NumberOfCoresIncludingHyperthreads() * 4);
+	TArray<int32> TaskEvaluated;
+	TaskEvaluated.Init(0, NumTasks);
+
+	ParallelFor(NumTasks, [&](int32 Task)
+	{
+		FColourWarsBoard Copy = Board;
+		FColourWarsTurnDelta Delta;
+
+		const int32 Begin = (int64)Work.Num() * Task / NumTasks;
+		const int32 End = (int64)Work.Num() * (Task + 1) / NumTasks;
+		for (int32 WorkIndex = Begin; WorkIndex < End; WorkIndex++)
+		{
+			const int32 Index = Work[WorkIndex];
+			for (int32 Slot = 0; Slot < NumSlots; Slot++)
+			{
+				const FColourWarsMove Move = GetSlotMove(Copy, Index, Slot);
+				if (Move.MoveType == eMoveType::Invalid)
+				{
+					PlayerGains[Index * NumSlots + Slot] = NoMove;
+					continue;
+				}
+
+				Copy.ApplyTurn(Move, Delta);
+				PlayerGains[Index * NumSlots + Slot] = Eval.Evaluate(Copy, Player) - PassScore;
+				Copy.UndoTurn(Delta);
+				TaskEvaluated[Task]++;
+			}
+		}
+	}, NumTasks == 1);
+
+	for (int32 Evaluated : TaskEvaluated)
+	{
+		NumEvaluated += Evaluated;
+	}
+
+	FMemory::Memzero(PlayerDirty.GetData(), NumCells);
+
+	for (int32 Index = 0; Index < NumCells; Index++)
+	{
+		if (Board.GetBlockType(Index) != Player)
+		{
+			continue;
+		}
+
+		const float* Slots = &PlayerGains[Index * NumSlots];
+		const float Own = FMath::Max(Slots[0], Slots[1]);
+		if (Own != NoMove)
+		{
+			CellScores[Index] = FMath::Max(CellScores[Index], PassScore + Own);
+		}
+
+		for (int32 Slot = 2; Slot < NumSlots; Slot++)
+		{
+			if (Slots[Slot] != NoMove)
+			{
+				const int32 ToIndex = Index + SlotOffsets[Slot - 2][0] * Size + SlotOffsets[Slot - 2][1];
+				CellScores[ToIndex] = FMath::Max(CellScores[ToIndex], PassScore + Slots[Slot]);
+			}
+		}
+	}
+}
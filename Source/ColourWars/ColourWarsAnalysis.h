@@ -0,0 +1,71 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColourWarsBoard.h"
+#include "ColourWarsEval.h"
+
+/**
+ * Scores every legal move of the player to move, for the analysis overlay.
+ *
+ * Each move is kept as its gain over passing the turn, which only depends on the cells near it, so after a turn
+ * only the moves near the cells that changed are evaluated again. Those are spread over worker threads.
+ */
+class COLOURWARS_API FColourWarsAnalysis
+{
+public:
+	/** Score of a cell no move ends on */
+	static const float NoMove;
+
+	explicit FColourWarsAnalysis(const FColourWarsEvalWeights& InWeights = FColourWarsEvalWeights::GetDefault());
+
+	/** Forget every score, the next update evaluates every move */
+	void Reset();
+
+	/** Note a cell of the board has changed since the last update, call after the board has been written */
+	void MarkCellChanged(const FColourWarsBoard& Board, int32 Index);
+
+	/** Evaluate the moves of the current player that changed cells may have altered and work out the cell scores */
+	void Update(const FColourWarsBoard& Board);
+
+	/**
+	 * Evaluation for the current player after the best move ending on each cell, or NoMove: AddOne and Combine
+	 * end on their block and Move on the block it takes or joins.
+	 */
+	const TArray<float>& GetCellScores() const { return CellScores; }
+
+	/** Number of moves the last update evaluated */
+	int32 GetNumEvaluated() const { return NumEvaluated; }
+
+private:
+	/** Moves kept for each block: AddOne, Combine and a Move to each vertical and horizontal neighbour */
+	static const int32 NumSlots = 6;
+
+	FColourWarsEval Eval;
+
+	/** Board size and player count the scores are for, 0 when they have been reset */
+	int32 Size;
+
+	int32 NumberOfPlayers;
+
+	/** Gain of each move over passing, NumSlots for each cell, per player */
+	TArray<float> Gains[5];
+
+	/** Cells whose moves have to be evaluated again on the player's next update */
+	TArray<uint8> Dirty[5];
+
+	/** Bit for each player with blocks left, and each with only one, at the player's last update */
+	uint8 AliveMasks[5];
+	uint8 LastBlockMasks[5];
+
+	TArray<float> CellScores;
+
+	int32 NumEvaluated;
+
+	/** Mark every cell within Radius of the cell as dirty for every player */
+	void MarkSquare(int32 Index, int32 Radius);
+
+	/** The move of a slot of a block, Invalid if the slot has no legal move */
+	FColourWarsMove GetSlotMove(const FColourWarsBoard& Board, int32 Index, int32 Slot) const;
+};
@@ -0,0 +1,439 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsBatch.h"
+#include "Math/RandomStream.h"
+
+FColourWarsBatch::FColourWarsBatch()
+	: NumGames(0)
+	, Size(0)
+	, NumberOfPlayers(2)
+	, Stride(2)
+	, NumPaddedCells(4)
+{
+	FMemory::Memzero(CostMultipliers);
+	FMemory::Memzero(NeighbourOffsets);
+}
+
+/// <summary>
+/// Set up a batch of new games. The cost table holds FColourWarsBoard::AttackingCost as a multiplier, so taking
+/// a block is a single lookup rather than a switch on its colour.
+/// </summary>
+void FColourWarsBatch::Init(int32 InNumGames, int32 InSize, int32 InNumberOfPlayers)
+{
+	NumGames = InNumGames;
+	Size = InSize;
+	NumberOfPlayers = InNumberOfPlayers;
+	Stride = Size + 2;
+	NumPaddedCells = Stride * Stride;
+
+	for (int32& Multiplier : CostMultipliers)
+	{
+		Multiplier = 1;
+	}
+
+	if (NumberOfPlayers != 2)
+	{
+		// Each colour is weak against the next one round
+		const int32 Red = static_cast<int32>(eBlockType::Red);
+		const int32 Green = static_cast<int32>(eBlockType::Green);
+		const int32 Blue = static_cast<int32>(eBlockType::Blue);
+		const int32 Purple = static_cast<int32>(eBlockType::Purple);
+
+		CostMultipliers[Green * NumBlockTypes + Red] = 2;
+		CostMultipliers[Blue * NumBlockTypes + Green] = 2;
+
+		if (NumberOfPlayers == 3)
+		{
+			CostMultipliers[Red * NumBlockTypes + Blue] = 2;
+			for (int32 Attacking = 0; Attacking < NumBlockTypes; Attacking++)
+			{
+				CostMultipliers[Attacking * NumBlockTypes + Purple] = 0;
+			}
+		}
+		else
+		{
+			CostMultipliers[Purple * NumBlockTypes + Blue] = 2;
+			CostMultipliers[Red * NumBlockTypes + Purple] = 2;
+		}
+	}
+
+	const int32 Offsets[8] = { -Stride, Stride, -1, 1, -Stride - 1, Stride + 1, Stride - 1, -Stride + 1 };
+	FMemory::Memcpy(NeighbourOffsets, Offsets, sizeof(Offsets));
+
+	Scores.SetNumUninitialized(NumGames * NumPaddedCells);
+	BlockTypes.SetNumUninitialized(NumGames * NumPaddedCells);
+	Capitals.SetNumUninitialized(NumGames * NumPaddedCells);
+	BlockCounts.SetNumUninitialized(NumGames * NumBlockTypes);
+	Turns.SetNumUninitialized(NumGames);
+	CurrentPlayers.SetNumUninitialized(NumGames);
+	GameOvers.SetNumUninitialized(NumGames);
+	MoveTypes.SetNumUninitialized(NumGames);
+	MoveFroms.SetNumUninitialized(NumGames);
+	MoveTos.SetNumUninitialized(NumGames);
+
+	for (int32 Game = 0; Game < NumGames; Game++)
+	{
+		ResetGame(Game);
+	}
+}
+
+/// <summary>
+/// Put a game back to the starting board, with the same capital blocks as FColourWarsBoard::SetCapitalBlocks
+/// </summary>
+void FColourWarsBatch::ResetGame(int32 Game)
+{
+	const int32 Base = Game * NumPaddedCells;
+	for (int32 Index = 0; Index < NumPaddedCells; Index++)
+	{
+		const int32 X = Index / Stride;
+		const int32 Y = Index % Stride;
+		const bool bBorder = X == 0 || Y == 0 || X == Stride - 1 || Y == Stride - 1;
+
+		Scores[Base + Index] = 0;
+		BlockTypes[Base + Index] = bBorder ? BorderType : static_cast<uint8>(eBlockType::None);
+		Capitals[Base + Index] = 0;
+	}
+
+	int32* Counts = BlockCounts.GetData() + Game * NumBlockTypes;
+	FMemory::Memzero(Counts, NumBlockTypes * sizeof(int32));
+
+	const IntVector StartingPositions[] =
+	{
+		IntVector(0, 0),
+		IntVector(Size - 1, Size - 1),
+		IntVector(0, Size - 1),
+		IntVector(Size - 1, 0)
+	};
+
+	for (int32 PlayerIndex = 1; PlayerIndex < NumberOfPlayers + 1; PlayerIndex++)
+	{
+		const int32 Index = Base + ToPaddedIndex(StartingPositions[PlayerIndex - 1]);
+		Scores[Index] = PlayerIndex;
+		BlockTypes[Index] = PlayerIndex;
+		Capitals[Index] = 1;
+		Counts[PlayerIndex]++;
+	}
+
+	Turns[Game] = 0;
+	CurrentPlayers[Game] = static_cast<uint8>(eBlockType::Red);
+	GameOvers[Game] = 0;
+	MoveTypes[Game] = static_cast<uint8>(eMoveType::Invalid);
+	MoveFroms[Game] = 0;
+	MoveTos[Game] = 0;
+}
+
+void FColourWarsBatch::SetMove(int32 Game, const FColourWarsMove& Move)
+{
+	const bool bValidFrom = Move.From.X >= 0 && Move.From.Y >= 0 && Move.From.X < Size && Move.From.Y < Size;
+	const bool bValidTo = Move.To.X >= 0 && Move.To.Y >= 0 && Move.To.X < Size && Move.To.Y < Size;
+
+	// Moves off the board would index into the next game, so they are passed instead
+	const bool bOnBoard = bValidFrom && (bValidTo || Move.MoveType != eMoveType::Move);
+
+	MoveTypes[Game] = static_cast<uint8>(bOnBoard ? Move.MoveType : eMoveType::Invalid);
+	MoveFroms[Game] = bValidFrom ? ToPaddedIndex(Move.From) : 0;
+	MoveTos[Game] = bValidTo ? ToPaddedIndex(Move.To) : 0;
+}
+
+void FColourWarsBatch::ChooseRandomMoves(FRandomStream& Random)
+{
+	const int32 Directions[4] = { -Stride, Stride, -1, 1 };
+
+	for (int32 Game = 0; Game < NumGames; Game++)
+	{
+		MoveTypes[Game] = static_cast<uint8>(eMoveType::Invalid);
+
+		const uint8 Player = CurrentPlayers[Game];
+		const int32 NumBlocks = BlockCounts[Game * NumBlockTypes + Player];
+		if (GameOvers[Game] != 0 || NumBlocks == 0)
+		{
+			continue;
+		}
+
+		// The block counts are kept up to date, so one pass finds the n-th block of the player
+		const int32 Base = Game * NumPaddedCells;
+		int32 Remaining = Random.RandHelper(NumBlocks);
+		int32 From = 0;
+		for (int32 Index = 0; Index < NumPaddedCells; Index++)
+		{
+			if (BlockTypes[Base + Index] == Player && Remaining-- == 0)
+			{
+				From = Index;
+				break;
+			}
+		}
+
+		eMoveType MoveType = static_cast<eMoveType>(Random.RandRange(static_cast<int32>(eMoveType::Move), static_cast<int32>(eMoveType::AddOne)));
+		int32 To = From;
+
+		if (MoveType == eMoveType::Move)
+		{
+			To = From + Directions[Random.RandHelper(4)];
+
+			if (!CanMoveOnto(Game, From, To))
+			{
+				MoveType = eMoveType::AddOne;
+				To = From;
+			}
+		}
+
+		MoveTypes[Game] = static_cast<uint8>(MoveType);
+		MoveFroms[Game] = From;
+		MoveTos[Game] = To;
+	}
+}
+
+bool FColourWarsBatch::CanMoveOnto(int32 Game, int32 Starting, int32 Ending) const
+{
+	const int32 Base = Game * NumPaddedCells;
+	const uint8 StartingType = BlockTypes[Base + Starting];
+	const uint8 EndingType = BlockTypes[Base + Ending];
+
+	return EndingType == StartingType || (EndingType != BorderType
+		&& Scores[Base + Starting] > Scores[Base + Ending] * CostMultipliers[StartingType * NumBlockTypes + EndingType]);
+}
+
+FColourWarsMove FColourWarsBatch::GetMove(int32 Game) const
+{
+	return FColourWarsMove(static_cast<eMoveType>(MoveTypes[Game]), ToCoord(MoveFroms[Game]), ToCoord(MoveTos[Game]));
+}
+
+int32 FColourWarsBatch::GetNumLegalMoves(int32 Game) const
+{
+	const int32 Base = Game * NumPaddedCells;
+	const uint8 Player = CurrentPlayers[Game];
+	int32 NumMoves = 0;
+
+	for (int32 Index = Stride; Index < NumPaddedCells - Stride; Index++)
+	{
+		if (BlockTypes[Base + Index] != Player)
+		{
+			continue;
+		}
+
+		// AddOne and Combine, then a Move onto each neighbour it can move onto
+		NumMoves += 2
+			+ CanMoveOnto(Game, Index, Index - Stride) + CanMoveOnto(Game, Index, Index + Stride)
+			+ CanMoveOnto(Game, Index, Index - 1) + CanMoveOnto(Game, Index, Index + 1);
+	}
+
+	return NumMoves;
+}
+
+void FColourWarsBatch::GetCells(int32 Game, int32* OutScores, uint8* OutCells) const
+{
+	for (int32 X = 0; X < Size; X++)
+	{
+		const int32 Row = Game * NumPaddedCells + ToPaddedIndex(X, 0);
+		FMemory::Memcpy(OutScores + X * Size, Scores.GetData() + Row, Size * sizeof(int32));
+
+		for (int32 Y = 0; Y < Size; Y++)
+		{
+			OutCells[X * Size + Y] = BlockTypes[Row + Y] | (Capitals[Row + Y] << 7);
+		}
+	}
+}
+
+/// <summary>
+/// Play a turn of every game that is not over. Games are first listed by move type, so each kernel is one
+/// tight loop with no switch on the move, then the end of turn steps run over every game still playing.
+/// </summary>
+void FColourWarsBatch::Step()
+{
+	AddOneGames.Reset();
+	MoveGames.Reset();
+	CombineGames.Reset();
+
+	for (int32 Game = 0; Game < NumGames; Game++)
+	{
+		if (GameOvers[Game] != 0)
+		{
+			continue;
+		}
+
+		switch (static_cast<eMoveType>(MoveTypes[Game]))
+		{
+		case eMoveType::AddOne:
+			AddOneGames.Add(Game);
+			break;
+		case eMoveType::Move:
+			MoveGames.Add(Game);
+			break;
+		case eMoveType::Combine:
+			CombineGames.Add(Game);
+			break;
+		default:
+			break;
+		}
+	}
+
+	StepAddOne();
+	StepMove();
+	StepCombine();
+	StepEndOfTurn();
+
+	// Games that are not given a move next time pass
+	FMemory::Memset(MoveTypes.GetData(), static_cast<uint8>(eMoveType::Invalid), NumGames);
+}
+
+void FColourWarsBatch::StepAddOne()
+{
+	int32* RESTRICT ScoreData = Scores.GetData();
+	const int32* RESTRICT FromData = MoveFroms.GetData();
+
+	for (int32 Game : AddOneGames)
+	{
+		ScoreData[Game * NumPaddedCells + FromData[Game]] += 1;
+	}
+}
+
+/// <summary>
+/// FColourWarsBoard::MoveBlock with every branch turned into a select. Whether the ending block is taken or
+/// joined only changes which values are written, and the square bonus of a taken block is masked by it.
+/// </summary>
+void FColourWarsBatch::StepMove()
+{
+	int32* RESTRICT ScoreData = Scores.GetData();
+	uint8* RESTRICT TypeData = BlockTypes.GetData();
+	uint8* RESTRICT CapitalData = Capitals.GetData();
+	int32* RESTRICT CountData = BlockCounts.GetData();
+
+	// The three other cells of each 2x2 square around a cell, as in FColourWarsBoard::BonusCheck
+	const int32 Squares[4][3] =
+	{
+		{ Stride, 1, Stride + 1 },
+		{ -Stride, 1, -Stride + 1 },
+		{ -Stride, -1, -Stride - 1 },
+		{ Stride, -1, Stride - 1 }
+	};
+
+	for (int32 Game : MoveGames)
+	{
+		const int32 Base = Game * NumPaddedCells;
+		const int32 Starting = Base + MoveFroms[Game];
+		const int32 Ending = Base + MoveTos[Game];
+		const uint8 StartingType = TypeData[Starting];
+		const uint8 EndingType = TypeData[Ending];
+		const int32 bTaken = StartingType != EndingType ? 1 : 0;
+
+		const int32 Cost = ScoreData[Ending] * CostMultipliers[StartingType * NumBlockTypes + EndingType];
+		ScoreData[Ending] = bTaken ? ScoreData[Starting] - Cost : ScoreData[Ending] + ScoreData[Starting];
+		ScoreData[Starting] = 1;
+		TypeData[Ending] = StartingType;
+
+		// A taken block loses its capital status, and the capital moves with the starting block
+		CapitalData[Ending] = (CapitalData[Ending] & (1 - bTaken)) | CapitalData[Starting];
+		CapitalData[Starting] = 0;
+
+		int32* Counts = CountData + Game * NumBlockTypes;
+		Counts[EndingType] -= bTaken;
+		Counts[StartingType] += bTaken;
+
+		for (const int32 (&Square)[3] : Squares)
+		{
+			const int32 Bonus = bTaken
+				& (TypeData[Ending + Square[0]] == StartingType)
+				& (TypeData[Ending + Square[1]] == StartingType)
+				& (TypeData[Ending + Square[2]] == StartingType);
+
+			ScoreData[Ending + Square[0]] += Bonus;
+			ScoreData[Ending + Square[1]] += Bonus;
+			ScoreData[Ending + Square[2]] += Bonus;
+			ScoreData[Ending] += Bonus;
+		}
+	}
+}
+
+/// <summary>
+/// FColourWarsBoard::CombineNeighbourBlocks over a fixed 3x3 window, the border never matches the centre's type
+/// </summary>
+void FColourWarsBatch::StepCombine()
+{
+	int32* RESTRICT ScoreData = Scores.GetData();
+	const uint8* RESTRICT TypeData = BlockTypes.GetData();
+
+	for (int32 Game : CombineGames)
+	{
+		const int32 Central = Game * NumPaddedCells + MoveFroms[Game];
+		const uint8 CentralType = TypeData[Central];
+		int32 ScoreSum = ScoreData[Central];
+
+		for (int32 Offset : NeighbourOffsets)
+		{
+			const int32 Neighbour = Central + Offset;
+			const int32 bSameType = TypeData[Neighbour] == CentralType ? 1 : 0;
+			const int32 Score = ScoreData[Neighbour];
+
+			ScoreSum += bSameType * (Score - 1);
+			ScoreData[Neighbour] = bSameType ? FMath::Min(Score, 1) : Score;
+		}
+
+		ScoreData[Central] = ScoreSum;
+	}
+}
+
+/// <summary>
+/// The capital bonus is a 4 neighbour stencil over each whole padded board: a cell of the current player gets 1
+/// for each neighbouring capital of that player. Border cells never match, so rows need no special casing.
+/// Switching player then only reads the block counts.
+/// </summary>
+void FColourWarsBatch::StepEndOfTurn()
+{
+	int32* RESTRICT ScoreData = Scores.GetData();
+	const uint8* RESTRICT TypeData = BlockTypes.GetData();
+	const uint8* RESTRICT CapitalData = Capitals.GetData();
+
+	for (int32 Game = 0; Game < NumGames; Game++)
+	{
+		if (GameOvers[Game] != 0)
+		{
+			continue;
+		}
+
+		const uint8 Player = CurrentPlayers[Game];
+		const int32 Base = Game * NumPaddedCells;
+
+		for (int32 Index = Base + Stride; Index < Base + NumPaddedCells - Stride; Index++)
+		{
+			const int32 NeighbourCapitals =
+				(CapitalData[Index - Stride] & (TypeData[Index - Stride] == Player)) +
+				(CapitalData[Index + Stride] & (TypeData[Index + Stride] == Player)) +
+				(CapitalData[Index - 1] & (TypeData[Index - 1] == Player)) +
+				(CapitalData[Index + 1] & (TypeData[Index + 1] == Player));
+
+			ScoreData[Index] += (TypeData[Index] == Player) * NeighbourCapitals;
+		}
+
+		const int32* Counts = BlockCounts.GetData() + Game * NumBlockTypes;
+		int32 PlayerInt = Player;
+		for (int32 Attempt = 0; Attempt < NumberOfPlayers; Attempt++)
+		{
+			PlayerInt = PlayerInt % NumberOfPlayers + 1;
+			if (Counts[PlayerInt] > 0)
+			{
+				break;
+			}
+		}
+
+		CurrentPlayers[Game] = static_cast<uint8>(PlayerInt);
+		Turns[Game]++;
+		GameOvers[Game] = PlayerInt == Player ? 1 : 0;
+	}
+}
+
+void FColourWarsBatch::CopyGameTo(int32 Game, FColourWarsBoard& OutBoard) const
+{
+	OutBoard.Init(Size, NumberOfPlayers);
+
+	const int32 Base = Game * NumPaddedCells;
+	for (int32 X = 0; X < Size; X++)
+	{
+		for (int32 Y = 0; Y < Size; Y++)
+		{
+			const int32 Index = Base + ToPaddedIndex(X, Y);
+			OutBoard.SetCell(OutBoard.ToIndex(X, Y), static_cast<eBlockType>(BlockTypes[Index]), Scores[Index], Capitals[Index] != 0);
+		}
+	}
+
+	OutBoard.SetTurnFlow(GetCurrentPlayer(Game), Turns[Game], IsGameOver(Game));
+}
@@ -0,0 +1,134 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColourWarsBoard.h"
+
+struct FRandomStream;
+
+/**
+ * Many independent games of the same size and number of players, stepped together one turn at a time.
+ *
+ * Every field is one contiguous array over the whole batch, game-major, so each game's cells are next to
+ * each other. Boards are stored with a one cell border of BorderType, which no neighbour test ever
+ * matches, so the move kernels read fixed 3x3 windows with no bounds checks. Step sorts the games by move
+ * type and runs one branch-free loop per type over just those games. The rules are the same as
+ * FColourWarsBoard::ApplyTurn, only without the hash and turn deltas.
+ */
+class COLOURWARS_API FColourWarsBatch
+{
+public:
+	/** Block type of the border cells around each board */
+	static const uint8 BorderType = 0xFF;
+
+	FColourWarsBatch();
+
+	/** Set up a batch of new games */
+	void Init(int32 InNumGames, int32 InSize, int32 InNumberOfPlayers);
+
+	/** Put a game back to the starting board */
+	void ResetGame(int32 Game);
+
+	int32 GetNumGames() const { return NumGames; }
+
+	int32 GetSize() const { return Size; }
+
+	int32 GetNumberOfPlayers() const { return NumberOfPlayers; }
+
+	int32 GetTurn(int32 Game) const { return Turns[Game]; }
+
+	eBlockType GetCurrentPlayer(int32 Game) const { return static_cast<eBlockType>(CurrentPlayers[Game]); }
+
+	bool IsGameOver(int32 Game) const { return GameOvers[Game] != 0; }
+
+	/** Number of cells a player owns in a game */
+	int32 GetNumBlocks(int32 Game, eBlockType BlockType) const { return BlockCounts[Game * NumBlockTypes + static_cast<int32>(BlockType)]; }
+
+	/** Set the move a game plays on the next Step, the move is not checked and games without one pass */
+	void SetMove(int32 Game, const FColourWarsMove& Move);
+
+	/**
+	 * Set a random move for every game that is not over: a random block of the current player and a random
+	 * move type, with a Move onto a random neighbour that falls back to AddOne when it is not legal.
+	 * Cheaper than picking from every legal move, and good enough for playouts.
+	 */
+	void ChooseRandomMoves(FRandomStream& Random);
+
+	/** Play a turn of every game that is not over, with the moves that were set */
+	void Step();
+
+	/** Move a game will play on the next Step */
+	FColourWarsMove GetMove(int32 Game) const;
+
+	/** Number of legal moves of the current player of a game, as FColourWarsBoard::GetLegalMoves would find */
+	int32 GetNumLegalMoves(int32 Game) const;
+
+	/** Copy a game's cells in board order, with the capital flag in the top bit of each type as in FColourWarsBoard::Serialize */
+	void GetCells(int32 Game, int32* OutScores, uint8* OutCells) const;
+
+	/** Copy a game onto a board, to look at it or carry on playing it with the full rules */
+	void CopyGameTo(int32 Game, FColourWarsBoard& OutBoard) const;
+
+private:
+	/** eBlockType::None to eBlockType::Purple */
+	static const int32 NumBlockTypes = 5;
+
+	/** Index of a grid coordinate within one game's padded cells */
+	int32 ToPaddedIndex(int32 X, int32 Y) const { return (X + 1) * Stride + Y + 1; }
+	int32 ToPaddedIndex(IntVector GridCoord) const { return ToPaddedIndex(GridCoord.X, GridCoord.Y); }
+
+	IntVector ToCoord(int32 PaddedIndex) const { return IntVector(PaddedIndex / Stride - 1, PaddedIndex % Stride - 1); }
+
+	/** Can the block on the starting padded cell take the ending one, or join it as the same type */
+	bool CanMoveOnto(int32 Game, int32 Starting, int32 Ending) const;
+
+	/** Move type kernels, over the games listed for that move type */
+	void StepAddOne();
+	void StepMove();
+	void StepCombine();
+
+	/** Capital bonus for the current player and switching to the next one, for every game still playing */
+	void StepEndOfTurn();
+
+	int32 NumGames;
+
+	int32 Size;
+
+	int32 NumberOfPlayers;
+
+	/** Padded cells along a side, Size + 2 */
+	int32 Stride;
+
+	/** Padded cells of one game */
+	int32 NumPaddedCells;
+
+	/** Multiplier of the defender's score that taking it costs, indexed by attacking type * NumBlockTypes + defending type */
+	int32 CostMultipliers[NumBlockTypes * NumBlockTypes];
+
+	/** Offsets of the 8 neighbours of a padded cell */
+	int32 NeighbourOffsets[8];
+
+	/** Score, eBlockType and capital flag of every padded cell, game-major */
+	TArray<int32> Scores;
+	TArray<uint8> BlockTypes;
+	TArray<uint8> Capitals;
+
+	/** Cells of each block type in each game, game-major, kept up to date as cells change hands */
+	TArray<int32> BlockCounts;
+
+	/** Turn flow of each game */
+	TArray<int32> Turns;
+	TArray<uint8> CurrentPlayers;
+	TArray<uint8> GameOvers;
+
+	/** Move of each game for the next Step, From and To as padded cell indices */
+	TArray<uint8> MoveTypes;
+	TArray<int32> MoveFroms;
+	TArray<int32> MoveTos;
+
+	/** Games playing each move type this Step */
+	TArray<int32> AddOneGames;
+	TArray<int32> MoveGames;
+	TArray<int32> CombineGames;
+};
@@ -9,7 +9,6 @@
 #include "Engine/StaticMesh.h"
 #include "Materials/MaterialInstance.h"
 #include "Components/TextRenderComponent.h"
-#include "Components/BoxComponent.h"
 #include "Kismet/GameplayStatics.h"
 
 #define LOCTEXT_NAMESPACE "PuzzleBlockGrid"
@@ -23,6 +22,22 @@ const TMap<eBlockType, FVector> AColourWarsBlock::BlockColours
 	{eBlockType::Purple, FVector( 0.25f , 0    , 1.0f )}
 };
 
+const int32 AColourWarsBlock::FullColourScore = 16;
+
+/// <summary>
+/// Empty cells keep their colour, player blocks run from a quarter of their colour at no score up to all of it
+/// </summary>
+FVector AColourWarsBlock::GetScoreColour(eBlockType Type, int32 BlockScore)
+{
+	if (Type == eBlockType::None)
+	{
+		return BlockColours[Type];
+	}
+
+	const float Brightness = FMath::Clamp(static_cast<float>(BlockScore) / FullColourScore, 0.f, 1.f);
+	return BlockColours[Type] * FMath::Lerp(0.25f, 1.f, Brightness);
+}
+
 AColourWarsBlock::AColourWarsBlock()
 {
 	// Structure to hold one-time initialization
@@ -42,7 +57,10 @@ AColourWarsBlock::AColourWarsBlock()
 
 	// Set defaults
 	Score = 0;
+	bIsSelected = false;
+	bIsSelectable = false;
 	bIsCapitalBlock = false;
+	Detail = eBlockDetail::Text;
 	BlockType = eBlockType::None;
 	BlockMaterial = ConstructorStatics.BlockMaterial.Get();
 	TextMaterial = UMaterialInstanceDynamic::Create(ConstructorStatics.TextMaterial.Get(), NULL);
@@ -63,8 +81,7 @@ AColourWarsBlock::AColourWarsBlock()
 	BlockMesh->SetRelativeScale3D(FVector(1.f,1.f,0.25f));
 	BlockMesh->SetRelativeLocation(FVector(0.f,0.f,25.f));
 	BlockMesh->SetupAttachment(DummyRoot);
-	BlockMesh->OnClicked.AddDynamic(this, &AColourWarsBlock::BlockClicked);
-	BlockMesh->OnInputTouchBegin.AddDynamic(this, &AColourWarsBlock::OnFingerPressedBlock);
+	BlockMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 	BlockMesh->SetMaterial(0, BlockMaterial);
 
 	// Add text static mesh component
@@ -89,12 +106,18 @@ AColourWarsBlock::AColourWarsBlock()
 	CapitalBlockVisual->SetVisibility(false);
 	CapitalBlockVisual->SetupAttachment(DummyRoot);
 
-	// Setup the collision meshes
-	NeighbourCheck_CollisionBox = CreateDefaultSubobject<UBoxComponent>(FName("Neighbour Checker Collision Box"));
-	NeighbourCheck_CollisionBox->SetRelativeLocation(FVector(0.f, 0.f, 0.f));
-	NeighbourCheck_CollisionBox->SetRelativeScale3D(FVector(1.f, 1.f, 1.f));
-	NeighbourCheck_CollisionBox->SetBoxExtent(FVector(200.f, 200.f, 200.f));
-	NeighbourCheck_CollisionBox->SetupAttachment(DummyRoot);
+	// Add the analysis heat pip, hidden until analysis is shown
+	HeatMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("HeatMesh0"));
+	HeatMesh->SetStaticMesh(ConstructorStatics.PlaneMesh.Get());
+	HeatMesh->SetRelativeScale3D(FVector(0.2f, 0.2f, 0.05f));
+	HeatMesh->SetRelativeLocation(FVector(80.f, 80.f, 60.f));
+	HeatMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	HeatMesh->SetVisibility(false);
+	HeatMesh->SetupAttachment(DummyRoot);
+	HeatMesh->SetMaterial(0, BlockMaterial);
+
+	// Blocks take no part in collision, clicks are picked on the board plane by the grid
+	SetActorEnableCollision(false);
 }
 
 /// <summary>
@@ -117,132 +140,6 @@ void AColourWarsBlock::SetBlockType(eBlockType newBlockType)
 	SetBlockColour();
 }
 
-/// <summary>
-/// Perform a click when a mouse click on this block is performed.
-/// </summary>
-/// <param name="ClickedComp"></param>
-/// <param name="ButtonClicked"></param>
-void AColourWarsBlock::BlockClicked(UPrimitiveComponent* ClickedComp, FKey ButtonClicked)
-{
-	HandleClicked();
-}
-
-/// <summary>
-/// Perform click on this block when a touch input from finger is detected.
-/// </summary>
-/// <param name="FingerIndex"></param>
-/// <param name="TouchedComponent"></param>
-void AColourWarsBlock::OnFingerPressedBlock(ETouchIndex::Type FingerIndex, UPrimitiveComponent* TouchedComponent)
-{
-	if (!GameMode->GetGameState()->GetGameOver())
-	{
-		HandleClicked();
-	}
-}
-
-/// <summary>
-/// Act on the block being clicked.
-/// 
-/// If it has already been selected, then it will deselect.
-/// If another block has been selected then check if this block is a neighbour and if so then combine them, otherwise select this block.
-/// If no other block has been selected then select this block.
-/// </summary>
-void AColourWarsBlock::HandleClicked()
-{
-	// Check if this block can be selected
-	if (!bIsSelectable)
-	{
-		GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, TEXT("This block cannot be selected."));
-		return;
-	}
-
-	GameMode->GetGameState()->ToggleBlockSelection(this);
-}
-
-/// <summary>
-/// Check if this block has created a square of same blocks and if so apply a completion bonus
-/// </summary>
-void AColourWarsBlock::BonusCheck()
-{
-	TSet<AActor*> OverlappingActors;
-
-	// Reset the collision box back to the centre and normal size
-	this->NeighbourCheck_CollisionBox->SetRelativeLocation(FVector(0.f, 0.f, 0.f));
-	this->NeighbourCheck_CollisionBox->SetRelativeScale3D(FVector(1.f, 1.f, 1.f));
-
-	for (int i = 0; i < 4; i++)
-	{
-		// Set the collision box to 1 of the 4 directions
-		switch (i)
-		{
-			case 0:
-				this->NeighbourCheck_CollisionBox->SetRelativeScale3D(FVector(1.f, 1.f, 1.f));
-				this->NeighbourCheck_CollisionBox->SetRelativeLocation(FVector(100.f, 100.f, 0.f));
-			break;
-			case 1:
-				this->NeighbourCheck_CollisionBox->SetRelativeScale3D(FVector(1.f, 1.f, 1.f));
-				this->NeighbourCheck_CollisionBox->SetRelativeLocation(FVector(-100.f, 100.f, 0.f));
-			break;
-			case 2:
-				this->NeighbourCheck_CollisionBox->SetRelativeScale3D(FVector(1.f, 1.f, 1.f));
-				this->NeighbourCheck_CollisionBox->SetRelativeLocation(FVector(-100.f, -100.f, 0.f));
-			break;
-			case 3:
-				this->NeighbourCheck_CollisionBox->SetRelativeScale3D(FVector(1.f, 1.f, 1.f));
-				this->NeighbourCheck_CollisionBox->SetRelativeLocation(FVector(100.f, -100.f, 0.f));
-			break;
-		}
-
-		// Get all actors that the selected block overlaps
-		this->GetOverlappingActors(OverlappingActors);
-
-		int32 blocksFound = 0;
-		bool AllBlocksSame = true;
-		for (AActor * actor : OverlappingActors)
-		{
-			AColourWarsBlock* block = Cast<AColourWarsBlock>(actor);
-			if (block != nullptr)
-			{
-				blocksFound++;
-
-				// Check if this block type is the same as others
-				if (block->BlockType != this->BlockType)
-				{
-					AllBlocksSame = false;
-				}
-			}
-		}
-
-		// Check if exactly 3 blocks were found and all were the same
-		if (AllBlocksSame && blocksFound == 3)
-		{
-			// Add 1 to each block
-			for (AActor* actor : OverlappingActors)
-			{
-				AColourWarsBlock* block = Cast<AColourWarsBlock>(actor);
-				if (block != nullptr)
-				{
-					block->AddScore(1);
-				}
-			}
-
-			// And add 1 to changed block too
-			this->AddScore(1);
-		}
-		else
-		{
-			FString base = "Only found '";
-			base.Append(FString::FromInt(blocksFound));
-			base.Append("' neighbouring blocks of same type.");
-			GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, base);
-		}
-	}
-
-	// Reset the collision box back to the centre and normal size
-	this->NeighbourCheck_CollisionBox->SetRelativeLocation(FVector(0.f, 0.f, 0.f));
-	this->NeighbourCheck_CollisionBox->SetRelativeScale3D(FVector(1.f, 1.f, 1.f));
-}
-
 /// <summary>
 /// Set this block as selected
 /// </summary>
@@ -258,6 +155,16 @@ void AColourWarsBlock::SetBlockDeselected()
 	UpdateBlockOutlineVisibility();
 }
 
+bool AColourWarsBlock::IsBlockSelected()
+{
+	return bIsSelected;
+}
+
+bool AColourWarsBlock::IsBlockSelectable()
+{
+	return bIsSelectable;
+}
+
 /// <summary>
 /// Get the Score of this block
 /// </summary>
@@ -288,8 +195,15 @@ void AColourWarsBlock::SetScore(int32 ScoreToSet)
 	// Add Score
 	Score = ScoreToSet;
 
-	// Update text
-	ScoreText->SetText(FText::Format(LOCTEXT("ScoreFmt", "{0}"), FText::AsNumber(Score)));
+	// Update text, or the colour showing the score when the text is hidden
+	if (Detail == eBlockDetail::Text)
+	{
+		ScoreText->SetText(FText::Format(LOCTEXT("ScoreFmt", "{0}"), FText::AsNumber(Score)));
+	}
+	else
+	{
+		SetBlockColour();
+	}
 }
 
 /// <summary>
@@ -307,7 +221,7 @@ bool AColourWarsBlock::IsCapitalBlock()
 void AColourWarsBlock::SetCapitalBlock()
 {
 	bIsCapitalBlock = true;
-	CapitalBlockVisual->SetVisibility(true);
+	CapitalBlockVisual->SetVisibility(Detail == eBlockDetail::Text);
 }
 
 /// <summary>
@@ -349,22 +263,6 @@ void AColourWarsBlock::SetOwningGrid(AColourWarsBlockGrid* grid)
 	OwningGrid = grid;
 }
 
-/// <summary>
-/// Set the Capital block bonus based on this block as the capital block
-/// </summary>
-void AColourWarsBlock::ApplyCapitalBlockBonus()
-{
-	TArray<AColourWarsBlock*> neighbours = OwningGrid->GetNeighbours(this, false);
-
-	for (int32 blockIndex = 0; blockIndex < neighbours.Num(); blockIndex++)
-	{
-		if (neighbours[blockIndex]->BlockType == this->BlockType)
-		{
-			neighbours[blockIndex]->AddScore(1);
-		}
-	}
-}
-
 /// <summary>
 /// Get the cost that is required for this block to take the defending block
 /// </summary>
@@ -372,66 +270,7 @@ void AColourWarsBlock::ApplyCapitalBlockBonus()
 /// <returns></returns>
 int32 AColourWarsBlock::AttackingCost(AColourWarsBlock* DefendingBlock)
 {
-	if (GameMode->GetNumberOfPlayers() == 2)
-	{
-		return DefendingBlock->Score;
-	}
-	else if (GameMode->GetNumberOfPlayers() == 3)
-	{
-		switch (DefendingBlock->BlockType)
-		{
-		case eBlockType::Red:
-			if (this->BlockType == eBlockType::Green)
-			{
-				return DefendingBlock->Score * 2;
-			}
-			return DefendingBlock->Score;
-		case eBlockType::Green:
-			if (this->BlockType == eBlockType::Blue)
-			{
-				return DefendingBlock->Score * 2;
-			}
-			return DefendingBlock->Score;
-		case eBlockType::Blue:
-			if (this->BlockType == eBlockType::Red)
-			{
-				return DefendingBlock->Score * 2;
-			}
-			return DefendingBlock->Score;
-		}
-	}
-	else if (GameMode->GetNumberOfPlayers() == 4)
-	{
-		switch (DefendingBlock->BlockType)
-		{
-		case eBlockType::Red:
-			if (this->BlockType == eBlockType::Green)
-			{
-				return DefendingBlock->Score * 2;
-			}
-			return DefendingBlock->Score;
-		case eBlockType::Green:
-			if (this->BlockType == eBlockType::Blue)
-			{
-				return DefendingBlock->Score * 2;
-			}
-			return DefendingBlock->Score;
-		case eBlockType::Blue:
-			if (this->BlockType == eBlockType::Purple)
-			{
-				return DefendingBlock->Score * 2;
-			}
-			return DefendingBlock->Score;
-		case eBlockType::Purple:
-			if (this->BlockType == eBlockType::Red)
-			{
-				return DefendingBlock->Score * 2;
-			}
-			return DefendingBlock->Score;
-		}
-	}
-
-	return false;
+	return OwningGrid->GetBoard().AttackingCost(OwningGrid->ToGridIndex(GridCoord), OwningGrid->ToGridIndex(DefendingBlock->GridCoord));
 }
 
 void AColourWarsBlock::SetBlockSelectable(bool Selectable)
@@ -454,7 +293,42 @@ void AColourWarsBlock::SetBlockSelectable(bool Selectable)
 
 void AColourWarsBlock::SetBlockColour()
 {
-	BlockMesh->SetVectorParameterValueOnMaterials("Colour", BlockColours[BlockType]);
+	BlockMesh->SetVectorParameterValueOnMaterials("Colour", Detail == eBlockDetail::Text ? BlockColours[BlockType] : GetScoreColour(BlockType, Score));
+}
+
+/// <summary>
+/// Hidden text is not updated at all, so it is set again from the score when it is shown
+/// </summary>
+void AColourWarsBlock::SetDetail(eBlockDetail NewDetail)
+{
+	if (NewDetail == Detail)
+	{
+		return;
+	}
+
+	Detail = NewDetail;
+
+	const bool bShowText = Detail == eBlockDetail::Text;
+	ScoreText->SetVisibility(bShowText);
+	CapitalBlockVisual->SetVisibility(bShowText && bIsCapitalBlock);
+	if (bShowText)
+	{
+		SetBlockScoreText(Score);
+	}
+
+	SetBlockColour();
+}
+
+/// <summary>
+/// Show the analysis heat of this block, blue for the worst move on the board through to red for the best
+/// </summary>
+void AColourWarsBlock::SetHeat(float Heat)
+{
+	HeatMesh->SetVisibility(Heat >= 0.f);
+	if (Heat >= 0.f)
+	{
+		HeatMesh->SetVectorParameterValueOnMaterials("Colour", FMath::Lerp(FVector(0.f, 0.f, 1.f), FVector(1.f, 0.f, 0.f), FMath::Min(Heat, 1.f)));
+	}
 }
 
 void AColourWarsBlock::SetBlockTextColour(FVector colour)
@@ -479,6 +353,11 @@ void AColourWarsBlock::SetBlockTextWhite()
 
 void AColourWarsBlock::SetBlockScoreText(int32 score)
 {
+	if (Detail != eBlockDetail::Text)
+	{
+		return;
+	}
+
 	ScoreText->SetText(FText::Format(LOCTEXT("ScoreFmt", "{0}"), FText::AsNumber(score)));
 
 	if (score > Score)
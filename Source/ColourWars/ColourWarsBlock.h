@@ -36,7 +36,16 @@ enum class eMoveType : uint8
 	AddOne      UMETA(DisplayName = "AddOne")
 };
 
-/** A block that can be clicked */
+// How much of a block is drawn, from the full block down to none of it as cells get smaller on screen
+UENUM(BlueprintType)
+enum class eBlockDetail : uint8
+{
+	Text         UMETA(DisplayName = "Text"),
+	Colour       UMETA(DisplayName = "Colour"),
+	BoardTexture UMETA(DisplayName = "Board Texture")
+};
+
+/** A block that can be clicked, the grid works out which block a click is on from where it meets the board */
 UCLASS(minimalapi)
 class AColourWarsBlock : public AActor
 {
@@ -47,7 +56,7 @@ private:
 	UPROPERTY(Category = Block, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	class USceneComponent* DummyRoot;
 
-	/** StaticMesh component for the clickable block */
+	/** StaticMesh component for the block, it has no collision */
 	UPROPERTY(Category = Block, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	class UStaticMeshComponent* BlockMesh;
 
@@ -59,8 +68,9 @@ private:
 	UPROPERTY(Category = Grid, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 		class UTextRenderComponent* CapitalBlockVisual;
 
-	UPROPERTY(Category = Grid, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-		class UBoxComponent* NeighbourCheck_CollisionBox;
+	/** Pip in the corner of the block showing how good the best move onto it is, while analysis is shown */
+	UPROPERTY(Category = Block, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+		class UStaticMeshComponent* HeatMesh;
 
 	AColourWarsBlock();
 
@@ -77,6 +87,9 @@ private:
 	
 	/** Score of this block */
 	int32 Score;
+
+	/** How much of the block is drawn, the text is only kept up to date while it is shown */
+	eBlockDetail Detail;
 	
 	/** Grid coordinate of this block */
 	IntVector GridCoord;
@@ -104,16 +117,6 @@ private:
 	UPROPERTY()
 		class UMaterialInstanceDynamic* TextMaterial;
 
-	/** Handle the block being clicked */
-	UFUNCTION()
-	void BlockClicked(UPrimitiveComponent* ClickedComp, FKey ButtonClicked);
-
-	/** Handle the block being touched  */
-	UFUNCTION()
-	void OnFingerPressedBlock(ETouchIndex::Type FingerIndex, UPrimitiveComponent* TouchedComponent);
-	
-	void HandleClicked();
-
 	/** Array of all blocks in grid */
 	TArray<AColourWarsBlock*> NeighbouringBlocks;
 
@@ -135,12 +138,25 @@ public:
 
 	const static TMap<eBlockType, FVector> BlockColours;
 
+	/** Score at and above which a block shown by colour alone is at full brightness */
+	const static int32 FullColourScore;
+
+	/** Colour of a block shown by colour alone, darker for lower scores */
+	static FVector GetScoreColour(eBlockType Type, int32 BlockScore);
+
+	/** Show the score as text, or as the brightness of the block with no text at all */
+	void SetDetail(eBlockDetail NewDetail);
+
 	/** Set this block as selected */
 	void SetBlockSelected();
 
 	/** Set this block as deselected */
 	void SetBlockDeselected();
 
+	bool IsBlockSelected();
+
+	bool IsBlockSelectable();
+
 	int32 GetScore();
 
 	void AddScore(int32 ScoreToAdd);
@@ -169,14 +185,13 @@ public:
 
 	void SetOwningGrid(AColourWarsBlockGrid* grid);
 
-	void ApplyCapitalBlockBonus();
-
-	void BonusCheck();
-
 	int32 AttackingCost(AColourWarsBlock* DefendingBlock);
 
 	void SetBlockSelectable(bool Selectable);
 
+	/** Show the analysis heat of this block from 0 (worst) to 1 (best), or hide it when negative */
+	void SetHeat(float Heat);
+
 	/** Returns DummyRoot subobject **/
 	FORCEINLINE class USceneComponent* GetDummyRoot() const { return DummyRoot; }
 	/** Returns BlockMesh subobject **/
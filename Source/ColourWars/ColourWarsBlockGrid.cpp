@@ -4,7 +4,11 @@
 #include "ColourWarsBlock.h"
 #include "ColourWarsPawn.h"
 #include "ColourWarsGameMode.h"
+#include "ColourWarsGameState.h"
+#include "ColourWarsPlayerController.h"
 #include "ColourWarsGameInstance.h"
+#include "ColourWarsSnapshot.h"
+#include "ColourWarsBoardTexture.h"
 #include "IntVector.h"
 #include "Components/TextRenderComponent.h"
 #include "Engine/World.h"
@@ -13,6 +17,12 @@
 
 #define LOCTEXT_NAMESPACE "PuzzleBlockGrid"
 
+namespace
+{
+	/** Height of the tops of the blocks above the grid at a scale of 1, where clicks meet the board */
+	const float BlockTopHeight = 50.f;
+}
+
 AColourWarsBlockGrid::AColourWarsBlockGrid()
 {
 	// Structure to hold one-time initialization
@@ -32,8 +42,12 @@ AColourWarsBlockGrid::AColourWarsBlockGrid()
 	DummyRoot = CreateDefaultSubobject<USceneComponent>(TEXT("Dummy0"));
 	RootComponent = DummyRoot;
 
+	// Blocks are streamed in and out as the view moves
+	PrimaryActorTick.bCanEverTick = true;
+
 	// Set defaults
 	Size = 5;
+	MatchSeed = 0;
 
 	// Create static mesh component
 	ScoreText = CreateDefaultSubobject<UTextRenderComponent>(TEXT("ScoreText0"));
@@ -50,6 +64,10 @@ AColourWarsBlockGrid::AColourWarsBlockGrid()
 	PlayerTurnMesh->SetRelativeLocation(FVector(-911.f, 0.f, 0.f));
 	PlayerTurnMesh->SetupAttachment(DummyRoot);
 	PlayerTurnMesh->SetMaterial(0, ConstructorStatics.BlockMaterial.Get());
+
+	// Create the board texture, hidden until cells are too small to draw as blocks
+	BoardTexture = CreateDefaultSubobject<UColourWarsBoardTexture>(TEXT("BoardTexture0"));
+	BoardTexture->SetupAttachment(DummyRoot);
 }
 
 void AColourWarsBlockGrid::BeginPlay()
@@ -61,68 +79,352 @@ void AColourWarsBlockGrid::BeginPlay()
 
 	// Set the gamemode
 	GameMode = Cast<AColourWarsGameMode>(UGameplayStatics::GetGameMode(GetWorld()));
+
+	// Clients have no game mode, their board is built from the one the server replicates
+	if (GetNetMode() == NM_Client)
+	{
+		GetGameState()->SetGameGrid(this);
+		GetGameState()->OnRep_NetTurnState();
+		return;
+	}
 	
-	// Number of blocks
+	// Resume a saved match if one has been loaded
+	TUniquePtr<FColourWarsSnapshot> Snapshot;
 	GetGameGridSize();
-	const int32 NumBlocks = Size * Size;
-	BlockSpacing = 1500.f / Size; 
-	BlocksScale = 4.f / Size;
+	if (GameInstance != nullptr)
+	{
+		Snapshot = GameInstance->TakeResumeSnapshot();
+	}
+
+	// Number of blocks
+	SetGridSize(Snapshot.IsValid() ? Snapshot->Board.GetSize() : Size);
+
+	if (Snapshot.IsValid())
+	{
+		SpawnSavedGame(*Snapshot);
+	}
+	else
+	{
+		SpawnNewGame();
+	}
+
+	// Show the capital blocks of each player
+	this->SyncBlocks();
+
+	this->UpdateScore();
+
+	// Set the game grid as this newly created grid
+	GetGameState()->SetGameGrid(this);
+
+	if (IsReplicatingBoard())
+	{
+		GetGameState()->ReplicateBoard();
+	}
+
+	// Set the playerturn mesh to the starting player colour
+	SetPlayerTurnMeshColour();
+
+	if (Snapshot.IsValid())
+	{
+		GameMode->ResumeGame(Snapshot->SelectedMove);
+	}
+	else
+	{
+		GameMode->BeginGame();
+	}
+}
+
+/// <summary>
+/// Set up a new board, its cells are given blocks as they come into view
+/// </summary>
+void AColourWarsBlockGrid::SpawnNewGame()
+{
+	MatchSeed = GameInstance != nullptr && GameInstance->Seed != 0 ? GameInstance->Seed : time(0);
+
+	// Set up the board, which places the capital blocks of each player
+	Board.Init(Size, GameMode->GetNumberOfPlayers());
+
+	bBoardSpawned = true;
+}
+
+/// <summary>
+/// Take the board as it was saved, without any of the randomised set up of a new game
+/// </summary>
+void AColourWarsBlockGrid::SpawnSavedGame(FColourWarsSnapshot& Snapshot)
+{
+	MatchSeed = Snapshot.Seed;
+	Board = MoveTemp(Snapshot.Board);
+
+	bBoardSpawned = true;
+}
+
+/// <summary>
+/// Set up the board from the cells and turn flow the server has replicated so far, later ones are applied as they arrive
+/// </summary>
+void AColourWarsBlockGrid::SpawnNetGame()
+{
+	const FColourWarsNetTurnState& TurnState = GetGameState()->GetNetTurnState();
+
+	SetGridSize(TurnState.Size);
+
+	Board.Init(Size, TurnState.NumberOfPlayers);
+	GetGameState()->GetNetBoard().ApplyTo(Board);
+	Board.SetTurnFlow(TurnState.CurrentPlayer, TurnState.Turn, TurnState.bGameOver);
+
+	bBoardSpawned = true;
+
+	SyncBlocks();
+}
+
+void AColourWarsBlockGrid::SetNetCell(const FColourWarsNetCell& Cell)
+{
+	if (Cell.Index < 0 || Cell.Index >= Board.GetNumCells())
+	{
+		return;
+	}
+
+	Board.SetCell(Cell.Index, static_cast<eBlockType>(Cell.TypeAndCapital & 0x7F), Cell.Score, (Cell.TypeAndCapital & 0x80) != 0);
+
+	if (Analysis.IsValid())
+	{
+		Analysis->MarkCellChanged(Board, Cell.Index);
+	}
+
+	SyncBlock(Cell.Index);
+}
+
+/// <summary>
+/// Boards that fit the view at the smallest spacing are scaled to fill it as before, larger boards spread past the view
+/// </summary>
+void AColourWarsBlockGrid::SetGridSize(int32 InSize)
+{
+	Size = InSize;
+	BlockSpacing = FMath::Max(1500.f / Size, MinBlockSpacing);
+	BlocksScale = BlockSpacing / 375.f;
+
+	// Keep the player turn bar beside the board however far it spreads
+	PlayerTurnMesh->SetRelativeLocation(FVector(-FMath::Max(911.f, Size * BlockSpacing * 0.5f + 161.f), 0.f, 0.f));
+
+	BoardTexture->SetBoardWidth(Size * BlockSpacing);
+
+	if (PlayerPawn != nullptr)
+	{
+		const FVector FirstCell = GetCellLocation(IntVector(0, 0));
+		const FVector LastCell = GetCellLocation(IntVector(Size - 1, Size - 1));
+		PlayerPawn->SetBoardBounds(GetActorLocation().Z, FVector2D(FirstCell), FVector2D(LastCell));
+	}
+}
+
+FVector AColourWarsBlockGrid::GetCellLocation(IntVector GridCoord) const
+{
+	const float HalfSize = ((float)Size - 1.0f) / 2.0f;
+	const float XOffset = (GridCoord.X * BlockSpacing) - (HalfSize * BlockSpacing);
+	const float YOffset = (GridCoord.Y * BlockSpacing) - (HalfSize * BlockSpacing);
+
+	return FVector(XOffset, YOffset, 0.f) + GetActorLocation();
+}
+
+void AColourWarsBlockGrid::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (bBoardSpawned)
+	{
+		UpdateStreaming();
+	}
+
+	if (BlockDetail == eBlockDetail::BoardTexture)
+	{
+		BoardTexture->Flush();
+	}
+}
+
+/// <summary>
+/// Work out the cells under the view with a margin around them, and how much of them to draw for their size on
+/// screen. Only if the cells have changed since the last frame, or blocks given to cells elsewhere are no longer
+/// needed, hand the blocks of cells that have left them to cells that have come into them. Selected blocks keep their
+/// cells, as the selection is held by block. The new blocks are then made selectable or not like the rest. While the
+/// board texture is shown no cells need blocks.
+/// </summary>
+void AColourWarsBlockGrid::UpdateStreaming()
+{
+	FVector2D ViewMin;
+	FVector2D ViewMax;
+	if (PlayerPawn == nullptr || !PlayerPawn->GetBoardView(ViewMin, ViewMax))
+	{
+		return;
+	}
+
+	const FVector Origin = GetActorLocation();
+	const float HalfSize = ((float)Size - 1.0f) / 2.0f;
+	auto ToCell = [&](float World, float OriginWorld)
+	{
+		return FMath::RoundToInt((World - OriginWorld) / BlockSpacing + HalfSize);
+	};
+
+	IntVector Min(ToCell(ViewMin.X, Origin.X) - StreamingMargin, ToCell(ViewMin.Y, Origin.Y) - StreamingMargin);
+	IntVector Max(ToCell(ViewMax.X, Origin.X) + StreamingMargin, ToCell(ViewMax.Y, Origin.Y) + StreamingMargin);
+
+	Min = IntVector(FMath::Max(Min.X, 0), FMath::Max(Min.Y, 0));
+	Max = IntVector(FMath::Min(Max.X, Size - 1), FMath::Min(Max.Y, Size - 1));
+
+	const float PixelsPerCell = BlockSpacing * PlayerPawn->GetPixelsPerUnit();
+	const float Area = static_cast<float>(Max.X - Min.X + 1) * (Max.Y - Min.Y + 1);
+	if (Size >= BoardTextureSize || (PixelsPerCell > 0.f && (PixelsPerCell < ColourDetailPixels || Area > MaxStreamedBlocks)))
+	{
+		SetBlockDetail(eBlockDetail::BoardTexture);
+		Min = IntVector(0, 0);
+		Max = IntVector(-1, -1);
+	}
+	else
+	{
+		SetBlockDetail(PixelsPerCell > 0.f && PixelsPerCell < TextDetailPixels ? eBlockDetail::Colour : eBlockDetail::Text);
+	}
 
-	// Set starting block type
-	int32 BlockTypeInt = 1;
+	// Cells out of view are given blocks while they are selected or next to a selected block
+	const int32 NumInView = FMath::Max(Max.X - Min.X + 1, 0) * FMath::Max(Max.Y - Min.Y + 1, 0);
+	const bool bHasStrayBlocks = Blocks.Num() > NumInView && GetGameState() != nullptr && GetGameState()->NumberBlocksSelected() == 0;
 
-	// Create list to be used to randomly assign block types
-	TArray<eBlockType> BlockTypes;
-	for (int32 BlockIndex = 0; BlockIndex < NumBlocks; BlockIndex++)
+	if (Min.X == StreamedMin.X && Min.Y == StreamedMin.Y && Max.X == StreamedMax.X && Max.Y == StreamedMax.Y && !bHasStrayBlocks)
 	{
-		// Get block type
-		eBlockType BlockType = static_cast<eBlockType>(BlockTypeInt);
-		BlockTypes.Add(BlockType);
+		return;
+	}
 
-		// Increment the block type
-		BlockTypeInt++;
-		if (BlockTypeInt > GameMode->GetNumberOfPlayers())
+	StreamedMin = Min;
+	StreamedMax = Max;
+
+	TArray<AColourWarsBlock*> LeavingBlocks;
+	for (const TPair<int32, AColourWarsBlock*>& Pair : Blocks)
+	{
+		const IntVector GridCoord = Pair.Value->GetGridCoord();
+		const bool bInView = GridCoord.X >= Min.X && GridCoord.X <= Max.X && GridCoord.Y >= Min.Y && GridCoord.Y <= Max.Y;
+		if (!bInView && !Pair.Value->IsBlockSelected())
 		{
-			BlockTypeInt = 1;
+			LeavingBlocks.Add(Pair.Value);
 		}
 	}
 
-	int32 max;
-	srand(time(0));
+	for (AColourWarsBlock* block : LeavingBlocks)
+	{
+		RemoveBlock(block);
+	}
 
-	// Loop to spawn each block
-	for(int32 BlockIndex=0; BlockIndex<NumBlocks; BlockIndex++)
+	if (LeavingBlocks.Num() > 0)
 	{
-		//const float HalfSize = ((float)Size-1.0f)/2.0f;
-		const float Xcoord = BlockIndex/Size; // Divide by dimension
-		const float Ycoord = BlockIndex%Size; // Modulo gives remainder
+		UpdateSelectionTexels();
+	}
 
-		// Get random blocktype
-		max = BlockTypes.Num();
-		int32 RandomIndex = rand() % max;
+	bool bSpawnedBlocks = false;
+	for (int32 X = Min.X; X <= Max.X; X++)
+	{
+		for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+		{
+			if (!Blocks.Contains(ToGridIndex(IntVector(X, Y))))
+			{
+				SpawnNewBlock(IntVector(X, Y));
+				bSpawnedBlocks = true;
+			}
+		}
+	}
 
-		IntVector newGridCoord = IntVector(Xcoord, Ycoord);
+	if (bSpawnedBlocks && GetGameState() != nullptr && GetGameState()->GetGameGrid() == this)
+	{
+		GetGameState()->RefreshGameGrid();
+	}
+}
 
-		// Spawn a block
-		//SpawnNewBlock(BlockTypes[RandomIndex], newGridCoord, 0);
-		SpawnNewBlock(eBlockType::None, newGridCoord, 0);
+/// <summary>
+/// The board texture is kept up to date whether it is shown or not, so it only needs uploading when it is shown
+/// </summary>
+void AColourWarsBlockGrid::SetBlockDetail(eBlockDetail Detail)
+{
+	if (Detail == BlockDetail)
+	{
+		return;
+	}
+
+	BlockDetail = Detail;
 
-		// Remove block type just used
-		BlockTypes.RemoveAt(RandomIndex);
+	// Blocks of selected cells are kept under the board texture, which shows their selection instead
+	const bool bShowTexture = BlockDetail == eBlockDetail::BoardTexture;
+	for (const TPair<int32, AColourWarsBlock*>& Pair : Blocks)
+	{
+		Pair.Value->SetDetail(BlockDetail);
+		Pair.Value->SetActorHiddenInGame(bShowTexture);
 	}
 
-	// Set the capital blocks of each player
-	this->SetCapitalBlocks();
+	BoardTexture->SetVisibility(bShowTexture);
+	if (bShowTexture)
+	{
+		UpdateSelectionTexels();
+		BoardTexture->Flush();
+	}
+}
 
-	this->UpdateScore();
+/// <summary>
+/// Only cells with blocks can be selected or selectable, and while the texture is shown those are only the cells of
+/// a selected move and their neighbours
+/// </summary>
+void AColourWarsBlockGrid::UpdateSelectionTexels()
+{
+	if (BlockDetail != eBlockDetail::BoardTexture)
+	{
+		return;
+	}
 
-	// Set the game grid as this newly created grid
-	GameMode->GetGameState()->SetGameGrid(this);
+	TArray<int32> SelectedCells;
+	TArray<int32> SelectableCells;
+	for (const TPair<int32, AColourWarsBlock*>& Pair : Blocks)
+	{
+		if (Pair.Value->IsBlockSelected())
+		{
+			SelectedCells.Add(Pair.Key);
+		}
+		else if (Pair.Value->IsBlockSelectable())
+		{
+			SelectableCells.Add(Pair.Key);
+		}
+	}
 
-	// Set the playerturn mesh to the starting player colour
-	SetPlayerTurnMeshColour();
+	BoardTexture->SetSelection(Board, SelectedCells, SelectableCells);
+}
 
-	GameMode->BeginGame();
+/// <summary>
+/// Blocks in view are always made selectable or not as the selection changes, a block just given to a cell out of
+/// view has to be before it can be clicked
+/// </summary>
+void AColourWarsBlockGrid::ClickCell(IntVector GridCoord)
+{
+	const bool bHadBlock = Blocks.Contains(ToGridIndex(GridCoord));
+	AColourWarsBlock* block = GetBlock(GridCoord);
+	if (!bHadBlock)
+	{
+		GetGameState()->RefreshGameGrid();
+	}
+
+	if (!block->IsBlockSelectable())
+	{
+		GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, TEXT("This block cannot be selected."));
+		return;
+	}
+
+	GetGameState()->ToggleBlockSelection(block);
+}
+
+bool AColourWarsBlockGrid::IsReplicatingBoard() const
+{
+	return GetNetMode() == NM_ListenServer || GetNetMode() == NM_DedicatedServer;
+}
+
+AColourWarsGameState* AColourWarsBlockGrid::GetGameState()
+{
+	if (GameState == nullptr)
+	{
+		// Set the gamestate
+		GameState = Cast<AColourWarsGameState>(UGameplayStatics::GetGameState(GetWorld()));
+	}
+
+	return GameState;
 }
 
 void AColourWarsBlockGrid::UpdateScore()
@@ -130,203 +432,288 @@ void AColourWarsBlockGrid::UpdateScore()
 	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, TEXT("Updating score."));
 
 	// Calculate the score of each player
-	int32 redScore = 0;
-	int32 greenScore = 0;
-	int32 blueScore = 0;
-	int32 purpleScore = 0;
-	for (int32 BlockIndex = 0; BlockIndex < Blocks.Num(); BlockIndex++)
-	{
-		AColourWarsBlock* block = Blocks[BlockIndex];
-		switch (block->GetBlockType())
-		{
-			case eBlockType::Red:
-				redScore += block->GetScore();
-				break;
-			case eBlockType::Green:
-				greenScore += block->GetScore();
-				break;
-			case eBlockType::Blue:
-				blueScore += block->GetScore();
-				break;
-			case eBlockType::Purple:
-				purpleScore += block->GetScore();
-				break;
-		}
-	}
+	int32 Scores[5];
+	Board.GetPlayerScores(Scores);
+	const int32 redScore = Scores[static_cast<int32>(eBlockType::Red)];
+	const int32 greenScore = Scores[static_cast<int32>(eBlockType::Green)];
+	const int32 blueScore = Scores[static_cast<int32>(eBlockType::Blue)];
+	const int32 purpleScore = Scores[static_cast<int32>(eBlockType::Purple)];
 
 	// Update text
-	if (GameMode->GetNumberOfPlayers() == 2)
+	if (Board.GetNumberOfPlayers() == 2)
 	{
 		ScoreText->SetText(FText::Format(LOCTEXT("ScoreFmt", "Red:{0} Green:{1}"), FText::AsNumber(redScore), FText::AsNumber(greenScore)));
 	}
-	else if (GameMode->GetNumberOfPlayers() == 3)
+	else if (Board.GetNumberOfPlayers() == 3)
 	{
 		ScoreText->SetText(FText::Format(LOCTEXT("ScoreFmt", "Red:{0} Green:{1} Blue:{2}"), FText::AsNumber(redScore), FText::AsNumber(greenScore), FText::AsNumber(blueScore)));
 	}
-	else if (GameMode->GetNumberOfPlayers() == 4)
+	else if (Board.GetNumberOfPlayers() == 4)
 	{
 		ScoreText->SetText(FText::Format(LOCTEXT("ScoreFmt", "Red:{0} Green:{1} Blue:{2} Purple:{3}"), FText::AsNumber(redScore), FText::AsNumber(greenScore), FText::AsNumber(blueScore), FText::AsNumber(purpleScore)));
 	}
+
+	// The scores are updated whenever a turn moves the board on, and so is the analysis of the player to move
+	UpdateAnalysis();
 }
 
-void AColourWarsBlockGrid::SetCapitalBlocks()
+void AColourWarsBlockGrid::SetShowAnalysis(bool bShow)
 {
-	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, TEXT("Setting capital blocks."));
-
-	TArray<IntVector> StartingPositions;
-	StartingPositions.Add(IntVector(0, 0));
-	StartingPositions.Add(IntVector(Size - 1, Size - 1));
-	StartingPositions.Add(IntVector(0, Size - 1));
-	StartingPositions.Add(IntVector(Size - 1, 0));
-
-	// Set capital block for each player
-	for (int32 PlayerIndex = 1; PlayerIndex < GameMode->GetNumberOfPlayers() + 1; PlayerIndex++)
+	if (bShow == IsShowingAnalysis())
 	{
-		//// Get all blocks of this player type
-		//TArray<AColourWarsBlock*> PlayerBlocks;
-		//for (int32 BlockIndex = 0; BlockIndex < Blocks.Num(); BlockIndex++)
-		//{
-		//	AColourWarsBlock* block = Blocks[BlockIndex];
-
-		//	// If block is same as player then add it to the player blocks
-		//	if ((int32)block->BlockType == PlayerIndex)
-		//	{
-		//		PlayerBlocks.Add(block);
-		//	}
-		//}
-
-		// Randomly select a player block to be the capital block
-		//int32 RandomIndex = rand() % PlayerBlocks.Num();
-		//PlayerBlocks[RandomIndex]->SetCapitalBlock();
+		return;
+	}
 
-		Blocks[ToGridIndex(StartingPositions[PlayerIndex - 1])]->SetBlockType(static_cast<eBlockType>(PlayerIndex));
-		Blocks[ToGridIndex(StartingPositions[PlayerIndex - 1])]->SetCapitalBlock();
-		Blocks[ToGridIndex(StartingPositions[PlayerIndex - 1])]->SetScore(PlayerIndex);
+	if (bShow)
+	{
+		Analysis = MakeUnique<FColourWarsAnalysis>();
+		UpdateAnalysis();
+	}
+	else
+	{
+		Analysis.Reset();
+		for (const TPair<int32, AColourWarsBlock*>& Pair : Blocks)
+		{
+			Pair.Value->SetHeat(-1.f);
+		}
 	}
 }
 
 /// <summary>
-/// Apply the bonus for all capital blocks of the currert player block type on the grid
+/// Score the moves on worker threads, then scale the cell scores between the worst and best move on the board
+/// so the heat shows how the moves compare rather than who is winning
 /// </summary>
-void AColourWarsBlockGrid::ApplyCapitalBlocksBonus()
+void AColourWarsBlockGrid::UpdateAnalysis()
 {
-	for (int32 blockIndex = 0; blockIndex < Blocks.Num(); blockIndex++)
+	if (!Analysis.IsValid() || !bBoardSpawned)
+	{
+		return;
+	}
+
+	Analysis->Update(Board);
+
+	const TArray<float>& CellScores = Analysis->GetCellScores();
+	float MinScore = MAX_flt;
+	float MaxScore = -MAX_flt;
+	for (float CellScore : CellScores)
 	{
-		if (Blocks[blockIndex]->IsCapitalBlock() && Blocks[blockIndex]->GetBlockType() == GameMode->GetGameState()->GetCurrentPlayer())
+		if (CellScore != FColourWarsAnalysis::NoMove)
 		{
-			Blocks[blockIndex]->ApplyCapitalBlockBonus();
+			MinScore = FMath::Min(MinScore, CellScore);
+			MaxScore = FMath::Max(MaxScore, CellScore);
 		}
 	}
+
+	AnalysisMinScore = MinScore;
+	AnalysisRange = MaxScore > MinScore ? MaxScore - MinScore : 1.f;
+	for (const TPair<int32, AColourWarsBlock*>& Pair : Blocks)
+	{
+		Pair.Value->SetHeat(GetCellHeat(Pair.Key));
+	}
 }
 
-void AColourWarsBlockGrid::DeselectAllBlocks()
+float AColourWarsBlockGrid::GetCellHeat(int32 Index) const
 {
-	for (AColourWarsBlock* block : Blocks)
+	if (!Analysis.IsValid() || Index >= Analysis->GetCellScores().Num())
 	{
-		GameMode->GetGameState()->DeselectBlock(block);
+		return -1.f;
 	}
+
+	const float CellScore = Analysis->GetCellScores()[Index];
+	return CellScore != FColourWarsAnalysis::NoMove ? (CellScore - AnalysisMinScore) / AnalysisRange : -1.f;
 }
 
-void AColourWarsBlockGrid::SpawnNewBlock(eBlockType BlockType, IntVector GridCoord, int32 startingScore)
+void AColourWarsBlockGrid::SetCapitalBlocks()
 {
-	const float HalfSize = ((float)Size - 1.0f) / 2.0f;
-	const float XOffset = (GridCoord.X * BlockSpacing) - (HalfSize * BlockSpacing); // Divide by dimension
-	const float YOffset = (GridCoord.Y * BlockSpacing) - (HalfSize * BlockSpacing); // Modulo gives remainder
+	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, TEXT("Setting capital blocks."));
 
-	const FVector WorldLocation = FVector(XOffset, YOffset, 0.f) + GetActorLocation();
+	Board.SetCapitalBlocks();
 
-	// Spawn a block
-	AColourWarsBlock* NewBlock = GetWorld()->SpawnActor<AColourWarsBlock>(WorldLocation, FRotator(0, 0, 0));
-	NewBlock->SetGridCoord(GridCoord);
-	NewBlock->SetGridLocation(WorldLocation);
-	NewBlock->SetActorScale3D(FVector(BlocksScale, BlocksScale, BlocksScale));
-	NewBlock->SetScore(startingScore);
+	SyncBlocks();
+}
 
-	// Tell the block about its owner
-	if (NewBlock != nullptr)
+/// <summary>
+/// Update the type, score and capital status of every cell to match the board, which any analysis scores again
+/// </summary>
+void AColourWarsBlockGrid::SyncBlocks()
+{
+	if (Analysis.IsValid())
 	{
-		NewBlock->SetOwningGrid(this);
+		Analysis->Reset();
 	}
 
-	NewBlock->SetBlockType(BlockType);
-
-	// Add the block to the array of blocks
-	Blocks.Add(NewBlock);
+	for (int32 BlockIndex = 0; BlockIndex < Board.GetNumCells(); BlockIndex++)
+	{
+		SyncBlock(BlockIndex);
+	}
 }
 
-void AColourWarsBlockGrid::RemoveBlock(AColourWarsBlock* BlockToRemove)
+/// <summary>
+/// Update only the cells that a turn changed, and send those cells to clients
+/// </summary>
+void AColourWarsBlockGrid::SyncBlocks(const FColourWarsTurnDelta& Delta)
 {
-	Blocks.Remove(BlockToRemove);
+	for (const FColourWarsCellChange& Change : Delta.Cells)
+	{
+		if (Analysis.IsValid())
+		{
+			Analysis->MarkCellChanged(Board, Change.Index);
+		}
+
+		SyncBlock(Change.Index);
+	}
+
+	if (IsReplicatingBoard() && !GetGameState()->IsLockstep())
+	{
+		GetGameState()->ReplicateTurn(Delta);
+	}
 }
 
 /// <summary>
-/// Move the StartingBlock onto the EndingBlock
+/// Tell the threat map, the territory and the board texture about a cell, then update its block if it is in view.
+/// Cells out of view are brought up to date when they are given a block.
 /// </summary>
-/// <param name="StartingBlock"></param>
-/// <param name="EndingBlock"></param>
-/// <returns></returns>
-void AColourWarsBlockGrid::MoveBlock(AColourWarsBlock* StartingBlock, AColourWarsBlock* EndingBlock)
+void AColourWarsBlockGrid::SyncBlock(int32 Index)
 {
-	//// If blocks are not neighbours then don't move the block
-	//if (!AreBlocksNeighbours(StartingBlock, EndingBlock) || !IsValidMove(StartingBlock, EndingBlock))
-	//{
-	//	return;
-	//}
+	ThreatMap.UpdateCell(Board, Index);
+	Territory.UpdateCell(Board, Index);
+	BoardTexture->UpdateCell(Board, Index);
 
-	// If blocks are same type then move score over to ending block
-	if (StartingBlock->GetBlockType() == EndingBlock->GetBlockType())
+	AColourWarsBlock* block = Blocks.FindRef(Index);
+	if (block == nullptr)
 	{
-		EndingBlock->AddScore(StartingBlock->GetScore());
-		StartingBlock->SetScore(0);
+		return;
 	}
-	else
+
+	if (block->GetBlockType() != Board.GetBlockType(Index))
+	{
+		block->SetBlockType(Board.GetBlockType(Index));
+	}
+
+	if (block->GetScore() != Board.GetScore(Index))
 	{
-		int32 const attackingCost = StartingBlock->AttackingCost(EndingBlock);
-		EndingBlock->SetScore(StartingBlock->GetScore() - attackingCost);
-		StartingBlock->SetScore(0);
-		EndingBlock->SetBlockType(StartingBlock->GetBlockType());
-		if (EndingBlock->IsCapitalBlock())
+		block->SetScore(Board.GetScore(Index));
+	}
+
+	if (block->IsCapitalBlock() != Board.IsCapitalBlock(Index))
+	{
+		if (Board.IsCapitalBlock(Index))
 		{
-			EndingBlock->UnsetCapitalBlock();
+			block->SetCapitalBlock();
+		}
+		else
+		{
+			block->UnsetCapitalBlock();
 		}
-		EndingBlock->BonusCheck();
 	}
+}
 
-	// Add a score to the starting block
-	StartingBlock->AddScore(1);
+/// <summary>
+/// Play a full turn on the board, dropping any undone turns as this one replaces them
+/// </summary>
+void AColourWarsBlockGrid::PlayTurn(const FColourWarsMove& Move)
+{
+	TurnHistory.SetNum(HistoryPosition);
+	FColourWarsTurnDelta& Delta = TurnHistory.AddDefaulted_GetRef();
+	HistoryPosition++;
+
+	Board.ApplyTurn(Move, Delta);
+
+	SyncBlocks(Delta);
+}
 
-	// Move capital status if this block is capital block
-	if (StartingBlock->IsCapitalBlock())
+void AColourWarsBlockGrid::UndoTurn()
+{
+	if (!CanUndo())
 	{
-		StartingBlock->UnsetCapitalBlock();
-		EndingBlock->SetCapitalBlock();
+		return;
 	}
+
+	HistoryPosition--;
+	Board.UndoTurn(TurnHistory[HistoryPosition]);
+
+	SyncBlocks(TurnHistory[HistoryPosition]);
+}
+
+void AColourWarsBlockGrid::RedoTurn()
+{
+	if (!CanRedo())
+	{
+		return;
+	}
+
+	Board.RedoTurn(TurnHistory[HistoryPosition]);
+	HistoryPosition++;
+
+	SyncBlocks(TurnHistory[HistoryPosition - 1]);
 }
 
 /// <summary>
-/// Increase the score of this block based by 1
+/// Only the selected blocks need deselecting, and deselecting can give neighbouring cells blocks
 /// </summary>
-void AColourWarsBlockGrid::AddOneToBlock(AColourWarsBlock* block)
+void AColourWarsBlockGrid::DeselectAllBlocks()
 {
-	// Add 1 score as part of this move
-	block->AddScore(1);
+	for (AColourWarsBlock* block : GetGameState()->GetSelectedBlocks())
+	{
+		GetGameState()->DeselectBlock(block);
+	}
 }
 
 /// <summary>
-/// Combine all of the scores of neighbour blocks into this block
+/// Take a block streamed out of view, or spawn one if there are none, and set it up to show the cell as the board has it
 /// </summary>
-void AColourWarsBlockGrid::CombineNeighbourBlocks(AColourWarsBlock* block)
+AColourWarsBlock* AColourWarsBlockGrid::SpawnNewBlock(IntVector GridCoord)
 {
-	block->SetScore(GetSumNeighboursScores(block));
+	const int32 Index = ToGridIndex(GridCoord);
+	const FVector WorldLocation = GetCellLocation(GridCoord);
 
-	for (AColourWarsBlock* neighbourBlock : GetNeighbours(block, true))
+	AColourWarsBlock* NewBlock = nullptr;
+	if (FreeBlocks.Num() > 0)
 	{
-		// Check if this block type is the same type
-		if (neighbourBlock->GetBlockType() == block->GetBlockType() && neighbourBlock->GetScore() > 1)
-		{
-			neighbourBlock->SetScore(1);
-		}
+		NewBlock = FreeBlocks.Pop(false);
+		NewBlock->SetActorLocation(WorldLocation);
 	}
+	else
+	{
+		// Spawn a block
+		NewBlock = GetWorld()->SpawnActor<AColourWarsBlock>(WorldLocation, FRotator(0, 0, 0));
+		NewBlock->SetActorScale3D(FVector(BlocksScale, BlocksScale, BlocksScale));
+
+		// Tell the block about its owner
+		NewBlock->SetOwningGrid(this);
+	}
+
+	// Blocks given to cells while the board texture is shown are only there to hold their selection
+	NewBlock->SetActorHiddenInGame(BlockDetail == eBlockDetail::BoardTexture);
+
+	NewBlock->SetGridCoord(GridCoord);
+	NewBlock->SetGridLocation(WorldLocation);
+	NewBlock->SetDetail(BlockDetail);
+	NewBlock->SetBlockType(Board.GetBlockType(Index));
+	NewBlock->SetScore(Board.GetScore(Index));
+	if (Board.IsCapitalBlock(Index))
+	{
+		NewBlock->SetCapitalBlock();
+	}
+	else
+	{
+		NewBlock->UnsetCapitalBlock();
+	}
+	NewBlock->SetBlockDeselected();
+	NewBlock->SetBlockSelectable(false);
+	NewBlock->SetHeat(GetCellHeat(Index));
+
+	Blocks.Add(Index, NewBlock);
+
+	return NewBlock;
+}
+
+void AColourWarsBlockGrid::RemoveBlock(AColourWarsBlock* BlockToRemove)
+{
+	Blocks.Remove(ToGridIndex(BlockToRemove->GetGridCoord()));
+
+	BlockToRemove->SetActorHiddenInGame(true);
+	FreeBlocks.Add(BlockToRemove);
 }
 
 /// <summary>
@@ -335,17 +722,7 @@ void AColourWarsBlockGrid::CombineNeighbourBlocks(AColourWarsBlock* block)
 /// <returns></returns>
 int32 AColourWarsBlockGrid::GetSumNeighboursScores(AColourWarsBlock* centralBlock)
 {
-	int32 scoreSum = centralBlock->GetScore();;
-
-	for (AColourWarsBlock* neighbourBlock : GetNeighbours(centralBlock, true))
-	{
-		if (neighbourBlock->GetBlockType() == centralBlock->GetBlockType())
-		{
-			scoreSum += neighbourBlock->GetScore() - 1;
-		}
-	}
-
-	return scoreSum;
+	return Board.GetSumNeighboursScores(ToGridIndex(centralBlock->GetGridCoord()));
 }
 
 /// <summary>
@@ -374,17 +751,7 @@ bool AColourWarsBlockGrid::IsValidMove(AColourWarsBlock* StartingBlock, AColourW
 
 bool AColourWarsBlockGrid::HasBlocks(eBlockType BlockType)
 {
-	for (int32 BlockIndex = 0; BlockIndex < Blocks.Num(); BlockIndex++)
-	{
-		AColourWarsBlock* block = Blocks[BlockIndex];
-
-		if (block->GetBlockType() == BlockType)
-		{
-			return true;
-		}
-	}
-
-	return false;
+	return Board.HasBlocks(BlockType);
 }
 
 /// <summary>
@@ -416,6 +783,27 @@ int32 AColourWarsBlockGrid::GetGameGridSize()
 	return Size;
 }
 
+int32 AColourWarsBlockGrid::GetNumRegions(eBlockType Player) const
+{
+	return Territory.IsBuiltFor(Board) ? Territory.GetNumRegions(Player) : 0;
+}
+
+TArray<int32> AColourWarsBlockGrid::GetRegionSizes(eBlockType Player) const
+{
+	TArray<int32> Sizes;
+	if (Player != eBlockType::None && Territory.IsBuiltFor(Board))
+	{
+		Territory.GetRegionSizes(Player, Sizes);
+	}
+
+	return Sizes;
+}
+
+int32 AColourWarsBlockGrid::GetCapitalArea(eBlockType Player) const
+{
+	return Territory.IsBuiltFor(Board) ? Territory.GetCapitalArea(Player) : 0;
+}
+
 /// <summary>
 /// Convert an index value to a grid coordinate
 /// </summary>
@@ -423,9 +811,28 @@ int32 AColourWarsBlockGrid::GetGameGridSize()
 /// <returns></returns>
 IntVector AColourWarsBlockGrid::ToGridCoord(int Index)
 {
-	IntVector gridCoord = IntVector(Index % GameInstance->GameGridSize, std::floor((double)(Index / GameInstance->GameGridSize)));
+	return Board.ToCoord(Index);
+}
+
+int32 AColourWarsBlockGrid::GetNumRegions(eBlockType Player) const
+{
+	return Territory.IsBuiltFor(Board) ? Territory.GetNumRegions(Player) : 0;
+}
+
+TArray<int32> AColourWarsBlockGrid::GetRegionSizes(eBlockType Player) const
+{
+	TArray<int32> Sizes;
+	if (Player != eBlockType::None && Territory.IsBuiltFor(Board))
+	{
+		Territory.GetRegionSizes(Player, Sizes);
+	}
+
+	return Sizes;
+}
 
-	return gridCoord;
+int32 AColourWarsBlockGrid::GetCapitalArea(eBlockType Player) const
+{
+	return Territory.IsBuiltFor(Board) ? Territory.GetCapitalArea(Player) : 0;
 }
 
 /// <summary>
@@ -435,7 +842,39 @@ IntVector AColourWarsBlockGrid::ToGridCoord(int Index)
 /// <returns></returns>
 int AColourWarsBlockGrid::ToGridIndex(IntVector GridCoord)
 {
-	return (GridCoord.X * GameInstance->GameGridSize) + GridCoord.Y;
+	return Board.ToIndex(GridCoord);
+}
+
+AColourWarsBlock* AColourWarsBlockGrid::GetBlock(IntVector GridCoord)
+{
+	AColourWarsBlock* block = Blocks.FindRef(ToGridIndex(GridCoord));
+	return block != nullptr ? block : SpawnNewBlock(GridCoord);
+}
+
+/// <summary>
+/// Meet the ray with the plane of the tops of the blocks, or of the board texture when that is shown, then round the
+/// point to the nearest cell the same way blocks are laid out, so picking costs the same on any size of board
+/// </summary>
+bool AColourWarsBlockGrid::GetCellUnderRay(const FVector& RayOrigin, const FVector& RayDirection, IntVector& OutCoord) const
+{
+	const float PlaneZ = GetActorLocation().Z + (BlockDetail == eBlockDetail::BoardTexture ? 0.f : BlockTopHeight * BlocksScale);
+	if (FMath::IsNearlyZero(RayDirection.Z))
+	{
+		return false;
+	}
+
+	const float Distance = (PlaneZ - RayOrigin.Z) / RayDirection.Z;
+	if (Distance < 0.f)
+	{
+		return false;
+	}
+
+	const FVector Hit = RayOrigin + RayDirection * Distance;
+	const float HalfSize = ((float)Size - 1.0f) / 2.0f;
+	OutCoord = IntVector(FMath::RoundToInt((Hit.X - GetActorLocation().X) / BlockSpacing + HalfSize),
+		FMath::RoundToInt((Hit.Y - GetActorLocation().Y) / BlockSpacing + HalfSize));
+
+	return OutCoord.X >= 0 && OutCoord.X < Size && OutCoord.Y >= 0 && OutCoord.Y < Size;
 }
 
 /// <summary>
@@ -453,28 +892,28 @@ TArray<AColourWarsBlock*> AColourWarsBlockGrid::GetNeighbours(AColourWarsBlock*
 	{
 		newGridCoord = CentralBlock->GetGridCoord();
 		newGridCoord.X = CentralBlock->GetGridCoord().X - 1;
-		neighbours.Add(Blocks[ToGridIndex(newGridCoord)]);
+		neighbours.Add(GetBlock(newGridCoord));
 	}
 
 	if (CentralBlock->GetGridCoord().X < Size - 1)
 	{
 		newGridCoord = CentralBlock->GetGridCoord();
 		newGridCoord.X = CentralBlock->GetGridCoord().X + 1;
-		neighbours.Add(Blocks[ToGridIndex(newGridCoord)]);
+		neighbours.Add(GetBlock(newGridCoord));
 	}
 	
 	if (CentralBlock->GetGridCoord().Y > 0)
 	{
 		newGridCoord = CentralBlock->GetGridCoord();
 		newGridCoord.Y = CentralBlock->GetGridCoord().Y - 1;
-		neighbours.Add(Blocks[ToGridIndex(newGridCoord)]);
+		neighbours.Add(GetBlock(newGridCoord));
 	}
 
 	if (CentralBlock->GetGridCoord().Y < Size - 1)
 	{
 		newGridCoord = CentralBlock->GetGridCoord();
 		newGridCoord.Y = CentralBlock->GetGridCoord().Y + 1;
-		neighbours.Add(Blocks[ToGridIndex(newGridCoord)]);
+		neighbours.Add(GetBlock(newGridCoord));
 	}
 
 	if (diagonals)
@@ -484,7 +923,7 @@ TArray<AColourWarsBlock*> AColourWarsBlockGrid::GetNeighbours(AColourWarsBlock*
 			newGridCoord = CentralBlock->GetGridCoord();
 			newGridCoord.X = CentralBlock->GetGridCoord().X - 1;
 			newGridCoord.Y = CentralBlock->GetGridCoord().Y - 1;
-			neighbours.Add(Blocks[ToGridIndex(newGridCoord)]);
+			neighbours.Add(GetBlock(newGridCoord));
 		}
 
 		if (CentralBlock->GetGridCoord().X < Size - 1 && CentralBlock->GetGridCoord().Y < Size - 1)
@@ -492,7 +931,7 @@ TArray<AColourWarsBlock*> AColourWarsBlockGrid::GetNeighbours(AColourWarsBlock*
 			newGridCoord = CentralBlock->GetGridCoord();
 			newGridCoord.X = CentralBlock->GetGridCoord().X + 1;
 			newGridCoord.Y = CentralBlock->GetGridCoord().Y + 1;
-			neighbours.Add(Blocks[ToGridIndex(newGridCoord)]);
+			neighbours.Add(GetBlock(newGridCoord));
 		}
 
 		if (CentralBlock->GetGridCoord().X < Size - 1 && CentralBlock->GetGridCoord().Y > 0)
@@ -500,7 +939,7 @@ TArray<AColourWarsBlock*> AColourWarsBlockGrid::GetNeighbours(AColourWarsBlock*
 			newGridCoord = CentralBlock->GetGridCoord();
 			newGridCoord.X = CentralBlock->GetGridCoord().X + 1;
 			newGridCoord.Y = CentralBlock->GetGridCoord().Y - 1;
-			neighbours.Add(Blocks[ToGridIndex(newGridCoord)]);
+			neighbours.Add(GetBlock(newGridCoord));
 		}
 
 		if (CentralBlock->GetGridCoord().X > 0 && CentralBlock->GetGridCoord().Y < Size - 1)
@@ -508,7 +947,7 @@ TArray<AColourWarsBlock*> AColourWarsBlockGrid::GetNeighbours(AColourWarsBlock*
 			newGridCoord = CentralBlock->GetGridCoord();
 			newGridCoord.X = CentralBlock->GetGridCoord().X - 1;
 			newGridCoord.Y = CentralBlock->GetGridCoord().Y + 1;
-			neighbours.Add(Blocks[ToGridIndex(newGridCoord)]);
+			neighbours.Add(GetBlock(newGridCoord));
 		}
 	}
 
@@ -519,14 +958,23 @@ void AColourWarsBlockGrid::SetSelectableBlocks(eMoveType MoveType, TArray<AColou
 {
 	UnsetAllSelectableBlocks();
 
-	int32 blocksSelected = GameMode->GetGameState()->NumberBlocksSelected();
+	// In an online match only the player whose turn it is can select blocks
+	AColourWarsPlayerController* PlayerController = Cast<AColourWarsPlayerController>(UGameplayStatics::GetPlayerController(GetWorld(), 0));
+	if (PlayerController != nullptr && !PlayerController->CanPlayFor(GetGameState()->GetCurrentPlayer()))
+	{
+		UpdateSelectionTexels();
+		return;
+	}
+
+	int32 blocksSelected = GetGameState()->NumberBlocksSelected();
 
 	// If no blocks selected then just allow all blocks of the player to be selected
 	if (blocksSelected == 0)
 	{
-		for (AColourWarsBlock* block : Blocks)
+		for (const TPair<int32, AColourWarsBlock*>& Pair : Blocks)
 		{
-			if (block->GetBlockType() == GameMode->GetGameState()->GetCurrentPlayer())
+			AColourWarsBlock* block = Pair.Value;
+			if (block->GetBlockType() == GetGameState()->GetCurrentPlayer())
 			{
 				block->SetBlockSelectable(true);
 				block->SetBlockScoreText(block->GetScore());
@@ -538,24 +986,27 @@ void AColourWarsBlockGrid::SetSelectableBlocks(eMoveType MoveType, TArray<AColou
 		switch (MoveType)
 		{
 		case eMoveType::Move:
+		{
+			// The threat map already knows which neighbours the block can take
+			const int32 SelectedIndex = ToGridIndex(SelectedBlocks[0]->GetGridCoord());
 			for (AColourWarsBlock* neighbourBlock : GetNeighbours(SelectedBlocks[0], false))
 			{
-				if (neighbourBlock->GetBlockType() == GameMode->GetGameState()->GetCurrentPlayer())
+				const int32 NeighbourIndex = ToGridIndex(neighbourBlock->GetGridCoord());
+				if (neighbourBlock->GetBlockType() == GetGameState()->GetCurrentPlayer())
 				{
 					neighbourBlock->SetBlockSelectable(true);
 					neighbourBlock->SetBlockScoreText(neighbourBlock->GetScore() + SelectedBlocks[0]->GetScore());
 				}
-
-				if (neighbourBlock->GetBlockType() != GameMode->GetGameState()->GetCurrentPlayer()
-					&& SelectedBlocks[0]->AttackingCost(neighbourBlock) < SelectedBlocks[0]->GetScore())
+				else if (ThreatMap.CanAttack(SelectedIndex, NeighbourIndex))
 				{
 					neighbourBlock->SetBlockSelectable(true);
-					neighbourBlock->SetBlockScoreText(SelectedBlocks[0]->GetScore() - SelectedBlocks[0]->AttackingCost(neighbourBlock));
+					neighbourBlock->SetBlockScoreText(SelectedBlocks[0]->GetScore() - Board.AttackingCost(SelectedIndex, NeighbourIndex));
 				}
 			}
 			SelectedBlocks[0]->SetBlockSelectable(true);
 			SelectedBlocks[0]->SetBlockScoreText(1);
 			break;
+		}
 
 		case eMoveType::Combine:
 			SelectedBlocks[0]->SetBlockSelectable(true);
@@ -609,21 +1060,23 @@ void AColourWarsBlockGrid::SetSelectableBlocks(eMoveType MoveType, TArray<AColou
 		}
 	}
 
+	UpdateSelectionTexels();
+
 	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, TEXT("Selectable blocks set."));
 }
 
 void AColourWarsBlockGrid::UnsetAllSelectableBlocks()
 {
-	for (AColourWarsBlock* block : Blocks)
+	for (const TPair<int32, AColourWarsBlock*>& Pair : Blocks)
 	{
-		block->SetBlockSelectable(false);
-		block->SetBlockScoreText(block->GetScore());
+		Pair.Value->SetBlockSelectable(false);
+		Pair.Value->SetBlockScoreText(Pair.Value->GetScore());
 	}
 }
 
 void AColourWarsBlockGrid::SetPlayerTurnMeshColour()
 {
-	PlayerTurnMesh->SetVectorParameterValueOnMaterials("Colour", AColourWarsBlock::BlockColours[GameMode->GetGameState()->GetCurrentPlayer()]);
+	PlayerTurnMesh->SetVectorParameterValueOnMaterials("Colour", AColourWarsBlock::BlockColours[GetGameState()->GetCurrentPlayer()]);
 }
 
 /// <summary>
@@ -633,12 +1086,7 @@ void AColourWarsBlockGrid::SetPlayerTurnMeshColour()
 /// <returns></returns>
 bool AColourWarsBlockGrid::CanDefeat(AColourWarsBlock* AttackingBlock, AColourWarsBlock* DefendingBlock)
 {
-	if (AttackingBlock->GetScore() > AttackingBlock->AttackingCost(DefendingBlock))
-	{
-		return true;
-	}
-
-	return false;
+	return Board.CanDefeat(ToGridIndex(AttackingBlock->GetGridCoord()), ToGridIndex(DefendingBlock->GetGridCoord()));
 }
 
 /// <summary>
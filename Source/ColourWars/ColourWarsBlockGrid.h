@@ -5,6 +5,10 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "ColourWarsBlock.h"
+#include "ColourWarsAnalysis.h"
+#include "ColourWarsBoard.h"
+#include "ColourWarsTerritory.h"
+#include "ColourWarsThreatMap.h"
 #include "IntVector.h"
 #include "ColourWarsBlockGrid.generated.h"
 
@@ -26,6 +30,10 @@ class AColourWarsBlockGrid : public AActor
 	UPROPERTY(Category = Grid, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	class UPostProcessComponent* PostProcessingVolume;
 
+	/** Whole board drawn as a texture, shown in place of the blocks when cells are too small on screen */
+	UPROPERTY(Category = Grid, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	class UColourWarsBoardTexture* BoardTexture;
+
 
 public:
 	AColourWarsBlockGrid();
@@ -34,6 +42,30 @@ public:
 	UPROPERTY(Category=Grid, EditAnywhere, BlueprintReadOnly)
 	float BlockSpacing;
 
+	/** Smallest spacing of blocks, boards too large to fit the view at this spacing are panned and zoomed around */
+	UPROPERTY(Category = Grid, EditAnywhere, BlueprintReadOnly)
+	float MinBlockSpacing = 60.f;
+
+	/** Cells beyond each edge of the view that are given blocks, so panning does not show them appearing */
+	UPROPERTY(Category = Grid, EditAnywhere, BlueprintReadOnly)
+	int32 StreamingMargin = 2;
+
+	/** Most blocks shown at once, when zoomed out past this the board is drawn as a texture */
+	UPROPERTY(Category = Grid, EditAnywhere, BlueprintReadOnly)
+	int32 MaxStreamedBlocks = 20000;
+
+	/** Pixels across a cell must take up on screen for its score to be shown as text */
+	UPROPERTY(Category = Grid, EditAnywhere, BlueprintReadOnly)
+	float TextDetailPixels = 24.f;
+
+	/** Pixels across a cell must take up on screen to be drawn as a block, below this the board is drawn as a texture */
+	UPROPERTY(Category = Grid, EditAnywhere, BlueprintReadOnly)
+	float ColourDetailPixels = 8.f;
+
+	/** Boards at least this size are always drawn as a texture, however far the camera zooms in */
+	UPROPERTY(Category = Grid, EditAnywhere, BlueprintReadOnly)
+	int32 BoardTextureSize = 256;
+
 	/** Pointer to player pawn */
 	UPROPERTY()
 		class AColourWarsPawn* PlayerPawn;
@@ -46,13 +78,30 @@ public:
 	UPROPERTY()
 		class UColourWarsGameInstance* GameInstance;
 
+	/** Pointer to game state */
+	UPROPERTY()
+		class AColourWarsGameState* GameState;
+
 	/** StaticMesh component for the clickable block */
 	UPROPERTY(Category = Grid, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 		class UStaticMeshComponent* PlayerTurnMesh;
 
 private:
-	/** Array of all blocks in grid */
-	TArray<AColourWarsBlock*> Blocks;
+	/** Blocks of the cells in and around the view, and any selected blocks, by cell index */
+	TMap<int32, AColourWarsBlock*> Blocks;
+
+	/** Blocks streamed out of view, hidden until they are needed for another cell */
+	TArray<AColourWarsBlock*> FreeBlocks;
+
+	/** Has the board been set up, cells only have blocks while they are in view */
+	bool bBoardSpawned = false;
+
+	/** How much of the blocks is drawn for the size of cells on screen */
+	eBlockDetail BlockDetail = eBlockDetail::Text;
+
+	/** Corners of the cells given blocks when the blocks were last streamed, inclusive */
+	IntVector StreamedMin = IntVector(0, 0);
+	IntVector StreamedMax = IntVector(-1, -1);
 
 	/** Number of blocks along each side of grid */
 	int32 Size;
@@ -60,39 +109,136 @@ private:
 	/** Block sizes */
 	float BlocksScale = 1.f;
 
+	/** Game state of every cell, the blocks only display it */
+	FColourWarsBoard Board;
+
+	/** Seed used to randomise this match */
+	uint32 MatchSeed;
+
+	/** Changes made by each turn played, in order, for undo and redo */
+	TArray<FColourWarsTurnDelta> TurnHistory;
+
+	/** Number of turns in TurnHistory that are currently applied, the rest have been undone */
+	int32 HistoryPosition = 0;
+
+	/** Scores of the current player's moves while analysis is shown, nullptr otherwise */
+	TUniquePtr<FColourWarsAnalysis> Analysis;
+
+	/** Worst move score on the board and the range up to the best, which scale the heat of blocks streamed in */
+	float AnalysisMinScore = 0.f;
+	float AnalysisRange = 1.f;
+
+	/** Attacks and frontiers of the board, kept up to date as the blocks are synced */
+	FColourWarsThreatMap ThreatMap;
+
+	/** Connected regions of each player's blocks, kept up to date as the blocks are synced */
+	FColourWarsTerritory Territory;
+
+	/** Set up a new board */
+	void SpawnNewGame();
+
+	/** Set up a saved board */
+	void SpawnSavedGame(struct FColourWarsSnapshot& Snapshot);
+
+	/** Set the number of blocks along each side and the spacing and scale of blocks to fit, and let the camera pan over them */
+	void SetGridSize(int32 InSize);
+
+	/** World location of the block of a cell */
+	FVector GetCellLocation(IntVector GridCoord) const;
+
+	/** Give blocks to the cells in view and take them from the cells that have left it */
+	void UpdateStreaming();
+
+	/** Draw the blocks in more or less detail, or hide them behind the board texture */
+	void SetBlockDetail(eBlockDetail Detail);
+
+	/** Show the selected and selectable blocks on the board texture while it is shown */
+	void UpdateSelectionTexels();
+
+	/** Heat of the analysis of a cell, negative if it has no move */
+	float GetCellHeat(int32 Index) const;
+
+	/** Is this the server of an online match, which sends its board to clients */
+	bool IsReplicatingBoard() const;
+
+	/** Update the threat map, the territory and the block of a cell, if it has one, to match the board */
+	void SyncBlock(int32 Index);
+
+	/** Update the blocks changed by a turn */
+	void SyncBlocks(const FColourWarsTurnDelta& Delta);
+
 protected:
 	// Begin AActor interface
 	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
 	// End AActor interface
 
 public:
 	/** Update the player scores */
 	void UpdateScore();
+
+	bool IsShowingAnalysis() const { return Analysis.IsValid(); }
+
+	/** Show or hide the heat of the current player's best move onto each block */
+	void SetShowAnalysis(bool bShow);
+
+	/** Score the moves of the current player the turns since the last update may have changed, and show them */
+	void UpdateAnalysis();
 	
 	/** Set the starting capital blocks for each player */
 	void SetCapitalBlocks();
 	
-	/** Apply the bonus for all capital blocks of the currert player block type on the grid */
-	void ApplyCapitalBlocksBonus();
+	/** Get the game state of every cell */
+	FColourWarsBoard& GetBoard() { return Board; }
+
+	/** Get the attacks and frontiers of the board as the blocks show it */
+	const FColourWarsThreatMap& GetThreatMap() const { return ThreatMap; }
+
+	/** Get the connected regions of each player's blocks as the blocks show them */
+	const FColourWarsTerritory& GetTerritory() const { return Territory; }
+
+	uint32 GetMatchSeed() const { return MatchSeed; }
+
+	/** Update every block to match the board */
+	void SyncBlocks();
+
+	class AColourWarsGameState* GetGameState();
+
+	bool HasSpawnedBlocks() const { return bBoardSpawned; }
+
+	/** Set up the board and spawn its blocks on a client of an online match */
+	void SpawnNetGame();
+
+	/** Update a cell on a client of an online match */
+	void SetNetCell(const struct FColourWarsNetCell& Cell);
+
+	/** Play a full turn on the board, keep it for undo and update the blocks */
+	void PlayTurn(const FColourWarsMove& Move);
+
+	bool CanUndo() const { return HistoryPosition > 0; }
+
+	bool CanRedo() const { return HistoryPosition < TurnHistory.Num(); }
+
+	/** Take back the last turn played */
+	void UndoTurn();
+
+	/** Play the last undone turn again */
+	void RedoTurn();
+
+	/** Move of the turn RedoTurn would play */
+	const FColourWarsMove& GetRedoMove() const { return TurnHistory[HistoryPosition].Move; }
 
 	/** Deselect all blocks */
 	void DeselectAllBlocks();
 	
-	/** Add a new block to the grid */
-	void SpawnNewBlock(eBlockType BlockType, IntVector GridCoord, int32 startingScore);
+	/** Give a cell a block, reusing one streamed out of view if there is one */
+	AColourWarsBlock* SpawnNewBlock(IntVector GridCoord);
 
-	/** Remove this block from the grid */
+	/** Take this block from its cell and hide it until it is needed again */
 	void RemoveBlock(AColourWarsBlock* BlockToRemove);
 	
-	/** Move the StartingBlock onto the EndingBlock */
-	void MoveBlock(AColourWarsBlock* StartingBlock, AColourWarsBlock* EndingBlock);
-
-	void CombineNeighbourBlocks(AColourWarsBlock* block);
-
 	int32 GetSumNeighboursScores(AColourWarsBlock* centralBlock);
 
-	void AddOneToBlock(AColourWarsBlock* block);
-
 	/** Check if player has blocks left */
 	bool HasBlocks(eBlockType BlockType);
 
@@ -108,6 +254,15 @@ public:
 	/** Convert an index value to a grid coordinate */
 	int ToGridIndex(IntVector GridCoord);
 
+	/** Block at a grid coordinate, giving the cell a block if it is out of view */
+	AColourWarsBlock* GetBlock(IntVector GridCoord);
+
+	/** Cell where a ray first meets the board, at the height of the tops of the blocks, false if it misses the board */
+	bool GetCellUnderRay(const FVector& RayOrigin, const FVector& RayDirection, IntVector& OutCoord) const;
+
+	/** Select the block of a cell as if it had been clicked, giving the cell a block if it has none */
+	void ClickCell(IntVector GridCoord);
+
 	void SetSelectableBlocks(eMoveType MoveType, TArray<AColourWarsBlock*> SelectedBlocks);
 
 	void UnsetAllSelectableBlocks();
@@ -124,6 +279,18 @@ public:
 	UFUNCTION(BlueprintCallable)
 		int32 GetGameGridSize();
 
+	/** Number of separate regions the player's blocks form, for the HUD */
+	UFUNCTION(BlueprintCallable)
+		int32 GetNumRegions(eBlockType Player) const;
+
+	/** Size of each of the player's regions, this looks at every cell */
+	UFUNCTION(BlueprintCallable)
+		TArray<int32> GetRegionSizes(eBlockType Player) const;
+
+	/** Number of the player's blocks in a region that holds one of their capitals */
+	UFUNCTION(BlueprintCallable)
+		int32 GetCapitalArea(eBlockType Player) const;
+
 	/** Returns DummyRoot subobject **/
 	FORCEINLINE class USceneComponent* GetDummyRoot() const { return DummyRoot; }
 	/** Returns ScoreText subobject **/
@@ -0,0 +1,662 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsBoard.h"
+#include "ColourWarsKernels.h"
+
+FColourWarsMove::FColourWarsMove()
+	: MoveType(eMoveType::Invalid)
+	, From(0, 0)
+	, To(0, 0)
+{
+}
+
+FColourWarsMove::FColourWarsMove(eMoveType moveType, IntVector from, IntVector to)
+	: MoveType(moveType)
+	, From(from)
+	, To(to)
+{
+}
+
+bool FColourWarsMove::operator==(const FColourWarsMove& Other) const
+{
+	return MoveType == Other.MoveType
+		&& From.X == Other.From.X && From.Y == Other.From.Y
+		&& To.X == Other.To.X && To.Y == Other.To.Y;
+}
+
+FColourWarsBoard::FColourWarsBoard()
+	: Size(0)
+	, Layout(eCellLayout::RowMajor)
+	, NumberOfPlayers(2)
+	, CurrentPlayer(eBlockType::Red)
+	, Turn(0)
+	, bGameOver(false)
+	, RecordingDelta(nullptr)
+	, CellsHash(0)
+	, ChunksPerSide(0)
+{
+}
+
+void FColourWarsBoard::Init(int32 InSize, int32 InNumberOfPlayers, eCellLayout InLayout)
+{
+	Size = InSize;
+	NumberOfPlayers = InNumberOfPlayers;
+	CurrentPlayer = eBlockType::Red;
+	Turn = 0;
+	bGameOver = false;
+
+	Layout = eCellLayout::RowMajor;
+	if (InLayout == eCellLayout::Morton && Size >= MinMortonSize && FMath::IsPowerOfTwo(Size))
+	{
+		Layout = eCellLayout::Morton;
+	}
+	else if (InLayout == eCellLayout::Chunked && Size > 0 && Size % ChunkSize == 0 && Size <= MaxChunkedSize)
+	{
+		Layout = eCellLayout::Chunked;
+	}
+
+	// A Chunked board starts with no chunks, the capitals allocate the first ones
+	const int32 NumSlots = Layout != eCellLayout::Chunked ? Size * Size : 0;
+	Scores.Init(0, NumSlots);
+	BlockTypes.Init(static_cast<uint8>(eBlockType::None), NumSlots);
+	Capitals.Init(0, NumSlots);
+	ChunksPerSide = Layout == eCellLayout::Chunked ? Size / ChunkSize : 0;
+	ChunkSlots.Init(INDEX_NONE, ChunksPerSide * ChunksPerSide);
+	SlotChunks.Reset();
+	CellsHash = 0;
+
+	SetCapitalBlocks();
+}
+
+/// <summary>
+/// Set the starting capital blocks for each player, one in each corner
+/// </summary>
+void FColourWarsBoard::SetCapitalBlocks()
+{
+	const IntVector StartingPositions[] =
+	{
+		IntVector(0, 0),
+		IntVector(Size - 1, Size - 1),
+		IntVector(0, Size - 1),
+		IntVector(Size - 1, 0)
+	};
+
+	for (int32 PlayerIndex = 1; PlayerIndex < NumberOfPlayers + 1; PlayerIndex++)
+	{
+		SetCell(ToIndex(StartingPositions[PlayerIndex - 1]), static_cast<eBlockType>(PlayerIndex), PlayerIndex, true);
+	}
+}
+
+void FColourWarsBoard::SetCell(int32 Index, eBlockType BlockType, int32 Score, bool bIsCapital)
+{
+	if (RecordingDelta != nullptr)
+	{
+		// Only the state from before the turn is kept, so a cell is recorded the first time it changes
+		bool bAlreadyRecorded = false;
+		for (const FColourWarsCellChange& Change : RecordingDelta->Cells)
+		{
+			if (Change.Index == Index)
+			{
+				bAlreadyRecorded = true;
+				break;
+			}
+		}
+
+		if (!bAlreadyRecorded)
+		{
+			const int32 OldScore = GetScore(Index);
+			const uint8 OldBlockType = static_cast<uint8>(GetBlockType(Index));
+			const uint8 bOldCapital = IsCapitalBlock(Index) ? 1 : 0;
+			RecordingDelta->Cells.Add({ Index, OldScore, OldScore, OldBlockType, OldBlockType, bOldCapital, bOldCapital });
+		}
+	}
+
+	WriteCell(Index, static_cast<uint8>(BlockType), Score, bIsCapital ? 1 : 0);
+}
+
+void FColourWarsBoard::WriteCell(int32 Index, uint8 BlockType, int32 Score, uint8 bIsCapital)
+{
+	int32 Slot = IndexToSlot(Index);
+	if (Slot == INDEX_NONE)
+	{
+		// Cells of chunks that have not been allocated are already empty
+		if (BlockType == 0 && Score == 0 && bIsCapital == 0)
+		{
+			return;
+		}
+
+		Slot = AllocateChunk(Index);
+	}
+
+	CellsHash ^= HashCell(Index, BlockTypes[Slot], Scores[Slot], Capitals[Slot]) ^ HashCell(Index, BlockType, Score, bIsCapital);
+
+	Scores[Slot] = Score;
+	BlockTypes[Slot] = BlockType;
+	Capitals[Slot] = bIsCapital;
+}
+
+/// <summary>
+/// Chunks are never freed, a chunk a player has left still costs as much as one they hold
+/// </summary>
+int32 FColourWarsBoard::AllocateChunk(int32 Index)
+{
+	const int32 Chunk = Index >> ChunkCellsLog2;
+	const int32 ChunkSlot = SlotChunks.Add(Chunk);
+	ChunkSlots[Chunk] = ChunkSlot;
+
+	Scores.AddZeroed(ChunkCells);
+	BlockTypes.AddZeroed(ChunkCells);
+	Capitals.AddZeroed(ChunkCells);
+
+	return (ChunkSlot << ChunkCellsLog2) | (Index & (ChunkCells - 1));
+}
+
+/// <summary>
+/// Hash of one cell, empty cells hash to 0 so a new board only has to hash its occupied cells
+/// </summary>
+uint64 FColourWarsBoard::HashCell(int32 Index, uint8 BlockType, int32 Score, uint8 bIsCapital)
+{
+	if (BlockType == 0 && Score == 0 && bIsCapital == 0)
+	{
+		return 0;
+	}
+
+	return Mix64(((uint64)Index << 32) ^ (uint32)Score ^ ((uint64)BlockType << 56) ^ ((uint64)bIsCapital << 63));
+}
+
+/// <summary>
+/// SplitMix64 finaliser, spreads every input bit over the whole hash
+/// </summary>
+uint64 FColourWarsBoard::Mix64(uint64 Value)
+{
+	Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBull;
+	return Value ^ (Value >> 31);
+}
+
+uint64 FColourWarsBoard::GetHash() const
+{
+	return CellsHash ^ Mix64(((uint64)Turn << 16) | ((uint64)CurrentPlayer << 8) | (bGameOver ? 1 : 0));
+}
+
+/// <summary>
+/// Get the cost that is required for the attacking block to take the defending block.
+/// With 3 or 4 players each colour is weak against the next one round, taking it costs double.
+/// </summary>
+int32 FColourWarsBoard::AttackingCost(int32 AttackingIndex, int32 DefendingIndex) const
+{
+	return AttackingCost(GetBlockType(AttackingIndex), GetBlockType(DefendingIndex), GetScore(DefendingIndex));
+}
+
+int32 FColourWarsBoard::AttackingCost(eBlockType Attacking, eBlockType Defending, int32 DefendingScore) const
+{
+	if (NumberOfPlayers == 2)
+	{
+		return DefendingScore;
+	}
+
+	eBlockType Stronger = eBlockType::None;
+	switch (Defending)
+	{
+	case eBlockType::Red:
+		Stronger = eBlockType::Green;
+		break;
+	case eBlockType::Green:
+		Stronger = eBlockType::Blue;
+		break;
+	case eBlockType::Blue:
+		Stronger = NumberOfPlayers == 3 ? eBlockType::Red : eBlockType::Purple;
+		break;
+	case eBlockType::Purple:
+		if (NumberOfPlayers != 4)
+		{
+			return 0;
+		}
+		Stronger = eBlockType::Red;
+		break;
+	default:
+		return 0;
+	}
+
+	return Attacking == Stronger ? DefendingScore * 2 : DefendingScore;
+}
+
+bool FColourWarsBoard::CanDefeat(int32 AttackingIndex, int32 DefendingIndex) const
+{
+	return GetScore(AttackingIndex) > AttackingCost(AttackingIndex, DefendingIndex);
+}
+
+/// <summary>
+/// Get the sum of all neighbour scores and central block
+/// </summary>
+int32 FColourWarsBoard::GetSumNeighboursScores(int32 CentralIndex) const
+{
+	const eBlockType CentralType = GetBlockType(CentralIndex);
+	int32 ScoreSum = GetScore(CentralIndex);
+
+	ForEachNeighbour(CentralIndex, true, [&](int32 NeighbourIndex)
+	{
+		if (GetBlockType(NeighbourIndex) == CentralType)
+		{
+			ScoreSum += GetScore(NeighbourIndex) - 1;
+		}
+	});
+
+	return ScoreSum;
+}
+
+/// <summary>
+/// Move the starting block onto the ending block
+/// </summary>
+void FColourWarsBoard::MoveBlock(int32 StartingIndex, int32 EndingIndex)
+{
+	const eBlockType StartingType = GetBlockType(StartingIndex);
+
+	// If blocks are same type then move score over to ending block
+	if (StartingType == GetBlockType(EndingIndex))
+	{
+		AddScore(EndingIndex, GetScore(StartingIndex));
+		SetScore(StartingIndex, 0);
+	}
+	else
+	{
+		const int32 attackingCost = AttackingCost(StartingIndex, EndingIndex);
+		SetCell(EndingIndex, StartingType, GetScore(StartingIndex) - attackingCost, false);
+		SetScore(StartingIndex, 0);
+		BonusCheck(EndingIndex);
+	}
+
+	// Add a score to the starting block
+	AddScore(StartingIndex, 1);
+
+	// Move capital status if this block is capital block
+	if (IsCapitalBlock(StartingIndex))
+	{
+		SetCell(StartingIndex, StartingType, GetScore(StartingIndex), false);
+		SetCell(EndingIndex, GetBlockType(EndingIndex), GetScore(EndingIndex), true);
+	}
+}
+
+/// <summary>
+/// Combine all of the scores of neighbour blocks into this block
+/// </summary>
+void FColourWarsBoard::CombineNeighbourBlocks(int32 Index)
+{
+	SetScore(Index, GetSumNeighboursScores(Index));
+
+	const eBlockType CentralType = GetBlockType(Index);
+	ForEachNeighbour(Index, true, [&](int32 NeighbourIndex)
+	{
+		if (GetBlockType(NeighbourIndex) == CentralType && GetScore(NeighbourIndex) > 1)
+		{
+			SetScore(NeighbourIndex, 1);
+		}
+	});
+}
+
+void FColourWarsBoard::AddOneToBlock(int32 Index)
+{
+	AddScore(Index, 1);
+}
+
+/// <summary>
+/// Check each of the 4 squares of 2x2 blocks that include this block and, for every one that is
+/// all of the same type, add 1 to each block in it
+/// </summary>
+void FColourWarsBoard::BonusCheck(int32 Index)
+{
+	const IntVector Coord = ToCoord(Index);
+	const eBlockType Type = GetBlockType(Index);
+	const int32 Directions[4][2] = { { 1, 1 }, { -1, 1 }, { -1, -1 }, { 1, -1 } };
+
+	for (const int32 (&Direction)[2] : Directions)
+	{
+		const int32 X = Coord.X + Direction[0];
+		const int32 Y = Coord.Y + Direction[1];
+		if (!IsValidCoord(X, Y))
+		{
+			continue;
+		}
+
+		const int32 Square[3] = { ToIndex(X, Coord.Y), ToIndex(Coord.X, Y), ToIndex(X, Y) };
+		if (GetBlockType(Square[0]) == Type && GetBlockType(Square[1]) == Type && GetBlockType(Square[2]) == Type)
+		{
+			for (int32 SquareIndex : Square)
+			{
+				AddScore(SquareIndex, 1);
+			}
+			AddScore(Index, 1);
+		}
+	}
+}
+
+/// <summary>
+/// Add 1 to every vertical and horizontal neighbour of the capital block that is the same type
+/// </summary>
+void FColourWarsBoard::ApplyCapitalBlockBonus(int32 Index)
+{
+	const eBlockType CapitalType = GetBlockType(Index);
+	ForEachNeighbour(Index, false, [&](int32 NeighbourIndex)
+	{
+		if (GetBlockType(NeighbourIndex) == CapitalType)
+		{
+			AddScore(NeighbourIndex, 1);
+		}
+	});
+}
+
+/// <summary>
+/// Goes through the stored cells, so a Chunked board skips the chunks it has not allocated. The bonus only adds to
+/// blocks that are already there, so no chunk is allocated while the cells are gone through.
+/// </summary>
+void FColourWarsBoard::ApplyCapitalBlocksBonus()
+{
+	const uint8 Player = static_cast<uint8>(CurrentPlayer);
+	for (int32 Slot = 0; Slot < Capitals.Num(); Slot++)
+	{
+		if (Capitals[Slot] != 0 && BlockTypes[Slot] == Player)
+		{
+			ApplyCapitalBlockBonus(SlotToIndex(Slot));
+		}
+	}
+}
+
+bool FColourWarsBoard::HasBlocks(eBlockType BlockType) const
+{
+	return BlockTypes.Contains(static_cast<uint8>(BlockType));
+}
+
+void FColourWarsBoard::GetPlayerScores(int32 (&OutScores)[5]) const
+{
+	// Only the stored cells are summed, cells of unallocated chunks have no score
+	ColourWarsKernels::SumScoresByType(Scores.GetData(), BlockTypes.GetData(), Scores.Num(), OutScores);
+}
+
+void FColourWarsBoard::GetCombineScores(TArray<int32>& OutScores) const
+{
+	OutScores.SetNumUninitialized(GetNumCells());
+	if (Layout == eCellLayout::RowMajor)
+	{
+		ColourWarsKernels::SumNeighbourhoods(Scores.GetData(), BlockTypes.GetData(), Size, OutScores.GetData());
+		return;
+	}
+
+	// The kernel works on rows, other layouts sum each stored cell's neighbourhood in place
+	FMemory::Memzero(OutScores.GetData(), OutScores.Num() * sizeof(int32));
+	ForEachStoredCell([this, &OutScores](int32 Index)
+	{
+		if (GetBlockType(Index) != eBlockType::None)
+		{
+			OutScores[Index] = GetSumNeighboursScores(Index);
+		}
+	});
+}
+
+bool FColourWarsBoard::IsLegalMove(const FColourWarsMove& Move) const
+{
+	if (Move.MoveType == eMoveType::Invalid)
+	{
+		// Ending the turn without a move is always allowed
+		return true;
+	}
+
+	if (!IsValidCoord(Move.From.X, Move.From.Y) || GetBlockType(ToIndex(Move.From)) != CurrentPlayer)
+	{
+		return false;
+	}
+
+	if (Move.MoveType != eMoveType::Move)
+	{
+		return true;
+	}
+
+	if (!IsValidCoord(Move.To.X, Move.To.Y)
+		|| FMath::Abs(Move.From.X - Move.To.X) + FMath::Abs(Move.From.Y - Move.To.Y) != 1)
+	{
+		return false;
+	}
+
+	const int32 StartingIndex = ToIndex(Move.From);
+	const int32 EndingIndex = ToIndex(Move.To);
+	return GetBlockType(EndingIndex) == CurrentPlayer || CanDefeat(StartingIndex, EndingIndex);
+}
+
+void FColourWarsBoard::GetLegalMoves(TArray<FColourWarsMove>& OutMoves) const
+{
+	const uint8 Player = static_cast<uint8>(CurrentPlayer);
+	for (int32 Slot = 0; Slot < BlockTypes.Num(); Slot++)
+	{
+		if (BlockTypes[Slot] != Player)
+		{
+			continue;
+		}
+
+		const int32 Index = SlotToIndex(Slot);
+		const IntVector From = ToCoord(Index);
+		OutMoves.Emplace(eMoveType::AddOne, From);
+		OutMoves.Emplace(eMoveType::Combine, From);
+
+		ForEachNeighbour(Index, false, [this, Index, &From, &OutMoves](int32 NeighbourIndex)
+		{
+			if (GetBlockType(NeighbourIndex) == CurrentPlayer || CanDefeat(Index, NeighbourIndex))
+			{
+				OutMoves.Emplace(eMoveType::Move, From, ToCoord(NeighbourIndex));
+			}
+		});
+	}
+}
+
+void FColourWarsBoard::MakeMove(const FColourWarsMove& Move)
+{
+	switch (Move.MoveType)
+	{
+		case eMoveType::AddOne:
+			AddOneToBlock(ToIndex(Move.From));
+			break;
+		case eMoveType::Move:
+			MoveBlock(ToIndex(Move.From), ToIndex(Move.To));
+			break;
+		case eMoveType::Combine:
+			CombineNeighbourBlocks(ToIndex(Move.From));
+			break;
+		default:
+			break;
+	}
+}
+
+/// <summary>
+/// Increment player and check if they have blocks left and if not increment again until a player does.
+/// If it is still the same players turn after incrementing this means that it is the only player left.
+/// </summary>
+void FColourWarsBoard::IncrementPlayer()
+{
+	const int32 PreviousPlayerInt = static_cast<int32>(CurrentPlayer);
+	int32 PlayerInt = PreviousPlayerInt;
+
+	for (int32 Attempt = 0; Attempt < NumberOfPlayers; Attempt++)
+	{
+		PlayerInt++;
+
+		if (PlayerInt > NumberOfPlayers)
+		{
+			PlayerInt = 1;
+		}
+
+		if (HasBlocks(static_cast<eBlockType>(PlayerInt)))
+		{
+			break;
+		}
+	}
+
+	CurrentPlayer = static_cast<eBlockType>(PlayerInt);
+	Turn++;
+
+	if (PlayerInt == PreviousPlayerInt)
+	{
+		bGameOver = true;
+	}
+}
+
+void FColourWarsBoard::ApplyTurn(const FColourWarsMove& Move)
+{
+	MakeMove(Move);
+	ApplyCapitalBlocksBonus();
+	IncrementPlayer();
+}
+
+void FColourWarsBoard::ApplyTurn(const FColourWarsMove& Move, FColourWarsTurnDelta& OutDelta)
+{
+	OutDelta.Reset();
+	OutDelta.Move = Move;
+	OutDelta.OldPlayer = CurrentPlayer;
+	OutDelta.bOldGameOver = bGameOver;
+
+	RecordingDelta = &OutDelta;
+	ApplyTurn(Move);
+	RecordingDelta = nullptr;
+
+	for (FColourWarsCellChange& Change : OutDelta.Cells)
+	{
+		Change.NewScore = GetScore(Change.Index);
+		Change.NewBlockType = static_cast<uint8>(GetBlockType(Change.Index));
+		Change.bNewCapital = IsCapitalBlock(Change.Index) ? 1 : 0;
+	}
+
+	OutDelta.NewPlayer = CurrentPlayer;
+	OutDelta.bNewGameOver = bGameOver;
+}
+
+void FColourWarsBoard::UndoTurn(const FColourWarsTurnDelta& Delta)
+{
+	for (const FColourWarsCellChange& Change : Delta.Cells)
+	{
+		WriteCell(Change.Index, Change.OldBlockType, Change.OldScore, Change.bOldCapital);
+	}
+
+	CurrentPlayer = Delta.OldPlayer;
+	bGameOver = Delta.bOldGameOver;
+	Turn--;
+}
+
+void FColourWarsBoard::RedoTurn(const FColourWarsTurnDelta& Delta)
+{
+	for (const FColourWarsCellChange& Change : Delta.Cells)
+	{
+		WriteCell(Change.Index, Change.NewBlockType, Change.NewScore, Change.bNewCapital);
+	}
+
+	CurrentPlayer = Delta.NewPlayer;
+	bGameOver = Delta.bNewGameOver;
+	Turn++;
+}
+
+void FColourWarsBoard::Serialize(FArchive& Ar)
+{
+	// A board that could not be loaded again, i.e. a conquest size Chunked board, is not written at all
+	if (Ar.IsSaving() && Size > MaxSize)
+	{
+		Ar.SetError();
+		return;
+	}
+
+	uint32 PackedSize = Size;
+	uint32 PackedTurn = Turn;
+	uint8 Players = NumberOfPlayers;
+	uint8 Player = static_cast<uint8>(CurrentPlayer);
+	uint8 GameOver = bGameOver ? 1 : 0;
+
+	Ar.SerializeIntPacked(PackedSize);
+	Ar.SerializeIntPacked(PackedTurn);
+	Ar << Players;
+	Ar << Player;
+	Ar << GameOver;
+
+	if (Ar.IsLoading())
+	{
+		// Refuse sizes no game grid could have rather than allocate for a corrupt file
+		if (PackedSize > MaxSize || Players < 2 || Players > 4 || Player > 4)
+		{
+			Ar.SetError();
+			return;
+		}
+
+		Size = PackedSize;
+		Layout = eCellLayout::RowMajor;
+		ChunksPerSide = 0;
+		ChunkSlots.Reset();
+		SlotChunks.Reset();
+		Turn = PackedTurn;
+		NumberOfPlayers = Players;
+		CurrentPlayer = static_cast<eBlockType>(Player);
+		bGameOver = GameOver != 0;
+
+		const int32 NumCells = Size * Size;
+		Scores.Init(0, NumCells);
+		BlockTypes.Init(static_cast<uint8>(eBlockType::None), NumCells);
+		Capitals.Init(0, NumCells);
+	}
+
+	// Each occupied cell is written as the number of empty cells before it, then the block type and
+	// capital flag in one byte, then the zigzag encoded score. Cells go row by row whatever the layout,
+	// a loaded board is row-major so its positions are its indices.
+	auto PositionToIndex = [this](int32 Position) { return Layout == eCellLayout::RowMajor ? Position : ToIndex(Position / Size, Position % Size); };
+	auto IsEmptyCell = [this](int32 Index) { return GetBlockType(Index) == eBlockType::None && GetScore(Index) == 0 && !IsCapitalBlock(Index); };
+
+	int32 Position = 0;
+	while (Position < GetNumCells() && !Ar.IsError())
+	{
+		uint32 EmptyRun = 0;
+		if (Ar.IsSaving())
+		{
+			while (Position + (int32)EmptyRun < GetNumCells() && IsEmptyCell(PositionToIndex(Position + EmptyRun)))
+			{
+				EmptyRun++;
+			}
+		}
+
+		Ar.SerializeIntPacked(EmptyRun);
+		if (Ar.IsLoading() && EmptyRun > (uint32)(GetNumCells() - Position))
+		{
+			Ar.SetError();
+			break;
+		}
+
+		Position += EmptyRun;
+
+		if (Position >= GetNumCells())
+		{
+			break;
+		}
+
+		const int32 Index = PositionToIndex(Position);
+		const int32 Score = GetScore(Index);
+		uint8 TypeAndCapital = static_cast<uint8>(GetBlockType(Index)) | (IsCapitalBlock(Index) ? 0x80 : 0);
+		uint32 ZigZagScore = (uint32)(Score << 1) ^ (uint32)(Score >> 31);
+		Ar << TypeAndCapital;
+		Ar.SerializeIntPacked(ZigZagScore);
+
+		if (Ar.IsLoading())
+		{
+			if ((TypeAndCapital & 0x7F) > static_cast<uint8>(eBlockType::Purple))
+			{
+				Ar.SetError();
+				break;
+			}
+
+			BlockTypes[Index] = TypeAndCapital & 0x7F;
+			Capitals[Index] = TypeAndCapital >> 7;
+			Scores[Index] = (int32)(ZigZagScore >> 1) ^ -(int32)(ZigZagScore & 1);
+		}
+
+		Position++;
+	}
+
+	if (Ar.IsLoading())
+	{
+		CellsHash = 0;
+		for (int32 CellIndex = 0; CellIndex < GetNumCells(); CellIndex++)
+		{
+			CellsHash ^= HashCell(CellIndex, BlockTypes[CellIndex], Scores[CellIndex], Capitals[CellIndex]);
+		}
+	}
+}
@@ -0,0 +1,441 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColourWarsBlock.h"
+#include "IntVector.h"
+#include "ColourWarsMorton.h"
+
+/** A single turn: the move type and the grid coordinates of the blocks it uses */
+struct COLOURWARS_API FColourWarsMove
+{
+	FColourWarsMove();
+	FColourWarsMove(eMoveType moveType, IntVector from, IntVector to = IntVector(0, 0));
+
+	/** Move type of this turn, Invalid means the turn was passed */
+	eMoveType MoveType;
+
+	/** Block the move is made from (or the only block for AddOne and Combine) */
+	IntVector From;
+
+	/** Block the move is made onto, only used by Move */
+	IntVector To;
+
+	bool operator==(const FColourWarsMove& Other) const;
+};
+
+/** Score, type and capital flag of a cell before and after a turn */
+struct FColourWarsCellChange
+{
+	int32 Index;
+	int32 OldScore;
+	int32 NewScore;
+	uint8 OldBlockType;
+	uint8 NewBlockType;
+	uint8 bOldCapital;
+	uint8 bNewCapital;
+};
+
+/**
+ * Everything a turn changed, so it can be undone and redone in time proportional to the cells it touched.
+ * The cells are stored inline so search code can make and unmake moves without allocating.
+ */
+struct COLOURWARS_API FColourWarsTurnDelta
+{
+	FColourWarsMove Move;
+
+	TArray<FColourWarsCellChange, TInlineAllocator<16>> Cells;
+
+	eBlockType OldPlayer;
+	eBlockType NewPlayer;
+	bool bOldGameOver;
+	bool bNewGameOver;
+
+	void Reset() { Cells.Reset(); }
+};
+
+/** Order a board stores its cells in */
+enum class eCellLayout : uint8
+{
+	/** Row by row, the index of a cell is X * Size + Y */
+	RowMajor,
+
+	/** Z-order, see ColourWarsMorton, which keeps the neighbourhood of a cell within a few cache lines on large boards */
+	Morton,
+
+	/**
+	 * Square chunks of cells, each stored row by row, with only the chunks that have ever held a block or a score
+	 * allocated. For very large boards that are mostly empty, e.g. conquest boards, so memory follows the territory.
+	 *
+	 * Only headless code that plays the board itself, such as the layout benchmark, can use it. Boards larger than
+	 * MaxSize cannot be saved or loaded, and the game grid, threat map, territory, analysis and board texture keep
+	 * dense arrays indexed row by row, so they only take row-major boards.
+	 */
+	Chunked
+};
+
+/**
+ * Plain game state of a board: the score, owner and capital flag of every cell plus the turn flow.
+ *
+ * Holds all of the game rules so they can be run without spawning any actors, e.g. by the
+ * headless replayer. AColourWarsBlockGrid keeps one of these and mirrors it onto its blocks.
+ */
+class COLOURWARS_API FColourWarsBoard
+{
+public:
+	/** Largest board that can be saved and loaded, and so played by the game rather than headless code */
+	static const int32 MaxSize = 1024;
+
+	/** Smallest board that can use the Morton layout, a smaller one fits in cache whatever its layout */
+	static const int32 MinMortonSize = 32;
+
+	/** Cells along each side of a chunk of a Chunked board, as a power of two */
+	static const int32 ChunkSizeLog2 = 5;
+	static const int32 ChunkSize = 1 << ChunkSizeLog2;
+	static const int32 ChunkCellsLog2 = 2 * ChunkSizeLog2;
+	static const int32 ChunkCells = 1 << ChunkCellsLog2;
+
+	/** Largest board that can be Chunked */
+	static const int32 MaxChunkedSize = 4096;
+
+	FColourWarsBoard();
+
+	/**
+	 * Reset to an empty board of the given size with the starting capital blocks set. The Morton layout needs a
+	 * power of two size of at least MinMortonSize, and the Chunked layout a multiple of ChunkSize of at most
+	 * MaxChunkedSize; any other size is laid out row by row.
+	 *
+	 * Cell indices, and so the hash, depend on the layout. Only the headless code that plays large boards (search,
+	 * evaluation and the rules themselves) asks for Morton; everything that keeps cell indices, such as the game grid,
+	 * replays, tablebases and network turns, uses row-major boards.
+	 */
+	void Init(int32 InSize, int32 InNumberOfPlayers, eCellLayout InLayout = eCellLayout::RowMajor);
+
+	/** Set the starting capital blocks for each player */
+	void SetCapitalBlocks();
+
+	int32 GetSize() const { return Size; }
+
+	eCellLayout GetLayout() const { return Layout; }
+
+	int32 GetNumCells() const { return Size * Size; }
+
+	/** Number of chunks a Chunked board has allocated */
+	int32 GetNumChunks() const { return SlotChunks.Num(); }
+
+	/**
+	 * Call Func(Index) for every cell that can hold a block or a score: every cell of a board, except that a Chunked
+	 * board skips the chunks it has not allocated. Cells are visited in index order except on a Chunked board.
+	 */
+	template<typename FuncType>
+	void ForEachStoredCell(FuncType Func) const
+	{
+		for (int32 Slot = 0; Slot < Scores.Num(); Slot++)
+		{
+			Func(SlotToIndex(Slot));
+		}
+	}
+
+	int32 GetNumberOfPlayers() const { return NumberOfPlayers; }
+
+	eBlockType GetCurrentPlayer() const { return CurrentPlayer; }
+
+	void SetCurrentPlayer(eBlockType Player) { CurrentPlayer = Player; }
+
+	/** Number of turns played so far */
+	int32 GetTurn() const { return Turn; }
+
+	bool IsGameOver() const { return bGameOver; }
+
+	/** Set the turn flow directly, for a board that is a copy of one played elsewhere */
+	void SetTurnFlow(eBlockType Player, int32 InTurn, bool bInGameOver) { CurrentPlayer = Player; Turn = InTurn; bGameOver = bInGameOver; }
+
+	/** Is the coordinate inside the board */
+	bool IsValidCoord(int32 X, int32 Y) const { return X >= 0 && Y >= 0 && X < Size && Y < Size; }
+
+	/** Convert a grid coordinate to a cell index */
+	int32 ToIndex(int32 X, int32 Y) const
+	{
+		switch (Layout)
+		{
+		case eCellLayout::Morton:
+			return ColourWarsMorton::Encode(X, Y);
+		case eCellLayout::Chunked:
+			return ((((X >> ChunkSizeLog2) * ChunksPerSide) + (Y >> ChunkSizeLog2)) << ChunkCellsLog2)
+				| ((X & (ChunkSize - 1)) << ChunkSizeLog2) | (Y & (ChunkSize - 1));
+		default:
+			return X * Size + Y;
+		}
+	}
+
+	int32 ToIndex(IntVector GridCoord) const { return ToIndex(GridCoord.X, GridCoord.Y); }
+
+	/** Convert a cell index to a grid coordinate */
+	IntVector ToCoord(int32 Index) const
+	{
+		switch (Layout)
+		{
+		case eCellLayout::Morton:
+			return IntVector(ColourWarsMorton::DecodeX(Index), ColourWarsMorton::DecodeY(Index));
+		case eCellLayout::Chunked:
+		{
+			const int32 Chunk = Index >> ChunkCellsLog2;
+			return IntVector(((Chunk / ChunksPerSide) << ChunkSizeLog2) | ((Index >> ChunkSizeLog2) & (ChunkSize - 1)),
+				((Chunk % ChunksPerSide) << ChunkSizeLog2) | (Index & (ChunkSize - 1)));
+		}
+		default:
+			return IntVector(Index / Size, Index % Size);
+		}
+	}
+
+	int32 GetScore(int32 Index) const { return Layout != eCellLayout::Chunked ? Scores[Index] : GetChunkedCell(Scores, Index); }
+
+	eBlockType GetBlockType(int32 Index) const
+	{
+		return static_cast<eBlockType>(Layout != eCellLayout::Chunked ? BlockTypes[Index] : GetChunkedCell(BlockTypes, Index));
+	}
+
+	bool IsCapitalBlock(int32 Index) const { return (Layout != eCellLayout::Chunked ? Capitals[Index] : GetChunkedCell(Capitals, Index)) != 0; }
+
+	/** Set every field of a cell */
+	void SetCell(int32 Index, eBlockType BlockType, int32 Score, bool bIsCapital);
+
+	void SetScore(int32 Index, int32 Score) { SetCell(Index, GetBlockType(Index), Score, IsCapitalBlock(Index)); }
+
+	void AddScore(int32 Index, int32 ScoreToAdd) { SetScore(Index, GetScore(Index) + ScoreToAdd); }
+
+	/** Call Func(NeighbourIndex) for each vertical and horizontal neighbour, and the diagonal ones too if requested */
+	template<typename FuncType>
+	void ForEachNeighbour(int32 Index, bool bDiagonals, FuncType Func) const
+	{
+		if (Layout == eCellLayout::Morton)
+		{
+			ForEachMortonNeighbour(Index, bDiagonals, Func);
+			return;
+		}
+
+		if (Layout == eCellLayout::Chunked)
+		{
+			ForEachChunkedNeighbour(Index, bDiagonals, Func);
+			return;
+		}
+
+		const int32 X = Index / Size;
+		const int32 Y = Index % Size;
+
+		if (X > 0)        { Func(Index - Size); }
+		if (X < Size - 1) { Func(Index + Size); }
+		if (Y > 0)        { Func(Index - 1); }
+		if (Y < Size - 1) { Func(Index + 1); }
+
+		if (bDiagonals)
+		{
+			if (X > 0 && Y > 0)               { Func(Index - Size - 1); }
+			if (X < Size - 1 && Y < Size - 1) { Func(Index + Size + 1); }
+			if (X < Size - 1 && Y > 0)        { Func(Index + Size - 1); }
+			if (X > 0 && Y < Size - 1)        { Func(Index - Size + 1); }
+		}
+	}
+
+	/** Get the cost that is required for the attacking block to take the defending block */
+	int32 AttackingCost(int32 AttackingIndex, int32 DefendingIndex) const;
+
+	/** Get the cost for a block of the attacking type to take a block of the defending type and score */
+	int32 AttackingCost(eBlockType Attacking, eBlockType Defending, int32 DefendingScore) const;
+
+	/** Check if the attacking block can take the defending block */
+	bool CanDefeat(int32 AttackingIndex, int32 DefendingIndex) const;
+
+	/** Get the sum of all same type neighbour scores and the central block, i.e. the result of a Combine */
+	int32 GetSumNeighboursScores(int32 CentralIndex) const;
+
+	/** Move the starting block onto the ending block */
+	void MoveBlock(int32 StartingIndex, int32 EndingIndex);
+
+	/** Combine all of the scores of neighbour blocks into this block */
+	void CombineNeighbourBlocks(int32 Index);
+
+	/** Increase the score of this block by 1 */
+	void AddOneToBlock(int32 Index);
+
+	/** Check if this block has created a square of same blocks and if so apply a completion bonus */
+	void BonusCheck(int32 Index);
+
+	/** Apply the bonus of a single capital block to its neighbours */
+	void ApplyCapitalBlockBonus(int32 Index);
+
+	/** Apply the bonus for all capital blocks of the current player */
+	void ApplyCapitalBlocksBonus();
+
+	/** Check if player has blocks left */
+	bool HasBlocks(eBlockType BlockType) const;
+
+	/** Sum of block scores for each block type, indexed by eBlockType */
+	void GetPlayerScores(int32 (&OutScores)[5]) const;
+
+	/** GetSumNeighboursScores of every cell at once, or 0 for empty cells */
+	void GetCombineScores(TArray<int32>& OutScores) const;
+
+	/** Is this move allowed for the current player */
+	bool IsLegalMove(const FColourWarsMove& Move) const;
+
+	/** Add every legal move of the current player to OutMoves, not counting passing the turn */
+	void GetLegalMoves(TArray<FColourWarsMove>& OutMoves) const;
+
+	/** Apply the move itself, without any of the end of turn steps */
+	void MakeMove(const FColourWarsMove& Move);
+
+	/** Switch to the next player that still has blocks, ending the game if there is none */
+	void IncrementPlayer();
+
+	/** Play a full turn: the move, the capital bonus and switching to the next player */
+	void ApplyTurn(const FColourWarsMove& Move);
+
+	/** Play a full turn, recording everything it changes into OutDelta */
+	void ApplyTurn(const FColourWarsMove& Move, FColourWarsTurnDelta& OutDelta);
+
+	/** Put back every cell and the turn flow as they were before the delta's turn */
+	void UndoTurn(const FColourWarsTurnDelta& Delta);
+
+	/** Play the delta's turn again after it has been undone */
+	void RedoTurn(const FColourWarsTurnDelta& Delta);
+
+	/**
+	 * Compact serialisation of the full state, empty cells are run length encoded. Boards load row-major, and a
+	 * board larger than MaxSize sets an error rather than being saved.
+	 */
+	void Serialize(FArchive& Ar);
+
+	/**
+	 * Hash of every cell and the turn flow. The cell part is updated as each cell is written, so this is
+	 * cheap to call every turn, and two boards that played the same turns always have the same hash.
+	 */
+	uint64 GetHash() const;
+
+	/** Hash of one cell as it goes into GetHash, 0 for an empty cell */
+	static uint64 HashCell(int32 Index, uint8 BlockType, int32 Score, uint8 bIsCapital);
+
+	static uint64 Mix64(uint64 Value);
+
+private:
+	/** Number of blocks along each side of grid */
+	int32 Size;
+
+	eCellLayout Layout;
+
+	int32 NumberOfPlayers;
+
+	eBlockType CurrentPlayer;
+
+	int32 Turn;
+
+	bool bGameOver;
+
+	/** Delta that SetCell records the old state of cells into, while a turn is being applied */
+	FColourWarsTurnDelta* RecordingDelta;
+
+	/** Set a cell without recording it */
+	void WriteCell(int32 Index, uint8 BlockType, int32 Score, uint8 bIsCapital);
+
+	/** ForEachNeighbour of a Morton board, in the same order, stepping the index rather than converting coordinates */
+	template<typename FuncType>
+	void ForEachMortonNeighbour(int32 Index, bool bDiagonals, FuncType Func) const
+	{
+		using namespace ColourWarsMorton;
+
+		// The size is a power of two, so the last cell along X or Y has all of that coordinate's bits set
+		const uint32 LastIndex = Size * Size - 1;
+		const uint32 XPart = Index & XBits;
+		const uint32 YPart = Index & YBits;
+		const bool bLowX = XPart != 0;
+		const bool bHighX = XPart != (LastIndex & XBits);
+		const bool bLowY = YPart != 0;
+		const bool bHighY = YPart != (LastIndex & YBits);
+
+		if (bLowX)  { Func(SubtractX(Index)); }
+		if (bHighX) { Func(AddX(Index)); }
+		if (bLowY)  { Func(SubtractY(Index)); }
+		if (bHighY) { Func(AddY(Index)); }
+
+		if (bDiagonals)
+		{
+			if (bLowX && bLowY)   { Func(SubtractY(SubtractX(Index))); }
+			if (bHighX && bHighY) { Func(AddY(AddX(Index))); }
+			if (bHighX && bLowY)  { Func(SubtractY(AddX(Index))); }
+			if (bLowX && bHighY)  { Func(AddY(SubtractX(Index))); }
+		}
+	}
+
+	/** ForEachNeighbour of a Chunked board, in the same order, through the neighbours' coordinates */
+	template<typename FuncType>
+	void ForEachChunkedNeighbour(int32 Index, bool bDiagonals, FuncType Func) const
+	{
+		const IntVector Coord = ToCoord(Index);
+		const int32 X = Coord.X;
+		const int32 Y = Coord.Y;
+
+		if (X > 0)        { Func(ToIndex(X - 1, Y)); }
+		if (X < Size - 1) { Func(ToIndex(X + 1, Y)); }
+		if (Y > 0)        { Func(ToIndex(X, Y - 1)); }
+		if (Y < Size - 1) { Func(ToIndex(X, Y + 1)); }
+
+		if (bDiagonals)
+		{
+			if (X > 0 && Y > 0)               { Func(ToIndex(X - 1, Y - 1)); }
+			if (X < Size - 1 && Y < Size - 1) { Func(ToIndex(X + 1, Y + 1)); }
+			if (X < Size - 1 && Y > 0)        { Func(ToIndex(X + 1, Y - 1)); }
+			if (X > 0 && Y < Size - 1)        { Func(ToIndex(X - 1, Y + 1)); }
+		}
+	}
+
+	/** Where a cell is stored, INDEX_NONE for a cell of a chunk a Chunked board has not allocated */
+	int32 IndexToSlot(int32 Index) const
+	{
+		if (Layout != eCellLayout::Chunked)
+		{
+			return Index;
+		}
+
+		const int32 Chunk = ChunkSlots[Index >> ChunkCellsLog2];
+		return Chunk != INDEX_NONE ? (Chunk << ChunkCellsLog2) | (Index & (ChunkCells - 1)) : INDEX_NONE;
+	}
+
+	/** The cell stored at a slot */
+	int32 SlotToIndex(int32 Slot) const
+	{
+		return Layout != eCellLayout::Chunked ? Slot : (SlotChunks[Slot >> ChunkCellsLog2] << ChunkCellsLog2) | (Slot & (ChunkCells - 1));
+	}
+
+	/** Read a cell of a Chunked board, cells of chunks that have not been allocated are empty */
+	template<typename ValueType>
+	ValueType GetChunkedCell(const TArray<ValueType>& Values, int32 Index) const
+	{
+		const int32 Slot = IndexToSlot(Index);
+		return Slot != INDEX_NONE ? Values[Slot] : 0;
+	}
+
+	/** Allocate the chunk of a cell of a Chunked board and return the cell's slot */
+	int32 AllocateChunk(int32 Index);
+
+	/** Xor of the hash of every cell */
+	uint64 CellsHash;
+
+	/** Score of each cell, by slot: the cell index, or on a Chunked board the cell's place in the allocated chunks */
+	TArray<int32> Scores;
+
+	/** eBlockType of each cell, by slot */
+	TArray<uint8> BlockTypes;
+
+	/** Capital flag of each cell, by slot */
+	TArray<uint8> Capitals;
+
+	/** Chunks along each side of a Chunked board */
+	int32 ChunksPerSide;
+
+	/** Place of each chunk of a Chunked board among the allocated chunks, or INDEX_NONE */
+	TArray<int32> ChunkSlots;
+
+	/** Chunk of each allocated chunk of a Chunked board */
+	TArray<int32> SlotChunks;
+};
@@ -0,0 +1,211 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsBoardTexture.h"
+#include "ColourWarsBlock.h"
+#include "UObject/ConstructorHelpers.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/Texture2D.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+namespace
+{
+	/** Part of the way to white a selectable and a selected cell are lightened */
+	const float SelectableLightening = 0.3f;
+	const float SelectedLightening = 0.6f;
+}
+
+UColourWarsBoardTexture::UColourWarsBoardTexture()
+{
+	// Structure to hold one-time initialization
+	struct FConstructorStatics
+	{
+		ConstructorHelpers::FObjectFinderOptional<UStaticMesh> PlaneMesh;
+		ConstructorHelpers::FObjectFinderOptional<UMaterialInterface> TextureMaterial;
+		FConstructorStatics()
+			: PlaneMesh(TEXT("/Engine/BasicShapes/Plane.Plane"))
+			, TextureMaterial(TEXT("/Engine/EngineMaterials/Widget3DPassThrough_Opaque.Widget3DPassThrough_Opaque"))
+		{
+		}
+	};
+	static FConstructorStatics ConstructorStatics;
+
+	SetStaticMesh(ConstructorStatics.PlaneMesh.Get());
+	BaseMaterial = ConstructorStatics.TextureMaterial.Get();
+	SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	SetVisibility(false);
+}
+
+void UColourWarsBoardTexture::UpdateCell(const FColourWarsBoard& Board, int32 Index)
+{
+	if (!IsBuiltFor(Board))
+	{
+		Rebuild(Board);
+		return;
+	}
+
+	UpdateTexel(Board, Index);
+}
+
+/// <summary>
+/// Marks are for cells of the board shown before, so they are dropped
+/// </summary>
+void UColourWarsBoardTexture::Rebuild(const FColourWarsBoard& Board)
+{
+	Size = Board.GetSize();
+	TilesPerSide = (Size + TileSize - 1) / TileSize;
+	Marks.Reset();
+
+	Texels.SetNumUninitialized(Size * Size);
+	for (int32 Index = 0; Index < Board.GetNumCells(); Index++)
+	{
+		const IntVector Coord = Board.ToCoord(Index);
+		Texels[Coord.Y * Size + Coord.X] = GetCellColour(Board, Index, eCellMark::None);
+	}
+
+	DirtyTiles.Init(true, TilesPerSide * TilesPerSide);
+	bDirty = true;
+}
+
+void UColourWarsBoardTexture::SetSelection(const FColourWarsBoard& Board, const TArray<int32>& SelectedCells, const TArray<int32>& SelectableCells)
+{
+	if (!IsBuiltFor(Board))
+	{
+		Rebuild(Board);
+	}
+
+	TArray<int32> OldCells;
+	Marks.GetKeys(OldCells);
+	Marks.Reset();
+
+	for (int32 Index : SelectableCells)
+	{
+		Marks.Add(Index, eCellMark::Selectable);
+	}
+
+	for (int32 Index : SelectedCells)
+	{
+		Marks.Add(Index, eCellMark::Selected);
+	}
+
+	for (int32 Index : OldCells)
+	{
+		UpdateTexel(Board, Index);
+	}
+
+	for (const TPair<int32, eCellMark>& Mark : Marks)
+	{
+		UpdateTexel(Board, Mark.Key);
+	}
+}
+
+/// <summary>
+/// The engine plane is 100 units across
+/// </summary>
+void UColourWarsBoardTexture::SetBoardWidth(float Width)
+{
+	SetRelativeScale3D(FVector(Width / 100.f, Width / 100.f, 1.f));
+}
+
+/// <summary>
+/// Create the texture for the board's size if it has changed, then copy the changed tiles to the render thread, which
+/// frees the copy once it has uploaded it. Dirty tiles next to each other in a row are uploaded as one region, and
+/// the regions are stacked one above the other in the copy.
+/// </summary>
+void UColourWarsBoardTexture::Flush()
+{
+	if (!bDirty || Size == 0)
+	{
+		return;
+	}
+
+	if (Texture == nullptr || Texture->GetSizeX() != Size)
+	{
+		Texture = UTexture2D::CreateTransient(Size, Size, PF_B8G8R8A8);
+		Texture->Filter = TF_Nearest;
+		Texture->SRGB = true;
+		Texture->UpdateResource();
+
+		if (Material == nullptr)
+		{
+			Material = UMaterialInstanceDynamic::Create(BaseMaterial, this);
+			SetMaterial(0, Material);
+		}
+		Material->SetTextureParameterValue("SlateUI", Texture);
+	}
+
+	TArray<FUpdateTextureRegion2D> Regions;
+	int32 CopyWidth = 0;
+	for (int32 TileV = 0; TileV < TilesPerSide; TileV++)
+	{
+		for (int32 TileU = 0; TileU < TilesPerSide; TileU++)
+		{
+			if (!DirtyTiles[TileV * TilesPerSide + TileU])
+			{
+				continue;
+			}
+
+			int32 EndTileU = TileU;
+			while (EndTileU < TilesPerSide && DirtyTiles[TileV * TilesPerSide + EndTileU])
+			{
+				DirtyTiles[TileV * TilesPerSide + EndTileU] = false;
+				EndTileU++;
+			}
+
+			const int32 DestX = TileU * TileSize;
+			const int32 DestY = TileV * TileSize;
+			const int32 Width = FMath::Min(EndTileU * TileSize, Size) - DestX;
+			const int32 Height = FMath::Min(DestY + TileSize, Size) - DestY;
+			Regions.Emplace(DestX, DestY, 0, Regions.Num() * TileSize, Width, Height);
+			CopyWidth = FMath::Max(CopyWidth, Width);
+
+			TileU = EndTileU;
+		}
+	}
+
+	uint8* Data = static_cast<uint8*>(FMemory::Malloc(CopyWidth * Regions.Num() * TileSize * sizeof(FColor)));
+	for (const FUpdateTextureRegion2D& Region : Regions)
+	{
+		for (uint32 Row = 0; Row < Region.Height; Row++)
+		{
+			FMemory::Memcpy(Data + ((Region.SrcY + Row) * CopyWidth) * sizeof(FColor),
+				&Texels[(Region.DestY + Row) * Size + Region.DestX], Region.Width * sizeof(FColor));
+		}
+	}
+
+	FUpdateTextureRegion2D* RegionsCopy = new FUpdateTextureRegion2D[Regions.Num()];
+	FMemory::Memcpy(RegionsCopy, Regions.GetData(), Regions.Num() * sizeof(FUpdateTextureRegion2D));
+	Texture->UpdateTextureRegions(0, Regions.Num(), RegionsCopy, CopyWidth * sizeof(FColor), sizeof(FColor), Data,
+		[](uint8* SrcData, const FUpdateTextureRegion2D* SrcRegions)
+		{
+			FMemory::Free(SrcData);
+			delete[] SrcRegions;
+		});
+
+	bDirty = false;
+}
+
+void UColourWarsBoardTexture::UpdateTexel(const FColourWarsBoard& Board, int32 Index)
+{
+	const IntVector Coord = Board.ToCoord(Index);
+	const eCellMark* Mark = Marks.Find(Index);
+	const FColor Colour = GetCellColour(Board, Index, Mark != nullptr ? *Mark : eCellMark::None);
+
+	FColor& Texel = Texels[Coord.Y * Size + Coord.X];
+	if (Texel != Colour)
+	{
+		Texel = Colour;
+		DirtyTiles[(Coord.Y / TileSize) * TilesPerSide + Coord.X / TileSize] = true;
+		bDirty = true;
+	}
+}
+
+FColor UColourWarsBoardTexture::GetCellColour(const FColourWarsBoard& Board, int32 Index, eCellMark Mark)
+{
+	FVector Colour = Board.IsCapitalBlock(Index) ? FVector(1.f, 1.f, 1.f) : AColourWarsBlock::GetScoreColour(Board.GetBlockType(Index), Board.GetScore(Index));
+	if (Mark != eCellMark::None)
+	{
+		Colour = FMath::Lerp(Colour, FVector(1.f, 1.f, 1.f), Mark == eCellMark::Selected ? SelectedLightening : SelectableLightening);
+	}
+
+	return FLinearColor(Colour).ToFColor(true);
+}
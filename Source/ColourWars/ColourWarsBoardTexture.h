@@ -0,0 +1,88 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/StaticMeshComponent.h"
+#include "ColourWarsBoard.h"
+#include "ColourWarsBoardTexture.generated.h"
+
+/**
+ * The whole board drawn as a single texture on a quad, a texel per cell, for boards or zooms where cells are too
+ * small on screen for blocks to be worth drawing. However large the board, this is one draw call.
+ *
+ * Each texel is the colour of the cell's owner, darker for lower scores, or white for a capital, lightened if the
+ * cell is selected or can be selected. Like the threat map, the texels are kept up to date a cell at a time as the
+ * board changes. The texture is split into tiles and only the tiles with changed texels are uploaded, and only while
+ * the texture is shown. Texel (U, V) is the cell at grid coordinate (U, V), and the quad lies along X and Y.
+ */
+UCLASS(minimalapi)
+class UColourWarsBoardTexture : public UStaticMeshComponent
+{
+	GENERATED_BODY()
+
+public:
+	/** Texels along each side of the tiles uploaded when they change */
+	static const int32 TileSize = 32;
+
+	UColourWarsBoardTexture();
+
+	/** Bring the texel of a cell up to date, call after the cell has been written */
+	void UpdateCell(const FColourWarsBoard& Board, int32 Index);
+
+	/** Work out every texel of the board */
+	void Rebuild(const FColourWarsBoard& Board);
+
+	/** Are the texels worked out for a board of this size */
+	bool IsBuiltFor(const FColourWarsBoard& Board) const { return Size == Board.GetSize(); }
+
+	/** Show which cells are selected and which can be selected, in place of those shown before */
+	void SetSelection(const FColourWarsBoard& Board, const TArray<int32>& SelectedCells, const TArray<int32>& SelectableCells);
+
+	/** Scale the quad to the width of the board */
+	void SetBoardWidth(float Width);
+
+	/** Upload the tiles with texels that have changed since the last upload */
+	void Flush();
+
+private:
+	/** How a cell is marked for selection */
+	enum class eCellMark : uint8
+	{
+		None,
+		Selectable,
+		Selected
+	};
+
+	/** Material showing the texture, an unlit engine material with a texture parameter */
+	UPROPERTY()
+		class UMaterialInterface* BaseMaterial;
+
+	UPROPERTY()
+		class UMaterialInstanceDynamic* Material;
+
+	UPROPERTY()
+		class UTexture2D* Texture;
+
+	int32 Size = 0;
+
+	int32 TilesPerSide = 0;
+
+	/** Colour of every cell, by texel */
+	TArray<FColor> Texels;
+
+	/** Cells marked for selection, by cell index */
+	TMap<int32, eCellMark> Marks;
+
+	/** Have texels of each tile changed since the last upload */
+	TArray<bool> DirtyTiles;
+
+	/** Has any tile changed since the last upload */
+	bool bDirty = false;
+
+	/** Work out the texel of a cell and mark its tile if it changed */
+	void UpdateTexel(const FColourWarsBoard& Board, int32 Index);
+
+	/** Colour of the texel of a cell */
+	static FColor GetCellColour(const FColourWarsBoard& Board, int32 Index, eCellMark Mark);
+};
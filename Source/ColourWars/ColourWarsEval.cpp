@@ -0,0 +1,234 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsEval.h"
+#include "Async/ParallelFor.h"
+#include "Misc/ConfigCacheIni.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogColourWarsEval, Log, All);
+
+namespace
+{
+	/** Fewest positions worth spreading over worker threads */
+	const int32 MinParallelBatch = 64;
+
+	/** Relative features of a player from the features of every player, false if the position is decided */
+	bool MakeRelative(const FColourWarsEvalFeatures (&Features)[5], int32 NumberOfPlayers, eBlockType Player, FColourWarsEvalFeatures& OutFeatures)
+	{
+		const int32 PlayerInt = static_cast<int32>(Player);
+		if (Features[PlayerInt][EColourWarsEvalFeature::Territory] == 0.f)
+		{
+			return false;
+		}
+
+		FColourWarsEvalFeatures Opponents;
+		int32 NumOpponents = 0;
+		for (int32 Opponent = 1; Opponent <= NumberOfPlayers; Opponent++)
+		{
+			if (Opponent == PlayerInt || Features[Opponent][EColourWarsEvalFeature::Territory] == 0.f)
+			{
+				continue;
+			}
+
+			for (int32 Feature = 0; Feature < FColourWarsEvalFeatures::Num; Feature++)
+			{
+				Opponents.Values[Feature] += Features[Opponent].Values[Feature];
+			}
+			NumOpponents++;
+		}
+
+		if (NumOpponents == 0)
+		{
+			return false;
+		}
+
+		for (int32 Feature = 0; Feature < FColourWarsEvalFeatures::Num; Feature++)
+		{
+			OutFeatures.Values[Feature] = Features[PlayerInt].Values[Feature] - Opponents.Values[Feature] / NumOpponents;
+		}
+
+		return true;
+	}
+}
+
+const TCHAR* const FColourWarsEvalWeights::ConfigSection = TEXT("ColourWars.Evaluation");
+
+FColourWarsEvalWeights::FColourWarsEvalWeights()
+{
+	// Used when the ini has no weights, roughly what the tuner finds on 10x10 boards
+	Weights[static_cast<int32>(EColourWarsEvalFeature::Material)] = 0.02f;
+	Weights[static_cast<int32>(EColourWarsEvalFeature::Territory)] = 0.08f;
+	Weights[static_cast<int32>(EColourWarsEvalFeature::CapitalSafety)] = 0.5f;
+	Weights[static_cast<int32>(EColourWarsEvalFeature::Frontier)] = -0.03f;
+	Weights[static_cast<int32>(EColourWarsEvalFeature::PendingSquares)] = 0.15f;
+}
+
+const TCHAR* FColourWarsEvalWeights::GetFeatureName(int32 Feature)
+{
+	const TCHAR* const Names[] = { TEXT("Material"), TEXT("Territory"), TEXT("CapitalSafety"), TEXT("Frontier"), TEXT("PendingSquares") };
+	static_assert(UE_ARRAY_COUNT(Names) == FColourWarsEvalFeatures::Num, "Every feature needs a name");
+
+	return Feature >= 0 && Feature < FColourWarsEvalFeatures::Num ? Names[Feature] : TEXT("");
+}
+
+bool FColourWarsEvalWeights::LoadFromFile(const FString& Filename)
+{
+	FConfigFile File;
+	File.Read(Filename);
+	if (File.Find(ConfigSection) == nullptr)
+	{
+		return false;
+	}
+
+	for (int32 Feature = 0; Feature < FColourWarsEvalFeatures::Num; Feature++)
+	{
+		FString Value;
+		if (File.GetString(ConfigSection, GetFeatureName(Feature), Value))
+		{
+			Weights[Feature] = FCString::Atof(*Value);
+		}
+	}
+
+	return true;
+}
+
+bool FColourWarsEvalWeights::SaveToFile(const FString& Filename) const
+{
+	FConfigFile File;
+	for (int32 Feature = 0; Feature < FColourWarsEvalFeatures::Num; Feature++)
+	{
+		File.SetString(ConfigSection, GetFeatureName(Feature), *FString::SanitizeFloat(Weights[Feature]));
+	}
+
+	return File.Write(Filename, false);
+}
+
+const FColourWarsEvalWeights& FColourWarsEvalWeights::GetDefault()
+{
+	static const FColourWarsEvalWeights Default = []()
+	{
+		FColourWarsEvalWeights Loaded;
+		for (int32 Feature = 0; Feature < FColourWarsEvalFeatures::Num; Feature++)
+		{
+			GConfig->GetFloat(ConfigSection, GetFeatureName(Feature), Loaded.Weights[Feature], GGameIni);
+		}
+
+		FString Filename;
+		if (FParse::Value(FCommandLine::Get(), TEXT("EvalWeights="), Filename) && !Loaded.LoadFromFile(Filename))
+		{
+			UE_LOG(LogColourWarsEval, Warning, TEXT("No [%s] weights in '%s', using the ones from the game ini."), ConfigSection, *Filename);
+		}
+
+		return Loaded;
+	}();
+
+	return Default;
+}
+
+constexpr float FColourWarsEval::WinScore;
+
+FColourWarsEval::FColourWarsEval(const FColourWarsEvalWeights& InWeights)
+	: Weights(InWeights)
+{
+}
+
+/// <summary>
+/// Work out the features of every player: one pass over the cells for territory, capitals and frontier, with the
+/// material from the vector score kernel, then one over each 2x2 square for the pending square bonuses.
+/// </summary>
+void FColourWarsEval::GetFeatures(const FColourWarsBoard& Board, FColourWarsEvalFeatures (&OutFeatures)[5])
+{
+	int32 Material[5];
+	Board.GetPlayerScores(Material);
+
+	int32 Territory[5] = {};
+	int32 CapitalSafety[5] = {};
+	int32 Frontier[5] = {};
+	int32 PendingSquares[5] = {};
+
+	for (int32 Index = 0; Index < Board.GetNumCells(); Index++)
+	{
+		const eBlockType BlockType = Board.GetBlockType(Index);
+		if (BlockType == eBlockType::None)
+		{
+			continue;
+		}
+
+		int32 Threats = 0;
+		Board.ForEachNeighbour(Index, false, [&Board, Index, BlockType, &Threats](int32 NeighbourIndex)
+		{
+			const eBlockType NeighbourType = Board.GetBlockType(NeighbourIndex);
+			if (NeighbourType != eBlockType::None && NeighbourType != BlockType && Board.CanDefeat(NeighbourIndex, Index))
+			{
+				Threats++;
+			}
+		});
+
+		const int32 Player = static_cast<int32>(BlockType);
+		Territory[Player]++;
+		Frontier[Player] += Threats > 0 ? Board.GetScore(Index) : 0;
+		CapitalSafety[Player] += Board.IsCapitalBlock(Index) ? 1 - Threats : 0;
+	}
+
+	for (int32 X = 0; X < Board.GetSize() - 1; X++)
+	{
+		for (int32 Y = 0; Y < Board.GetSize() - 1; Y++)
+		{
+			const uint8 Square[4] =
+			{
+				static_cast<uint8>(Board.GetBlockType(Board.ToIndex(X, Y))),
+				static_cast<uint8>(Board.GetBlockType(Board.ToIndex(X + 1, Y))),
+				static_cast<uint8>(Board.GetBlockType(Board.ToIndex(X, Y + 1))),
+				static_cast<uint8>(Board.GetBlockType(Board.ToIndex(X + 1, Y + 1)))
+			};
+
+			// With three of one type it is either the first or second cell's type
+			const uint8 Majority = Square[0] == Square[1] || Square[0] == Square[2] ? Square[0] : Square[1];
+			const int32 Count = (Square[0] == Majority) + (Square[1] == Majority) + (Square[2] == Majority) + (Square[3] == Majority);
+			PendingSquares[Majority] += Count == 3 ? 1 : 0;
+		}
+	}
+
+	for (int32 Player = 0; Player < 5; Player++)
+	{
+		FColourWarsEvalFeatures& Features = OutFeatures[Player];
+		Features[EColourWarsEvalFeature::Material] = Material[Player];
+		Features[EColourWarsEvalFeature::Territory] = Territory[Player];
+		Features[EColourWarsEvalFeature::CapitalSafety] = CapitalSafety[Player];
+		Features[EColourWarsEvalFeature::Frontier] = Frontier[Player];
+		Features[EColourWarsEvalFeature::PendingSquares] = Player != 0 ? PendingSquares[Player] : 0;
+	}
+}
+
+bool FColourWarsEval::GetRelativeFeatures(const FColourWarsBoard& Board, eBlockType Player, FColourWarsEvalFeatures& OutFeatures)
+{
+	FColourWarsEvalFeatures Features[5];
+	GetFeatures(Board, Features);
+	return MakeRelative(Features, Board.GetNumberOfPlayers(), Player, OutFeatures);
+}
+
+float FColourWarsEval::Evaluate(const FColourWarsBoard& Board, eBlockType Player) const
+{
+	FColourWarsEvalFeatures Relative;
+	if (!GetRelativeFeatures(Board, Player, Relative))
+	{
+		return Board.HasBlocks(Player) ? WinScore : -WinScore;
+	}
+
+	float Score = 0.f;
+	for (int32 Feature = 0; Feature < FColourWarsEvalFeatures::Num; Feature++)
+	{
+		Score += Weights.Weights[Feature] * Relative.Values[Feature];
+	}
+
+	return Score;
+}
+
+void FColourWarsEval::Evaluate(const TArray<const FColourWarsBoard*>& Boards, TArray<float>& OutScores) const
+{
+	OutScores.SetNumUninitialized(Boards.Num());
+
+	ParallelFor(Boards.Num(), [this, &Boards, &OutScores](int32 Index)
+	{
+		OutScores[Index] = Evaluate(*Boards[Index], Boards[Index]->GetCurrentPlayer());
+	}, Boards.Num() < MinParallelBatch);
+}
@@ -0,0 +1,94 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColourWarsBoard.h"
+
+/** Position features the evaluation weighs, each worked out for every player */
+enum class EColourWarsEvalFeature : uint8
+{
+	/** Sum of the player's block scores */
+	Material,
+
+	/** Number of cells the player owns */
+	Territory,
+
+	/** 1 for each capital held, less 1 for each neighbouring enemy block that could take it */
+	CapitalSafety,
+
+	/** Sum of the scores of the player's blocks that a neighbouring enemy block could take, at its AttackingCost */
+	Frontier,
+
+	/** 2x2 squares where the player owns three of the cells, one take away from a square bonus */
+	PendingSquares,
+
+	Num
+};
+
+/** Value of every feature for one player */
+struct COLOURWARS_API FColourWarsEvalFeatures
+{
+	static const int32 Num = static_cast<int32>(EColourWarsEvalFeature::Num);
+
+	float Values[Num];
+
+	FColourWarsEvalFeatures() { FMemory::Memzero(Values); }
+
+	float& operator[](EColourWarsEvalFeature Feature) { return Values[static_cast<int32>(Feature)]; }
+	float operator[](EColourWarsEvalFeature Feature) const { return Values[static_cast<int32>(Feature)]; }
+};
+
+/**
+ * Weight of each feature. The evaluation is the weighted sum of a player's features less the mean of its
+ * opponents', so it reads as the log odds of the player winning.
+ */
+struct COLOURWARS_API FColourWarsEvalWeights
+{
+	FColourWarsEvalWeights();
+
+	float Weights[FColourWarsEvalFeatures::Num];
+
+	/** Ini section the weights are kept in, one key per feature */
+	static const TCHAR* const ConfigSection;
+
+	static const TCHAR* GetFeatureName(int32 Feature);
+
+	/** Read the weights from an ini file such as one written by the tuner, leaving any missing ones as they are */
+	bool LoadFromFile(const FString& Filename);
+
+	bool SaveToFile(const FString& Filename) const;
+
+	/** Weights from DefaultGame.ini, or from the ini file given on the command line with -EvalWeights=<file> */
+	static const FColourWarsEvalWeights& GetDefault();
+};
+
+/** Static evaluation of positions, for bots and hints */
+class COLOURWARS_API FColourWarsEval
+{
+public:
+	/** Score of a won position, and minus that of a lost one */
+	static constexpr float WinScore = 1000.f;
+
+	explicit FColourWarsEval(const FColourWarsEvalWeights& InWeights = FColourWarsEvalWeights::GetDefault());
+
+	/** Features of every player in one pass over the board, indexed by eBlockType */
+	static void GetFeatures(const FColourWarsBoard& Board, FColourWarsEvalFeatures (&OutFeatures)[5]);
+
+	/**
+	 * A player's features less the mean of those of the opponents that still have blocks. Returns false when the
+	 * position is already decided, because the player or all of its opponents have no blocks left.
+	 */
+	static bool GetRelativeFeatures(const FColourWarsBoard& Board, eBlockType Player, FColourWarsEvalFeatures& OutFeatures);
+
+	/** Score of the position for a player, higher is better */
+	float Evaluate(const FColourWarsBoard& Board, eBlockType Player) const;
+
+	/** Score each position for its current player, spread over worker threads when there are enough of them */
+	void Evaluate(const TArray<const FColourWarsBoard*>& Boards, TArray<float>& OutScores) const;
+
+	const FColourWarsEvalWeights& GetWeights() const { return Weights; }
+
+private:
+	FColourWarsEvalWeights Weights;
+};
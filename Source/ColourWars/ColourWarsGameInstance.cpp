@@ -2,4 +2,37 @@
 
 
 #include "ColourWarsGameInstance.h"
+#include "ColourWarsOpeningBook.h"
+#include "Misc/Paths.h"
 
+void UColourWarsGameInstance::Init()
+{
+	Super::Init();
+
+	FColourWarsOpeningBook::MountAll(FPaths::ProjectContentDir() / TEXT("OpeningBooks"));
+}
+
+bool UColourWarsGameInstance::HasSavedGame()
+{
+	return FColourWarsSnapshot::DoesSlotExist();
+}
+
+bool UColourWarsGameInstance::LoadSavedGame()
+{
+	TUniquePtr<FColourWarsSnapshot> Snapshot = MakeUnique<FColourWarsSnapshot>();
+	if (!Snapshot->LoadFromSlot())
+	{
+		return false;
+	}
+
+	GameGridSize = Snapshot->Board.GetSize();
+	NumberOfPlayers = Snapshot->Board.GetNumberOfPlayers();
+	ResumeSnapshot = MoveTemp(Snapshot);
+
+	return true;
+}
+
+TUniquePtr<FColourWarsSnapshot> UColourWarsGameInstance::TakeResumeSnapshot()
+{
+	return MoveTemp(ResumeSnapshot);
+}
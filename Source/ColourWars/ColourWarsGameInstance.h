@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Engine/GameInstance.h"
+#include "ColourWarsSnapshot.h"
 #include "ColourWarsGameInstance.generated.h"
 
 /**
@@ -15,10 +16,36 @@ class COLOURWARS_API UColourWarsGameInstance : public UGameInstance
 	GENERATED_BODY()
 
 public:
+	/** Mount the opening books in Content/OpeningBooks */
+	virtual void Init() override;
+
 	UPROPERTY(Category = "Game", EditAnywhere, BlueprintReadWrite)
 		int32 NumberOfPlayers = 2;
 
 	UPROPERTY(Category = "Game", EditAnywhere, BlueprintReadWrite)
 		int32 GameGridSize = 5;
 
+	/** Seed for the next match, 0 picks one from the clock */
+	UPROPERTY(Category = "Game", EditAnywhere, BlueprintReadWrite)
+		int32 Seed = 0;
+
+	/** Record every match to a replay file in Saved/Replays */
+	UPROPERTY(Category = "Game", EditAnywhere, BlueprintReadWrite)
+		bool bRecordReplays = true;
+
+	/** Is there a match in progress that can be resumed */
+	UFUNCTION(BlueprintCallable, Category = "Game")
+		bool HasSavedGame();
+
+	/** Load the saved match so the next game grid resumes it, setting the grid size and number of players to match */
+	UFUNCTION(BlueprintCallable, Category = "Game")
+		bool LoadSavedGame();
+
+	/** Take the loaded match to resume, if there is one */
+	TUniquePtr<FColourWarsSnapshot> TakeResumeSnapshot();
+
+private:
+	/** Match loaded by LoadSavedGame, waiting for the game grid to be created */
+	TUniquePtr<FColourWarsSnapshot> ResumeSnapshot;
+
 };
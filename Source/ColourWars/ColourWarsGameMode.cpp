@@ -9,6 +9,9 @@
 #include "ColourWarsGameState.h"
 #include "Engine/World.h"
 #include "Kismet/GameplayStatics.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Paths.h"
+#include "ColourWarsSnapshot.h"
 
 AColourWarsGameMode::AColourWarsGameMode()
 {
@@ -23,45 +26,149 @@ AColourWarsGameMode::AColourWarsGameMode()
 void AColourWarsGameMode::BeginPlay()
 {
 	Super::BeginPlay();
+
+	// Mobile apps are often closed from the background without any further warning, so save then
+	FCoreDelegates::ApplicationWillEnterBackgroundDelegate.AddUObject(this, &AColourWarsGameMode::SaveGame);
+	FCoreDelegates::ApplicationWillTerminateDelegate.AddUObject(this, &AColourWarsGameMode::SaveGame);
 }
 
-void AColourWarsGameMode::NextTurn()
+void AColourWarsGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	GameState->MakeMove();
+	FCoreDelegates::ApplicationWillEnterBackgroundDelegate.RemoveAll(this);
+	FCoreDelegates::ApplicationWillTerminateDelegate.RemoveAll(this);
 
-	ApplyCapitalBlockBonus();
+	SaveGame();
 
-	// Deselect the selected blocks
-	GameState->DeselectAllBlocks();
+	ReplayWriter.Finish();
 
-	GameState->GetGameGrid()->UpdateScore();
+	Super::EndPlay(EndPlayReason);
+}
+
+void AColourWarsGameMode::InitGameState()
+{
+	Super::InitGameState();
 
-	// Switch current player block type to next type
-	IncrementPlayer();
+	// Open the level with ?Lockstep to only send moves and board hashes instead of the board
+	GetGameState()->SetLockstep(UGameplayStatics::HasOption(OptionsString, TEXT("Lockstep")));
 }
 
-void AColourWarsGameMode::IncrementPlayer()
+void AColourWarsGameMode::PostLogin(APlayerController* NewPlayer)
 {
-	int32 playerInt = static_cast<int32>(GameState->GetCurrentPlayer());
-	int32 previousPlayerInt = static_cast<int32>(GameState->GetCurrentPlayer());
+	Super::PostLogin(NewPlayer);
 
-	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, TEXT("Setting next player."));
+	// Players in an online match are given the next free colour, anyone after that spectates
+	AColourWarsPlayerController* PlayerController = Cast<AColourWarsPlayerController>(NewPlayer);
+	if (PlayerController == nullptr || GetNetMode() == NM_Standalone)
+	{
+		return;
+	}
 
-	// Increment player and check if they have blocks left and if not increment again until a player does
-	do
+	// Lockstep turns only go to the peers that are connected, so one that joins a match already under way is sent
+	// the board as it is now and plays on from there
+	AColourWarsBlockGrid* Grid = GetGameState()->GetGameGrid();
+	if (GetGameState()->IsLockstep() && Grid != nullptr && Grid->HasSpawnedBlocks())
 	{
-		playerInt++;
+		GetGameState()->ReplicateBoard();
+	}
 
-		if (playerInt > GetNumberOfPlayers())
+	for (int32 PlayerIndex = 1; PlayerIndex <= GetNumberOfPlayers(); PlayerIndex++)
+	{
+		const eBlockType Seat = static_cast<eBlockType>(PlayerIndex);
+		bool bSeatTaken = false;
+		for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
 		{
-			playerInt = 1;
+			AColourWarsPlayerController* Other = Cast<AColourWarsPlayerController>(Iterator->Get());
+			bSeatTaken |= Other != nullptr && Other->GetSeat() == Seat;
 		}
 
-		GameState->SetCurrentPlayer(static_cast<eBlockType>(playerInt));
-	} while (!GameState->GetGameGrid()->HasBlocks(GameState->GetCurrentPlayer()));
+		if (!bSeatTaken)
+		{
+			PlayerController->SetSeat(Seat);
+			return;
+		}
+	}
+}
+
+bool AColourWarsGameMode::PlayTurn(AColourWarsPlayerController* Player, const FColourWarsMove& Move)
+{
+	AColourWarsBlockGrid* Grid = GameState->GetGameGrid();
+
+	// Moves from clients are checked against the server's board before they are played
+	if (GameState->GetGameOver() || !Player->CanPlayFor(GameState->GetCurrentPlayer()) || !Grid->GetBoard().IsLegalMove(Move))
+	{
+		return false;
+	}
+
+	// Record the turn from the position it is played in
+	ReplayWriter.RecordTurn(Move, Grid->GetBoard());
+
+	// Make the move, apply the capital block bonus and switch to the next player
+	Grid->PlayTurn(Move);
+
+	if (GameState->IsLockstep())
+	{
+		GameState->BroadcastLockstepTurn(Move);
+	}
+
+	// Deselect the selected blocks
+	GameState->DeselectAllBlocks();
+
+	Grid->UpdateScore();
+
+	UpdateCurrentPlayer();
+
+	return true;
+}
+
+void AColourWarsGameMode::UndoTurn()
+{
+	AColourWarsBlockGrid* Grid = GameState->GetGameGrid();
+
+	// The other players of an online match have already seen the turn, and a finished match has closed its replay
+	// and deleted its save
+	if (!Grid->CanUndo() || GetNetMode() != NM_Standalone || GameState->GetGameOver())
+	{
+		return;
+	}
+
+	GameState->DeselectAllBlocks();
+
+	Grid->UndoTurn();
+	ReplayWriter.UndoTurn();
+
+	Grid->UpdateScore();
+
+	UpdateCurrentPlayer();
+}
+
+void AColourWarsGameMode::RedoTurn()
+{
+	AColourWarsBlockGrid* Grid = GameState->GetGameGrid();
+	if (!Grid->CanRedo() || GetNetMode() != NM_Standalone)
+	{
+		return;
+	}
+
+	GameState->DeselectAllBlocks();
+
+	ReplayWriter.RecordTurn(Grid->GetRedoMove(), Grid->GetBoard());
+	Grid->RedoTurn();
+
+	Grid->UpdateScore();
+
+	UpdateCurrentPlayer();
+}
+
+void AColourWarsGameMode::UpdateCurrentPlayer()
+{
+	FColourWarsBoard& Board = GameState->GetGameGrid()->GetBoard();
+
+	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, TEXT("Setting next player."));
+
+	GameState->SetCurrentPlayer(Board.GetCurrentPlayer());
 
 	// If it is still the same players turn after incrementing this means that it is the only player left
-	if (previousPlayerInt == static_cast<int32>(GameState->GetCurrentPlayer()))
+	if (Board.IsGameOver())
 	{
 		GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, TEXT("Game over."));
 		EndGame(GameState->GetCurrentPlayer());
@@ -73,14 +180,29 @@ void AColourWarsGameMode::IncrementPlayer()
 	GameState->RefreshGameGrid();
 }
 
-void AColourWarsGameMode::ApplyCapitalBlockBonus()
+void AColourWarsGameMode::EndGame(eBlockType BlockType)
 {
-	GameState->GetGameGrid()->ApplyCapitalBlocksBonus();
+	GetGameState()->SetGameOver(true);
+
+	ReplayWriter.Finish();
+
+	// A finished match can not be resumed
+	FColourWarsSnapshot::DeleteSlot();
 }
 
-void AColourWarsGameMode::EndGame(eBlockType BlockType)
+void AColourWarsGameMode::SaveGame()
 {
-	GetGameState()->SetGameOver(true);
+	AColourWarsBlockGrid* Grid = GameState != nullptr ? GameState->GetGameGrid() : nullptr;
+	if (Grid == nullptr || GameState->GetGameOver())
+	{
+		return;
+	}
+
+	FColourWarsSnapshot Snapshot;
+	Snapshot.Seed = Grid->GetMatchSeed();
+	Snapshot.SelectedMove = GameState->GetSelectedMove();
+	Snapshot.Board = Grid->GetBoard();
+	Snapshot.SaveToSlot();
 }
 
 void AColourWarsGameMode::SetGameGrid(AColourWarsBlockGrid* grid)
@@ -116,12 +238,41 @@ AColourWarsGameState* AColourWarsGameMode::GetGameState()
 
 void AColourWarsGameMode::BeginGame()
 {
-	GameState->SetCurrentPlayer(eBlockType::Red);
+	GetGameState()->SetCurrentPlayer(eBlockType::Red);
 
 	GameState->DeselectAllBlocks();
 
 	GameState->SetSelectedMove(eMoveType::Move);
 
 	GameState->RefreshGameGrid();
+
+	StartReplay();
+}
+
+void AColourWarsGameMode::ResumeGame(eMoveType SelectedMove)
+{
+	FColourWarsBoard& Board = GetGameState()->GetGameGrid()->GetBoard();
+
+	GameState->SetCurrentPlayer(Board.GetCurrentPlayer());
+
+	GameState->SetGameOver(Board.IsGameOver());
+
+	GameState->DeselectAllBlocks();
+
+	GameState->SetSelectedMove(SelectedMove);
+
+	GameState->RefreshGameGrid();
+
+	StartReplay();
+}
+
+void AColourWarsGameMode::StartReplay()
+{
+	if (GameInstance != nullptr && GameInstance->bRecordReplays)
+	{
+		AColourWarsBlockGrid* Grid = GameState->GetGameGrid();
+		const FString Filename = FPaths::ProjectSavedDir() / TEXT("Replays") / FDateTime::Now().ToString() + TEXT(".cwreplay");
+		ReplayWriter.Begin(Filename, Grid->GetMatchSeed(), Grid->GetBoard());
+	}
 }
 
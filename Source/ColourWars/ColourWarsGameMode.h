@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "ColourWarsBlock.h"
 #include "ColourWarsGameState.h"
+#include "ColourWarsReplay.h"
 #include "GameFramework/GameModeBase.h"
 #include "ColourWarsGameMode.generated.h"
 
@@ -17,14 +18,26 @@ class AColourWarsGameMode : public AGameModeBase
 protected:
 	// Begin AActor interface
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	// End AActor interface
 
+	// Begin AGameModeBase interface
+	virtual void InitGameState() override;
+	virtual void PostLogin(APlayerController* NewPlayer) override;
+	// End AGameModeBase interface
+
 private:
 	int32 NumberOfPlayers;
 
+	/** Records the turns of the current match */
+	FColourWarsReplayWriter ReplayWriter;
+
 	/** Pointer to game state */
 	AColourWarsGameState* GameState;
 
+	/** Start recording the match to a new replay file, if replays are turned on */
+	void StartReplay();
+
 public:
 	AColourWarsGameMode();
 
@@ -32,11 +45,17 @@ public:
 	UPROPERTY()
 		class UColourWarsGameInstance* GameInstance;
 	
-	void NextTurn();
+	/** Play the move for the player if it is their turn and the move is legal */
+	bool PlayTurn(class AColourWarsPlayerController* Player, const FColourWarsMove& Move);
 
-	void IncrementPlayer();
-	
-	void ApplyCapitalBlockBonus();
+	/** Take back the last turn, unless the game is over */
+	void UndoTurn();
+
+	/** Play the last undone turn again */
+	void RedoTurn();
+
+	/** Show whichever player the board says is next, ending the game if they are the only one left */
+	void UpdateCurrentPlayer();
 
 	void EndGame(eBlockType BlockType);
 
@@ -49,6 +68,12 @@ public:
 
 	void BeginGame();
 
+	/** Carry on a saved match once the game grid has spawned its board */
+	void ResumeGame(eMoveType SelectedMove);
+
+	/** Save the match in progress so it can be resumed */
+	void SaveGame();
+
 };
 
 
@@ -2,6 +2,17 @@
 
 
 #include "ColourWarsGameState.h"
+#include "ColourWarsPlayerController.h"
+#include "Kismet/GameplayStatics.h"
+#include "Net/UnrealNetwork.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogColourWarsNet, Log, All);
+
+namespace
+{
+	/** Turns the server keeps its lockstep hash for, a client that reports a turn later than this is not checked */
+	const int32 LockstepHashWindow = 256;
+}
 
 const TMap<eMoveType, int32> AColourWarsGameState::NumberBlocksRequired
 {
@@ -15,6 +26,8 @@ AColourWarsGameState::AColourWarsGameState()
 {
 	// Set starting player
 	//CurrentPlayer = eBlockType::Red;
+
+	NetBoard.Owner = this;
 }
 
 void AColourWarsGameState::BeginPlay()
@@ -22,6 +35,15 @@ void AColourWarsGameState::BeginPlay()
 	Super::BeginPlay();
 }
 
+void AColourWarsGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AColourWarsGameState, NetBoard);
+	DOREPLIFETIME(AColourWarsGameState, NetTurnState);
+	DOREPLIFETIME(AColourWarsGameState, bLockstep);
+}
+
 void AColourWarsGameState::SetGameGrid(AColourWarsBlockGrid* grid)
 {
 	GameGrid = grid;
@@ -64,6 +86,11 @@ bool AColourWarsGameState::GetGameOver()
 void AColourWarsGameState::SetGameOver(bool gameOver)
 {
 	GameOver = gameOver;
+
+	if (HasAuthority() && !bLockstep)
+	{
+		UpdateNetTurnState();
+	}
 }
 
 eBlockType AColourWarsGameState::GetCurrentPlayer()
@@ -74,6 +101,16 @@ eBlockType AColourWarsGameState::GetCurrentPlayer()
 void AColourWarsGameState::SetCurrentPlayer(eBlockType blockType)
 {
 	CurrentPlayer = blockType;
+
+	if (GameGrid != nullptr)
+	{
+		GameGrid->GetBoard().SetCurrentPlayer(blockType);
+	}
+
+	if (HasAuthority() && !bLockstep)
+	{
+		UpdateNetTurnState();
+	}
 }
 
 TArray<AColourWarsBlock*> AColourWarsGameState::GetSelectedBlocks()
@@ -163,23 +200,41 @@ void AColourWarsGameState::RefreshGameGrid()
 	GameGrid->SetSelectableBlocks(SelectedMove, SelectedBlocks);
 }
 
-void AColourWarsGameState::MakeMove()
+/// <summary>
+/// Only the blocks that are selected are deselected, so showing a move costs the same on any size of board
+/// </summary>
+void AColourWarsGameState::SelectTurnMove(const FColourWarsMove& Move)
 {
-	if (MoveIsValid())
+	for (AColourWarsBlock* block : SelectedBlocks)
 	{
-		switch (SelectedMove)
-		{
-			case eMoveType::AddOne:
-				GetGameGrid()->AddOneToBlock(SelectedBlocks[0]);
-				break;
-			case eMoveType::Move:
-				GetGameGrid()->MoveBlock(SelectedBlocks[0], SelectedBlocks[1]);
-				break;
-			case eMoveType::Combine:
-				GetGameGrid()->CombineNeighbourBlocks(SelectedBlocks[0]);
-				break;
-		}
+		block->SetBlockDeselected();
+	}
+	SelectedBlocks.Reset();
+
+	SelectedMove = Move.MoveType;
+	SelectBlock(GameGrid->GetBlock(Move.From));
+	if (Move.MoveType == eMoveType::Move)
+	{
+		SelectBlock(GameGrid->GetBlock(Move.To));
 	}
+
+	GameGrid->SetSelectableBlocks(SelectedMove, SelectedBlocks);
+}
+
+FColourWarsMove AColourWarsGameState::GetSelectedTurnMove()
+{
+	if (!MoveIsValid())
+	{
+		return FColourWarsMove();
+	}
+
+	FColourWarsMove Move(SelectedMove, SelectedBlocks[0]->GetGridCoord());
+	if (SelectedMove == eMoveType::Move)
+	{
+		Move.To = SelectedBlocks[1]->GetGridCoord();
+	}
+
+	return Move;
 }
 
 bool AColourWarsGameState::MoveIsValid() 
@@ -204,5 +259,171 @@ bool AColourWarsGameState::MoveIsValid()
 	return false;
 }
 
+void AColourWarsGameState::ReplicateBoard()
+{
+	NetBoard.Reset(GameGrid->GetBoard());
+
+	UpdateNetTurnState();
+}
+
+void AColourWarsGameState::ReplicateTurn(const FColourWarsTurnDelta& Delta)
+{
+	NetBoard.UpdateCells(GameGrid->GetBoard(), Delta);
+}
+
+void AColourWarsGameState::UpdateNetTurnState()
+{
+	if (GameGrid == nullptr)
+	{
+		return;
+	}
+
+	const FColourWarsBoard& Board = GameGrid->GetBoard();
+	NetTurnState.Size = Board.GetSize();
+	NetTurnState.NumberOfPlayers = Board.GetNumberOfPlayers();
+	NetTurnState.Turn = Board.GetTurn();
+	NetTurnState.CurrentPlayer = Board.GetCurrentPlayer();
+	NetTurnState.bGameOver = Board.IsGameOver();
+}
+
+void AColourWarsGameState::OnNetCellChanged(const FColourWarsNetCell& Cell)
+{
+	// Cells that arrive before the grid has spawned are picked up from NetBoard when it does. A lockstep client's
+	// board only moves on by playing turns, the cells are only sent again for peers that join part way through.
+	if (GameGrid != nullptr && GameGrid->HasSpawnedBlocks() && !bLockstep)
+	{
+		GameGrid->SetNetCell(Cell);
+	}
+}
+
+void AColourWarsGameState::OnRep_NetTurnState()
+{
+	if (GameGrid == nullptr || NetTurnState.Size == 0)
+	{
+		return;
+	}
+
+	if (!GameGrid->HasSpawnedBlocks())
+	{
+		GameGrid->SpawnNetGame();
+	}
+	else if (bLockstep)
+	{
+		// A lockstep client's board only moves on by playing turns
+		return;
+	}
+
+	GameGrid->GetBoard().SetTurnFlow(NetTurnState.CurrentPlayer, NetTurnState.Turn, NetTurnState.bGameOver);
+	CurrentPlayer = NetTurnState.CurrentPlayer;
+	GameOver = NetTurnState.bGameOver;
+
+	DeselectAllBlocks();
+
+	GameGrid->UpdateScore();
+
+	GameGrid->SetPlayerTurnMeshColour();
+
+	RefreshGameGrid();
+
+	if (bLockstep)
+	{
+		PlayLockstepTurns();
+	}
+}
+
+void AColourWarsGameState::BroadcastLockstepTurn(const FColourWarsMove& Move)
+{
+	const FColourWarsBoard& Board = GameGrid->GetBoard();
+
+	FColourWarsNetTurn NetTurn;
+	NetTurn.Turn = Board.GetTurn() - 1;
+	NetTurn.MoveType = Move.MoveType;
+	NetTurn.From = Board.ToIndex(Move.From);
+	NetTurn.To = Board.ToIndex(Move.To);
+
+	// Turns are broadcast one after another, so dropping the turn that has left the window keeps the map its size
+	LockstepHashes.Add(NetTurn.Turn, Board.GetHash());
+	LockstepHashes.Remove(NetTurn.Turn - LockstepHashWindow);
+
+	MulticastLockstepTurn(NetTurn);
+}
+
+void AColourWarsGameState::MulticastLockstepTurn_Implementation(const FColourWarsNetTurn& NetTurn)
+{
+	// The server has already played the turn
+	if (HasAuthority())
+	{
+		return;
+	}
+
+	PendingLockstepTurns.Add(NetTurn);
+	PlayLockstepTurns();
+}
+
+void AColourWarsGameState::PlayLockstepTurns()
+{
+	// Turns can arrive before the starting board has
+	if (GameGrid == nullptr || !GameGrid->HasSpawnedBlocks())
+	{
+		return;
+	}
 
+	FColourWarsBoard& Board = GameGrid->GetBoard();
+	AColourWarsPlayerController* PlayerController = Cast<AColourWarsPlayerController>(UGameplayStatics::GetPlayerController(GetWorld(), 0));
 
+	int32 TurnIndex = 0;
+	for (; TurnIndex < PendingLockstepTurns.Num(); TurnIndex++)
+	{
+		const FColourWarsNetTurn& NetTurn = PendingLockstepTurns[TurnIndex];
+
+		// Turns from before the starting board was sent are already part of it
+		if (NetTurn.Turn < Board.GetTurn())
+		{
+			continue;
+		}
+
+		if (NetTurn.Turn > Board.GetTurn() || NetTurn.From < 0 || NetTurn.From >= Board.GetNumCells() || NetTurn.To < 0 || NetTurn.To >= Board.GetNumCells())
+		{
+			break;
+		}
+
+		GameGrid->PlayTurn(FColourWarsMove(NetTurn.MoveType, Board.ToCoord(NetTurn.From), Board.ToCoord(NetTurn.To)));
+
+		if (PlayerController != nullptr)
+		{
+			PlayerController->ServerReportHash(NetTurn.Turn, Board.GetHash());
+		}
+	}
+
+	if (TurnIndex == 0)
+	{
+		return;
+	}
+
+	PendingLockstepTurns.RemoveAt(0, TurnIndex);
+
+	CurrentPlayer = Board.GetCurrentPlayer();
+	GameOver = Board.IsGameOver();
+
+	DeselectAllBlocks();
+
+	GameGrid->UpdateScore();
+
+	GameGrid->SetPlayerTurnMeshColour();
+
+	RefreshGameGrid();
+}
+
+void AColourWarsGameState::CheckLockstepHash(AColourWarsPlayerController* Player, int32 Turn, uint64 Hash)
+{
+	const uint64* ServerHash = LockstepHashes.Find(Turn);
+	if (ServerHash == nullptr || *ServerHash == Hash)
+	{
+		return;
+	}
+
+	UE_LOG(LogColourWarsNet, Error, TEXT("%s desynced playing turn %d: board hash %016llx, server has %016llx."),
+		*Player->GetName(), Turn, Hash, *ServerHash);
+
+	Player->ClientReportDesync(Turn);
+}
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "ColourWarsBlock.h"
 #include "ColourWarsBlockGrid.h"
+#include "ColourWarsNetBoard.h"
 #include "GameFramework/GameStateBase.h"
 #include "ColourWarsGameState.generated.h"
 
@@ -19,11 +20,12 @@ class COLOURWARS_API AColourWarsGameState : public AGameStateBase
 protected:
 	// Begin AActor interface
 	virtual void BeginPlay() override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 	// End AActor interface
 
 private:
 
-	eMoveType SelectedMove;
+	eMoveType SelectedMove = eMoveType::Move;
 
 	TArray<AColourWarsBlock*> SelectedBlocks;
 
@@ -36,6 +38,30 @@ private:
 
 	void SelectBlock(AColourWarsBlock* block);
 
+	/** Cells of the server's board, clients build their board from these */
+	UPROPERTY(Replicated)
+		FColourWarsNetBoard NetBoard;
+
+	/** Turn flow of the server's board */
+	UPROPERTY(ReplicatedUsing = OnRep_NetTurnState)
+		FColourWarsNetTurnState NetTurnState;
+
+	/** Copy the server's turn flow into NetTurnState */
+	void UpdateNetTurnState();
+
+	/** Peers play each turn themselves, only the moves and board hashes are sent */
+	UPROPERTY(Replicated)
+		bool bLockstep = false;
+
+	/** Hash of the server's board after playing each of the last turns of a lockstep match, to check clients against */
+	TMap<int32, uint64> LockstepHashes;
+
+	/** Turns received by a client that could not be played yet */
+	TArray<FColourWarsNetTurn> PendingLockstepTurns;
+
+	/** Play every pending turn that follows on from the client's board */
+	void PlayLockstepTurns();
+
 public:
 
 	const static TMap<eMoveType, int32> NumberBlocksRequired;
@@ -77,9 +103,43 @@ public:
 
 	void RefreshGameGrid();
 
-	void MakeMove();
+	/** Get the selected move as a turn, an Invalid move if not enough blocks are selected */
+	FColourWarsMove GetSelectedTurnMove();
+
+	/** Select the move and blocks of a turn, as if the player had clicked them, e.g. to show a hint */
+	void SelectTurnMove(const FColourWarsMove& Move);
 
 	UFUNCTION(BlueprintCallable, BluePrintPure)
 		bool MoveIsValid();
 
+	/** Send every cell of the board to clients, when a match starts or a peer joins a lockstep match */
+	void ReplicateBoard();
+
+	/** Send the cells a turn changed to clients */
+	void ReplicateTurn(const FColourWarsTurnDelta& Delta);
+
+	bool IsLockstep() const { return bLockstep; }
+
+	void SetLockstep(bool bInLockstep) { bLockstep = bInLockstep; }
+
+	/** Send the move just played on the server's board to every client of a lockstep match */
+	void BroadcastLockstepTurn(const FColourWarsMove& Move);
+
+	/** Compare a client's board hash after a turn with the server's, reporting the turn they diverged at */
+	void CheckLockstepHash(class AColourWarsPlayerController* Player, int32 Turn, uint64 Hash);
+
+	UFUNCTION(NetMulticast, Reliable)
+		void MulticastLockstepTurn(const FColourWarsNetTurn& NetTurn);
+
+	const FColourWarsNetBoard& GetNetBoard() const { return NetBoard; }
+
+	const FColourWarsNetTurnState& GetNetTurnState() const { return NetTurnState; }
+
+	/** Update the client's board as a cell arrives from the server */
+	void OnNetCellChanged(const FColourWarsNetCell& Cell);
+
+	/** Show the client's board once the server has moved on to the next turn */
+	UFUNCTION()
+		void OnRep_NetTurnState();
+
 };
@@ -0,0 +1,139 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsKernels.h"
+#include "Math/VectorRegister.h"
+
+namespace
+{
+	/** Bytes of a packed int that each lane keeps */
+	const VectorRegisterInt LaneBytes = MakeVectorRegisterInt(0x000000FF, 0x0000FF00, 0x00FF0000, (int32)0xFF000000);
+
+	/** Four block types, each in the byte of its own lane */
+	FORCEINLINE VectorRegisterInt LoadTypes(const uint8* BlockTypes)
+	{
+		int32 Packed;
+		FMemory::Memcpy(&Packed, BlockTypes, sizeof(Packed));
+		return VectorIntAnd(VectorIntSet1(Packed), LaneBytes);
+	}
+
+	/** A block type in the byte of each lane, to compare against LoadTypes */
+	FORCEINLINE VectorRegisterInt SplatType(uint8 BlockType)
+	{
+		return VectorIntAnd(VectorIntSet1(BlockType * 0x01010101), LaneBytes);
+	}
+
+	/** Same as FColourWarsBoard::GetSumNeighboursScores, for the cells along the edges */
+	int32 SumNeighbourhood(const int32* Scores, const uint8* BlockTypes, int32 Size, int32 X, int32 Y)
+	{
+		const int32 Central = X * Size + Y;
+		const uint8 CentralType = BlockTypes[Central];
+		if (CentralType == 0)
+		{
+			return 0;
+		}
+
+		int32 ScoreSum = Scores[Central];
+		for (int32 NeighbourX = FMath::Max(X - 1, 0); NeighbourX <= FMath::Min(X + 1, Size - 1); NeighbourX++)
+		{
+			for (int32 NeighbourY = FMath::Max(Y - 1, 0); NeighbourY <= FMath::Min(Y + 1, Size - 1); NeighbourY++)
+			{
+				const int32 Neighbour = NeighbourX * Size + NeighbourY;
+				if (Neighbour != Central && BlockTypes[Neighbour] == CentralType)
+				{
+					ScoreSum += Scores[Neighbour] - 1;
+				}
+			}
+		}
+
+		return ScoreSum;
+	}
+}
+
+void ColourWarsKernels::SumScoresByType(const int32* Scores, const uint8* BlockTypes, int32 NumCells, int32 (&OutSums)[5])
+{
+	VectorRegisterInt TypeLanes[4];
+	VectorRegisterInt Sums[4];
+	for (int32 Type = 1; Type < 5; Type++)
+	{
+		TypeLanes[Type - 1] = SplatType(Type);
+		Sums[Type - 1] = GlobalVectorConstants::IntZero;
+	}
+
+	int32 Index = 0;
+	for (; Index + 4 <= NumCells; Index += 4)
+	{
+		const VectorRegisterInt CellScores = VectorIntLoad(Scores + Index);
+		const VectorRegisterInt CellTypes = LoadTypes(BlockTypes + Index);
+
+		for (int32 Type = 0; Type < 4; Type++)
+		{
+			Sums[Type] = VectorIntAdd(Sums[Type], VectorIntAnd(CellScores, VectorIntCompareEQ(CellTypes, TypeLanes[Type])));
+		}
+	}
+
+	OutSums[0] = 0;
+	for (int32 Type = 1; Type < 5; Type++)
+	{
+		int32 Lanes[4];
+		VectorIntStore(Sums[Type - 1], Lanes);
+		OutSums[Type] = Lanes[0] + Lanes[1] + Lanes[2] + Lanes[3];
+	}
+
+	for (; Index < NumCells; Index++)
+	{
+		OutSums[BlockTypes[Index]] += Scores[Index];
+	}
+
+	OutSums[0] = 0;
+}
+
+/// <summary>
+/// Sum the 3x3 neighbourhood of every cell. The inner columns of each row are done four cells at a time,
+/// reading each of the 9 offsets as one vector; the first and last columns and any leftover cells are summed
+/// one by one, as are the top and bottom rows, so no vector ever reads past the board.
+/// </summary>
+void ColourWarsKernels::SumNeighbourhoods(const int32* Scores, const uint8* BlockTypes, int32 Size, int32* OutSums)
+{
+	const VectorRegisterInt One = GlobalVectorConstants::IntOne;
+
+	for (int32 X = 0; X < Size; X++)
+	{
+		int32 Y = 0;
+		if (X > 0 && X < Size - 1)
+		{
+			OutSums[X * Size] = SumNeighbourhood(Scores, BlockTypes, Size, X, 0);
+
+			for (Y = 1; Y + 4 <= Size - 1; Y += 4)
+			{
+				const int32 Central = X * Size + Y;
+				const VectorRegisterInt CentralTypes = LoadTypes(BlockTypes + Central);
+				VectorRegisterInt ScoreSum = VectorIntLoad(Scores + Central);
+
+				for (int32 OffsetX = -Size; OffsetX <= Size; OffsetX += Size)
+				{
+					for (int32 OffsetY = -1; OffsetY <= 1; OffsetY++)
+					{
+						const int32 Neighbour = Central + OffsetX + OffsetY;
+						if (Neighbour == Central)
+						{
+							continue;
+						}
+
+						const VectorRegisterInt SameType = VectorIntCompareEQ(LoadTypes(BlockTypes + Neighbour), CentralTypes);
+						const VectorRegisterInt Score = VectorIntSubtract(VectorIntLoad(Scores + Neighbour), One);
+						ScoreSum = VectorIntAdd(ScoreSum, VectorIntAnd(Score, SameType));
+					}
+				}
+
+				// Empty cells have no Combine
+				const VectorRegisterInt Empty = VectorIntCompareEQ(CentralTypes, GlobalVectorConstants::IntZero);
+				VectorIntStore(VectorIntAndNot(Empty, ScoreSum), OutSums + Central);
+			}
+		}
+
+		for (; Y < Size; Y++)
+		{
+			OutSums[X * Size + Y] = SumNeighbourhood(Scores, BlockTypes, Size, X, Y);
+		}
+	}
+}
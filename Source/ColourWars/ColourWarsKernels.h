@@ -0,0 +1,23 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Whole-board kernels over the packed score and block type arrays of a board, four cells per vector.
+ *
+ * Block types are one byte per cell, so four of them are read as one int and each lane keeps its own byte
+ * with a mask. Lanes of the same byte position can then be compared directly, with no widening or shuffles.
+ */
+namespace ColourWarsKernels
+{
+	/** Sum of the scores of each block type, indexed by eBlockType with None left at 0 */
+	COLOURWARS_API void SumScoresByType(const int32* Scores, const uint8* BlockTypes, int32 NumCells, int32 (&OutSums)[5]);
+
+	/**
+	 * Result of a Combine on every cell of a Size x Size row-major board: the cell's score plus each same type
+	 * neighbour's score less 1, including diagonals. Empty cells get 0. OutSums must hold Size * Size ints.
+	 */
+	COLOURWARS_API void SumNeighbourhoods(const int32* Scores, const uint8* BlockTypes, int32 Size, int32* OutSums);
+}
@@ -0,0 +1,209 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsLayoutBenchmarkCommandlet.h"
+#include "ColourWarsBoard.h"
+#include "Math/RandomStream.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogColourWarsLayoutBenchmark, Log, All);
+
+namespace
+{
+	/** Times of one layout, in nanoseconds per cell or move and milliseconds per board */
+	struct FLayoutTimes
+	{
+		double CombineNanoseconds = 0.0;
+		double MoveNanoseconds = 0.0;
+		double LegalMovesMilliseconds = 0.0;
+
+		/** Sum of everything worked out, so the layouts can be checked to agree and nothing is optimised away */
+		int64 Checksum = 0;
+	};
+
+	/** Parse a comma separated list of numbers */
+	void ParseList(const FString& List, TArray<int32>& OutValues)
+	{
+		TArray<FString> Items;
+		List.ParseIntoArray(Items, TEXT(","));
+		for (const FString& Item : Items)
+		{
+			OutValues.Add(FCString::Atoi(*Item));
+		}
+	}
+
+	/**
+	 * Fill a board of the layout with random blocks, a cell at a time by coordinate so every layout gets the same
+	 * position, then time each operation at the same cells. Moves are played without the end of turn steps, as the
+	 * capital bonus scans the whole board and would hide the cost of the move.
+	 */
+	FLayoutTimes TimeLayout(int32 Size, int32 NumberOfPlayers, eCellLayout Layout, const TArray<IntVector>& Cells, int32 Seed)
+	{
+		FLayoutTimes Times;
+
+		FColourWarsBoard Board;
+		Board.Init(Size, NumberOfPlayers, Layout);
+
+		FRandomStream Random(Seed);
+		for (int32 X = 0; X < Size; X++)
+		{
+			for (int32 Y = 0; Y < Size; Y++)
+			{
+				Board.SetCell(Board.ToIndex(X, Y), static_cast<eBlockType>(Random.RandRange(1, NumberOfPlayers)), Random.RandRange(1, 9), false);
+			}
+		}
+
+		double StartTime = FPlatformTime::Seconds();
+		for (const IntVector& Cell : Cells)
+		{
+			Times.Checksum += Board.GetSumNeighboursScores(Board.ToIndex(Cell));
+		}
+		Times.CombineNanoseconds = (FPlatformTime::Seconds() - StartTime) * 1e9 / Cells.Num();
+
+		const int32 Offsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+		StartTime = FPlatformTime::Seconds();
+		for (int32 CellIndex = 0; CellIndex < Cells.Num(); CellIndex++)
+		{
+			const IntVector& Cell = Cells[CellIndex];
+			FColourWarsMove Move(eMoveType::AddOne, Cell);
+			if (CellIndex % 3 == 1)
+			{
+				Move.MoveType = eMoveType::Combine;
+			}
+			else if (CellIndex % 3 == 2)
+			{
+				const int32 (&Offset)[2] = Offsets[CellIndex % 4];
+				Move = FColourWarsMove(eMoveType::Move, Cell, IntVector(Cell.X + Offset[0], Cell.Y + Offset[1]));
+			}
+
+			Board.SetCurrentPlayer(Board.GetBlockType(Board.ToIndex(Cell)));
+			if (Board.IsLegalMove(Move))
+			{
+				Board.MakeMove(Move);
+			}
+		}
+		Times.MoveNanoseconds = (FPlatformTime::Seconds() - StartTime) * 1e9 / Cells.Num();
+
+		for (int32 X = 0; X < Size; X++)
+		{
+			for (int32 Y = 0; Y < Size; Y++)
+			{
+				Times.Checksum += Board.GetScore(Board.ToIndex(X, Y)) * (X + 1) + Y;
+			}
+		}
+
+		TArray<FColourWarsMove> Moves;
+		Moves.Reserve(Board.GetNumCells() * 6);
+		Board.SetCurrentPlayer(eBlockType::Red);
+		StartTime = FPlatformTime::Seconds();
+		Board.GetLegalMoves(Moves);
+		Times.LegalMovesMilliseconds = (FPlatformTime::Seconds() - StartTime) * 1e3;
+		Times.Checksum += Moves.Num();
+
+		return Times;
+	}
+
+	/**
+	 * Play random turns from the start of a chunked board of the largest size and report how much of it was stored.
+	 * Only the chunks around the capitals are ever written, so the turns and the memory follow the contested area.
+	 */
+	void RunConquest(int32 NumberOfPlayers, int32 Count, int32 Seed)
+	{
+		const int32 Size = FColourWarsBoard::MaxChunkedSize;
+
+		FColourWarsBoard Board;
+		Board.Init(Size, NumberOfPlayers, eCellLayout::Chunked);
+
+		FRandomStream Random(Seed);
+		TArray<FColourWarsMove> Moves;
+		int32 Turns = 0;
+		const double StartTime = FPlatformTime::Seconds();
+		for (; Turns < Count && !Board.IsGameOver(); Turns++)
+		{
+			Moves.Reset();
+			Board.GetLegalMoves(Moves);
+			Board.ApplyTurn(Moves.Num() > 0 ? Moves[Random.RandRange(0, Moves.Num() - 1)] : FColourWarsMove());
+		}
+		const double Microseconds = (FPlatformTime::Seconds() - StartTime) * 1e6 / FMath::Max(Turns, 1);
+
+		// A score, a type and a capital flag per stored cell
+		const int32 BytesPerCell = sizeof(int32) + sizeof(uint8) + sizeof(uint8);
+		const double StoredMegabytes = static_cast<double>(Board.GetNumChunks()) * FColourWarsBoard::ChunkCells * BytesPerCell / (1024.0 * 1024.0);
+		const double DenseMegabytes = static_cast<double>(Board.GetNumCells()) * BytesPerCell / (1024.0 * 1024.0);
+
+		UE_LOG(LogColourWarsLayoutBenchmark, Display, TEXT("%dx%d chunked: %d turns at %.1f us, %d of %d chunks stored (%.2f MB, %.0f MB dense)."),
+			Size, Size, Turns, Microseconds, Board.GetNumChunks(), (Size / FColourWarsBoard::ChunkSize) * (Size / FColourWarsBoard::ChunkSize),
+			StoredMegabytes, DenseMegabytes);
+	}
+}
+
+UColourWarsLayoutBenchmarkCommandlet::UColourWarsLayoutBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UColourWarsLayoutBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString SizeList = TEXT("256,1024");
+	int32 NumberOfPlayers = 4;
+	int32 Count = 1000000;
+	int32 Seed = 1;
+	FParse::Value(*Params, TEXT("Sizes="), SizeList, false);
+	FParse::Value(*Params, TEXT("Players="), NumberOfPlayers);
+	FParse::Value(*Params, TEXT("Count="), Count);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+
+	if (FParse::Param(*Params, TEXT("Conquest")))
+	{
+		if (NumberOfPlayers < 2 || NumberOfPlayers > 4 || Count < 1)
+		{
+			UE_LOG(LogColourWarsLayoutBenchmark, Error, TEXT("Need 2 to 4 players and a count of at least 1."));
+			return 1;
+		}
+
+		RunConquest(NumberOfPlayers, Count, Seed);
+		return 0;
+	}
+
+	TArray<int32> Sizes;
+	ParseList(SizeList, Sizes);
+
+	const bool bValidSizes = Sizes.Num() > 0 && !Sizes.ContainsByPredicate([](int32 Size)
+	{
+		return Size < FColourWarsBoard::MinMortonSize || Size > FColourWarsBoard::MaxSize || !FMath::IsPowerOfTwo(Size);
+	});
+	if (!bValidSizes || NumberOfPlayers < 2 || NumberOfPlayers > 4 || Count < 1)
+	{
+		UE_LOG(LogColourWarsLayoutBenchmark, Error, TEXT("Need power of two sizes of %d to %d, 2 to 4 players and a count of at least 1."),
+			FColourWarsBoard::MinMortonSize, FColourWarsBoard::MaxSize);
+		return 1;
+	}
+
+	for (int32 Size : Sizes)
+	{
+		FRandomStream Random(Seed);
+		TArray<IntVector> Cells;
+		Cells.Reserve(Count);
+		for (int32 CellIndex = 0; CellIndex < Count; CellIndex++)
+		{
+			Cells.Emplace(Random.RandRange(0, Size - 1), Random.RandRange(0, Size - 1));
+		}
+
+		const FLayoutTimes RowMajor = TimeLayout(Size, NumberOfPlayers, eCellLayout::RowMajor, Cells, Seed);
+		const FLayoutTimes Morton = TimeLayout(Size, NumberOfPlayers, eCellLayout::Morton, Cells, Seed);
+
+		UE_LOG(LogColourWarsLayoutBenchmark, Display, TEXT("%dx%d row-major: Combine sum %.1f ns, move %.1f ns, legal moves %.2f ms."),
+			Size, Size, RowMajor.CombineNanoseconds, RowMajor.MoveNanoseconds, RowMajor.LegalMovesMilliseconds);
+		UE_LOG(LogColourWarsLayoutBenchmark, Display, TEXT("%dx%d Morton:    Combine sum %.1f ns, move %.1f ns, legal moves %.2f ms."),
+			Size, Size, Morton.CombineNanoseconds, Morton.MoveNanoseconds, Morton.LegalMovesMilliseconds);
+
+		if (RowMajor.Checksum != Morton.Checksum)
+		{
+			UE_LOG(LogColourWarsLayoutBenchmark, Error, TEXT("%dx%d: the layouts played differently."), Size, Size);
+			return 1;
+		}
+	}
+
+	return 0;
+}
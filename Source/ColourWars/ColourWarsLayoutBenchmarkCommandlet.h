@@ -0,0 +1,30 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ColourWarsLayoutBenchmarkCommandlet.generated.h"
+
+/**
+ * Times the rules on large boards laid out row by row and in Morton order, to show what the layout is worth.
+ *
+ * Usage: ColourWars -run=ColourWarsLayoutBenchmark [-Sizes=256,1024] [-Players=4] [-Count=1000000] [-Seed=1]
+ * Each size must be a power of two of at least FColourWarsBoard::MinMortonSize. Both layouts get the same random
+ * full board and the same Count random cells, then time Combine sums and moves at those cells, which read the 3x3
+ * and 2x2 neighbourhoods of cells all over the board, and generating every legal move, which reads the board in order.
+ *
+ * Usage: ColourWars -run=ColourWarsLayoutBenchmark -Conquest [-Players=4] [-Count=1000000] [-Seed=1]
+ * Plays Count random turns from the start of a FColourWarsBoard::MaxChunkedSize chunked board and reports how many of
+ * its chunks were stored.
+ */
+UCLASS()
+class UColourWarsLayoutBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UColourWarsLayoutBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
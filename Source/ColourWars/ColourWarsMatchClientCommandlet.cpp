@@ -0,0 +1,225 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsMatchClientCommandlet.h"
+#include "ColourWarsMatchServer.h"
+#include "Common/TcpSocketBuilder.h"
+#include "HAL/PlatformProcess.h"
+#include "Math/RandomStream.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogColourWarsClient, Log, All);
+
+namespace
+{
+	struct FClientMatch
+	{
+		FColourWarsBoard Board;
+
+		/** Move sent and waiting for the server to accept */
+		FColourWarsMove Move;
+
+		uint64 SentCycles = 0;
+	};
+
+	struct FClientConnection
+	{
+		FSocket* Socket = nullptr;
+
+		FColourWarsMatchFrameReader Reader;
+
+		TArray<uint8> SendBuffer;
+
+		TMap<int32, FClientMatch> Matches;
+	};
+}
+
+UColourWarsMatchClientCommandlet::UColourWarsMatchClientCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UColourWarsMatchClientCommandlet::Main(const FString& Params)
+{
+	FString ServerAddress = TEXT("127.0.0.1");
+	int32 Port = ColourWarsMatchProtocol::DefaultPort;
+	int32 NumConnections = 8;
+	int32 MatchesPerConnection = 32;
+	int32 Size = 10;
+	int32 NumberOfPlayers = 2;
+	int32 MaxTurns = 500;
+	float Duration = 30.f;
+	int32 Seed = 1;
+	FParse::Value(*Params, TEXT("Server="), ServerAddress);
+	FParse::Value(*Params, TEXT("Port="), Port);
+	FParse::Value(*Params, TEXT("Connections="), NumConnections);
+	FParse::Value(*Params, TEXT("Matches="), MatchesPerConnection);
+	FParse::Value(*Params, TEXT("Size="), Size);
+	FParse::Value(*Params, TEXT("Players="), NumberOfPlayers);
+	FParse::Value(*Params, TEXT("MaxTurns="), MaxTurns);
+	FParse::Value(*Params, TEXT("Duration="), Duration);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	TSharedRef<FInternetAddr> Address = SocketSubsystem->CreateInternetAddr();
+	bool bValidAddress = false;
+	Address->SetIp(*ServerAddress, bValidAddress);
+	Address->SetPort(Port);
+	if (!bValidAddress)
+	{
+		UE_LOG(LogColourWarsClient, Error, TEXT("'%s' is not an IP address."), *ServerAddress);
+		return 1;
+	}
+
+	FColourWarsMatchMessage CreateMatch;
+	CreateMatch.Type = EColourWarsMatchMessage::CreateMatch;
+	CreateMatch.Size = Size;
+	CreateMatch.NumberOfPlayers = NumberOfPlayers;
+
+	TArray<FClientConnection> Connections;
+	Connections.SetNum(NumConnections);
+	for (FClientConnection& Connection : Connections)
+	{
+		Connection.Socket = FTcpSocketBuilder(TEXT("ColourWarsMatchClient")).AsBlocking().Build();
+		if (Connection.Socket == nullptr || !Connection.Socket->Connect(*Address))
+		{
+			UE_LOG(LogColourWarsClient, Error, TEXT("Could not connect to %s."), *Address->ToString(true));
+			return 1;
+		}
+
+		Connection.Socket->SetNonBlocking(true);
+		Connection.Socket->SetNoDelay(true);
+
+		for (int32 MatchIndex = 0; MatchIndex < MatchesPerConnection; MatchIndex++)
+		{
+			CreateMatch.AppendFrame(Connection.SendBuffer);
+		}
+	}
+
+	FRandomStream Random(Seed);
+	TArray<FColourWarsMove> LegalMoves;
+	FColourWarsLatencyHistogram RoundTrips;
+	int64 NumTurns = 0;
+	int32 NumGames = 0;
+	int32 NumRejected = 0;
+	int32 NumDesyncs = 0;
+
+	// Play a random legal move, or pass when there is none
+	auto SendMove = [&Random, &LegalMoves](FClientConnection& Connection, int32 MatchId, FClientMatch& Match)
+	{
+		LegalMoves.Reset();
+		Match.Board.GetLegalMoves(LegalMoves);
+		Match.Move = LegalMoves.Num() > 0 ? LegalMoves[Random.RandHelper(LegalMoves.Num())] : FColourWarsMove();
+		Match.SentCycles = FPlatformTime::Cycles64();
+
+		FColourWarsMatchMessage Message;
+		Message.Type = EColourWarsMatchMessage::PlayTurn;
+		Message.MatchId = MatchId;
+		Message.Turn = Match.Board.GetTurn();
+		Message.MoveType = Match.Move.MoveType;
+		Message.From = Match.Board.ToIndex(Match.Move.From);
+		Message.To = Match.Board.ToIndex(Match.Move.To);
+		Message.AppendFrame(Connection.SendBuffer);
+	};
+
+	const double StartTime = FPlatformTime::Seconds();
+	while (!IsEngineExitRequested() && FPlatformTime::Seconds() - StartTime < Duration)
+	{
+		bool bDidWork = false;
+
+		for (FClientConnection& Connection : Connections)
+		{
+			if (!Connection.Reader.ReadFromSocket(*Connection.Socket) || Connection.Reader.IsCorrupt())
+			{
+				UE_LOG(LogColourWarsClient, Error, TEXT("Lost the connection to the server."));
+				return 1;
+			}
+
+			FColourWarsMatchMessage Message;
+			while (Connection.Reader.NextMessage(Message))
+			{
+				bDidWork = true;
+
+				if (Message.Type == EColourWarsMatchMessage::MatchCreated)
+				{
+					if (Message.MatchId == 0)
+					{
+						UE_LOG(LogColourWarsClient, Error, TEXT("The server refused to create a %dx%d match for %d players."), Size, Size, NumberOfPlayers);
+						return 1;
+					}
+
+					FClientMatch& Match = Connection.Matches.Add(Message.MatchId);
+					Match.Board.Init(Size, NumberOfPlayers);
+					NumDesyncs += Match.Board.GetHash() != Message.Hash ? 1 : 0;
+					SendMove(Connection, Message.MatchId, Match);
+					continue;
+				}
+
+				FClientMatch* Match = Connection.Matches.Find(Message.MatchId);
+				if (Message.Type != EColourWarsMatchMessage::TurnPlayed || Match == nullptr)
+				{
+					continue;
+				}
+
+				RoundTrips.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - Match->SentCycles) * 1000.0);
+				NumTurns++;
+
+				if (Message.bAccepted)
+				{
+					Match->Board.ApplyTurn(Match->Move);
+				}
+				NumRejected += Message.bAccepted ? 0 : 1;
+				NumDesyncs += Match->Board.GetHash() != Message.Hash ? 1 : 0;
+
+				if (!Message.bAccepted || Match->Board.IsGameOver() || Match->Board.GetTurn() >= MaxTurns)
+				{
+					if (!Match->Board.IsGameOver())
+					{
+						FColourWarsMatchMessage EndMatch;
+						EndMatch.Type = EColourWarsMatchMessage::EndMatch;
+						EndMatch.MatchId = Message.MatchId;
+						EndMatch.AppendFrame(Connection.SendBuffer);
+					}
+
+					Connection.Matches.Remove(Message.MatchId);
+					CreateMatch.AppendFrame(Connection.SendBuffer);
+					NumGames++;
+				}
+				else
+				{
+					SendMove(Connection, Message.MatchId, *Match);
+				}
+			}
+
+			if (!ColourWarsMatchProtocol::SendPending(*Connection.Socket, Connection.SendBuffer))
+			{
+				UE_LOG(LogColourWarsClient, Error, TEXT("Lost the connection to the server."));
+				return 1;
+			}
+		}
+
+		if (!bDidWork)
+		{
+			FPlatformProcess::Sleep(0.0002f);
+		}
+	}
+
+	for (FClientConnection& Connection : Connections)
+	{
+		Connection.Socket->Close();
+		SocketSubsystem->DestroySocket(Connection.Socket);
+	}
+
+	int64 Totals[FColourWarsLatencyHistogram::NumBuckets] = {};
+	RoundTrips.DrainInto(Totals);
+	const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+	UE_LOG(LogColourWarsClient, Display, TEXT("%lld turns in %d finished games, %.0f turns/s, p50 round trip %.3f ms, p99 %.3f ms, %d rejected, %d desynced."),
+		NumTurns, NumGames, NumTurns / Elapsed, FColourWarsLatencyHistogram::Percentile(Totals, 0.5) / 1000.0,
+		FColourWarsLatencyHistogram::Percentile(Totals, 0.99) / 1000.0, NumRejected, NumDesyncs);
+
+	return NumRejected == 0 && NumDesyncs == 0 ? 0 : 1;
+}
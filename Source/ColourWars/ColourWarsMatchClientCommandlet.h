@@ -0,0 +1,26 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ColourWarsMatchClientCommandlet.generated.h"
+
+/**
+ * Load test client for the match server, playing random legal moves in many matches over a few connections.
+ *
+ * Usage: ColourWars -run=ColourWarsMatchClient [-Server=127.0.0.1] [-Port=7777] [-Connections=8] [-Matches=32]
+ *        [-Size=10] [-Players=2] [-MaxTurns=500] [-Duration=30] [-Seed=1]
+ * Matches is per connection; a match that ends is replaced by a new one. Every reply's board hash is checked against
+ * the client's own board.
+ */
+UCLASS()
+class UColourWarsMatchClientCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UColourWarsMatchClientCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,170 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsMatchProtocol.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+FColourWarsMatchMessage::FColourWarsMatchMessage()
+	: Type(EColourWarsMatchMessage::CreateMatch)
+	, MatchId(0)
+	, Size(0)
+	, NumberOfPlayers(0)
+	, Turn(0)
+	, MoveType(eMoveType::Invalid)
+	, From(0)
+	, To(0)
+	, bAccepted(false)
+	, Hash(0)
+{
+}
+
+void FColourWarsMatchMessage::Serialize(FArchive& Ar)
+{
+	uint8 TypeByte = static_cast<uint8>(Type);
+	uint32 PackedMatchId = MatchId;
+	uint32 PackedSize = Size;
+	uint8 Players = NumberOfPlayers;
+	uint32 PackedTurn = Turn;
+	uint8 Move = static_cast<uint8>(MoveType);
+	uint32 PackedFrom = From;
+	uint32 PackedTo = To;
+	uint8 Accepted = bAccepted ? 1 : 0;
+
+	Ar << TypeByte;
+	Type = static_cast<EColourWarsMatchMessage>(TypeByte);
+
+	switch (Type)
+	{
+	case EColourWarsMatchMessage::CreateMatch:
+		Ar.SerializeIntPacked(PackedSize);
+		Ar << Players;
+		break;
+	case EColourWarsMatchMessage::MatchCreated:
+		Ar.SerializeIntPacked(PackedMatchId);
+		Ar << Hash;
+		break;
+	case EColourWarsMatchMessage::PlayTurn:
+		Ar.SerializeIntPacked(PackedMatchId);
+		Ar.SerializeIntPacked(PackedTurn);
+		Ar << Move;
+		Ar.SerializeIntPacked(PackedFrom);
+		Ar.SerializeIntPacked(PackedTo);
+		break;
+	case EColourWarsMatchMessage::TurnPlayed:
+		Ar.SerializeIntPacked(PackedMatchId);
+		Ar.SerializeIntPacked(PackedTurn);
+		Ar << Accepted;
+		Ar << Hash;
+		break;
+	case EColourWarsMatchMessage::EndMatch:
+		Ar.SerializeIntPacked(PackedMatchId);
+		break;
+	default:
+		Ar.SetError();
+		return;
+	}
+
+	if (Ar.IsLoading())
+	{
+		MatchId = PackedMatchId;
+		Size = PackedSize;
+		NumberOfPlayers = Players;
+		Turn = PackedTurn;
+		MoveType = static_cast<eMoveType>(Move);
+		From = PackedFrom;
+		To = PackedTo;
+		bAccepted = Accepted != 0;
+	}
+}
+
+void FColourWarsMatchMessage::AppendFrame(TArray<uint8>& OutBuffer) const
+{
+	const int32 FrameStart = OutBuffer.Num();
+
+	// Serialize only reads from the message when saving
+	FMemoryWriter Writer(OutBuffer, false, true);
+	uint32 FrameSize = 0;
+	Writer << FrameSize;
+	const_cast<FColourWarsMatchMessage*>(this)->Serialize(Writer);
+
+	FrameSize = OutBuffer.Num() - FrameStart - sizeof(uint32);
+	FMemory::Memcpy(OutBuffer.GetData() + FrameStart, &FrameSize, sizeof(uint32));
+}
+
+bool FColourWarsMatchFrameReader::ReadFromSocket(FSocket& Socket)
+{
+	uint32 PendingSize = 0;
+	while (Socket.HasPendingData(PendingSize))
+	{
+		const int32 ChunkSize = FMath::Min<uint32>(PendingSize, 64 * 1024);
+		const int32 Offset = Buffer.AddUninitialized(ChunkSize);
+
+		int32 BytesRead = 0;
+		if (!Socket.Recv(Buffer.GetData() + Offset, ChunkSize, BytesRead))
+		{
+			Buffer.SetNum(Offset, false);
+			return false;
+		}
+
+		Buffer.SetNum(Offset + BytesRead, false);
+	}
+
+	// A socket that is readable with nothing to read has been closed by the other end, data that arrived
+	// since the loop above is read next time
+	return !Socket.Wait(ESocketWaitConditions::WaitForRead, FTimespan::Zero()) || Socket.HasPendingData(PendingSize);
+}
+
+bool FColourWarsMatchFrameReader::NextMessage(FColourWarsMatchMessage& OutMessage)
+{
+	if (bCorrupt)
+	{
+		return false;
+	}
+
+	uint32 FrameSize = 0;
+	if (Buffer.Num() - ReadOffset >= (int32)sizeof(uint32))
+	{
+		FMemory::Memcpy(&FrameSize, Buffer.GetData() + ReadOffset, sizeof(uint32));
+		bCorrupt = FrameSize == 0 || FrameSize > ColourWarsMatchProtocol::MaxFrameSize;
+	}
+
+	if (bCorrupt || FrameSize == 0 || Buffer.Num() - ReadOffset < (int32)(sizeof(uint32) + FrameSize))
+	{
+		// Drop the messages already taken once there is no whole one left
+		Buffer.RemoveAt(0, ReadOffset, false);
+		ReadOffset = 0;
+		return false;
+	}
+
+	const int32 FrameEnd = ReadOffset + sizeof(uint32) + FrameSize;
+	FMemoryReader Reader(Buffer);
+	Reader.Seek(ReadOffset + sizeof(uint32));
+	OutMessage.Serialize(Reader);
+
+	bCorrupt = Reader.IsError() || Reader.Tell() != FrameEnd;
+	ReadOffset = FrameEnd;
+
+	return !bCorrupt;
+}
+
+bool ColourWarsMatchProtocol::SendPending(FSocket& Socket, TArray<uint8>& Buffer)
+{
+	if (Buffer.Num() == 0)
+	{
+		return true;
+	}
+
+	int32 BytesSent = 0;
+	if (!Socket.Send(Buffer.GetData(), Buffer.Num(), BytesSent))
+	{
+		if (ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() != SE_EWOULDBLOCK)
+		{
+			return false;
+		}
+	}
+
+	Buffer.RemoveAt(0, FMath::Max(BytesSent, 0), false);
+	return true;
+}
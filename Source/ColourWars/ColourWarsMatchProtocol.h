@@ -0,0 +1,99 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColourWarsBoard.h"
+
+class FSocket;
+
+/**
+ * Messages between the headless match server and its clients over TCP.
+ *
+ * Each message is framed by a uint32 byte count followed by a uint8 EColourWarsMatchMessage and its fields, with
+ * ints packed as in the replay format. The client keeps its own board and plays its moves on it as the server
+ * accepts them, so the board itself is never sent; the hash of the server's board is sent back to check against.
+ */
+namespace ColourWarsMatchProtocol
+{
+	const int32 DefaultPort = 7777;
+
+	/** Frames larger than this are refused rather than buffered */
+	const uint32 MaxFrameSize = 1024;
+
+	/** Largest board a match can be created with */
+	const int32 MaxSize = 64;
+
+	/** Send as much of the buffer as the socket takes and remove that from it, returns false once the connection is closed */
+	COLOURWARS_API bool SendPending(FSocket& Socket, TArray<uint8>& Buffer);
+}
+
+enum class EColourWarsMatchMessage : uint8
+{
+	/** Client to server: Size, NumberOfPlayers */
+	CreateMatch = 1,
+
+	/** Server to client: MatchId, or 0 if the match was refused, and Hash of the starting board */
+	MatchCreated,
+
+	/** Client to server: MatchId, Turn the move is played on, MoveType, From, To */
+	PlayTurn,
+
+	/** Server to client: MatchId, Turn after the move, bAccepted, Hash. The match is dropped once it is over */
+	TurnPlayed,
+
+	/** Client to server: MatchId */
+	EndMatch,
+};
+
+struct COLOURWARS_API FColourWarsMatchMessage
+{
+	FColourWarsMatchMessage();
+
+	EColourWarsMatchMessage Type;
+
+	int32 MatchId;
+
+	int32 Size;
+
+	int32 NumberOfPlayers;
+
+	int32 Turn;
+
+	eMoveType MoveType;
+
+	/** Cell indices of the move */
+	int32 From;
+	int32 To;
+
+	bool bAccepted;
+
+	uint64 Hash;
+
+	void Serialize(FArchive& Ar);
+
+	/** Append the framed message to a send buffer */
+	void AppendFrame(TArray<uint8>& OutBuffer) const;
+};
+
+/** Collects bytes from a socket and splits them into messages */
+class COLOURWARS_API FColourWarsMatchFrameReader
+{
+public:
+	/** Read whatever the socket has pending, returns false once the connection is closed */
+	bool ReadFromSocket(FSocket& Socket);
+
+	/** Take the next complete message, returns false when there is none or the stream is corrupt */
+	bool NextMessage(FColourWarsMatchMessage& OutMessage);
+
+	/** Was a frame refused, after which the connection should be dropped */
+	bool IsCorrupt() const { return bCorrupt; }
+
+private:
+	TArray<uint8> Buffer;
+
+	/** Bytes at the front of Buffer that have already been taken as messages */
+	int32 ReadOffset = 0;
+
+	bool bCorrupt = false;
+};
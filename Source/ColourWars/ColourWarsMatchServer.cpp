@@ -0,0 +1,466 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsMatchServer.h"
+#include "Common/TcpSocketBuilder.h"
+#include "Containers/Queue.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogColourWarsServer, Log, All);
+
+void FColourWarsLatencyHistogram::Add(double Microseconds)
+{
+	const int32 Bucket = FMath::Clamp((int32)(8.0 * FMath::Log2(1.0 + Microseconds)), 0, NumBuckets - 1);
+	Buckets[Bucket].Increment();
+}
+
+void FColourWarsLatencyHistogram::DrainInto(int64 (&Totals)[NumBuckets])
+{
+	for (int32 Bucket = 0; Bucket < NumBuckets; Bucket++)
+	{
+		Totals[Bucket] += Buckets[Bucket].Reset();
+	}
+}
+
+double FColourWarsLatencyHistogram::Percentile(const int64 (&Totals)[NumBuckets], double Fraction)
+{
+	int64 Count = 0;
+	for (int32 Bucket = 0; Bucket < NumBuckets; Bucket++)
+	{
+		Count += Totals[Bucket];
+	}
+
+	int64 Seen = 0;
+	for (int32 Bucket = 0; Bucket < NumBuckets; Bucket++)
+	{
+		Seen += Totals[Bucket];
+		if (Count > 0 && Seen >= Fraction * Count)
+		{
+			return FMath::Pow(2.0, (Bucket + 1) / 8.0) - 1.0;
+		}
+	}
+
+	return 0.0;
+}
+
+struct FColourWarsMatchServer::FConnection
+{
+	FSocket* Socket = nullptr;
+
+	FColourWarsMatchFrameReader Reader;
+
+	/** Framed replies from the workers, waiting to be sent */
+	TQueue<TArray<uint8>, EQueueMode::Mpsc> Replies;
+
+	/** Bytes the socket has not taken yet */
+	TArray<uint8> SendBuffer;
+
+	/** Matches the connection holds or has been sent to create, counted up when dispatched and down by the workers */
+	FThreadSafeCounter NumMatches;
+};
+
+struct FColourWarsMatchServer::FRequest
+{
+	FConnectionPtr Connection;
+
+	FColourWarsMatchMessage Message;
+
+	/** When the message was read, for the turn latency */
+	uint64 ReceivedCycles = 0;
+
+	/** Drop every match of the connection instead of handling the message */
+	bool bConnectionClosed = false;
+};
+
+class FColourWarsMatchServer::FWorker : public FRunnable
+{
+public:
+	FWorker(int32 WorkerIndex)
+	{
+		WakeUp = FPlatformProcess::GetSynchEventFromPool(false);
+		Thread = FRunnableThread::Create(this, *FString::Printf(TEXT("ColourWarsMatchWorker%d"), WorkerIndex));
+	}
+
+	virtual ~FWorker()
+	{
+		if (Thread != nullptr)
+		{
+			Thread->Kill(true);
+			delete Thread;
+		}
+
+		FPlatformProcess::ReturnSynchEventToPool(WakeUp);
+	}
+
+	void Enqueue(FRequest&& Request)
+	{
+		Requests.Enqueue(MoveTemp(Request));
+		WakeUp->Trigger();
+	}
+
+	virtual uint32 Run() override
+	{
+		FRequest Request;
+		while (!bStopping)
+		{
+			while (Requests.Dequeue(Request))
+			{
+				Handle(Request);
+			}
+
+			WakeUp->Wait();
+		}
+
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		bStopping = true;
+		WakeUp->Trigger();
+	}
+
+	/** Matches this worker holds or has been sent to create, counted up when a CreateMatch is dispatched to it */
+	FThreadSafeCounter NumMatches;
+
+	FThreadSafeCounter NumTurns;
+
+	FColourWarsLatencyHistogram Latency;
+
+private:
+	struct FMatch
+	{
+		FColourWarsBoard Board;
+
+		/** Only the connection that created the match can play it */
+		const FConnection* Owner;
+	};
+
+	void RemoveMatch(const FRequest& Request, int32 MatchId)
+	{
+		Matches.Remove(MatchId);
+		NumMatches.Decrement();
+		Request.Connection->NumMatches.Decrement();
+	}
+
+	void Handle(const FRequest& Request)
+	{
+		const FColourWarsMatchMessage& Message = Request.Message;
+		FColourWarsMatchMessage Reply;
+		Reply.MatchId = Message.MatchId;
+
+		if (Request.bConnectionClosed)
+		{
+			for (auto It = Matches.CreateIterator(); It; ++It)
+			{
+				if (It.Value().Owner == Request.Connection.Get())
+				{
+					It.RemoveCurrent();
+					NumMatches.Decrement();
+					Request.Connection->NumMatches.Decrement();
+				}
+			}
+			return;
+		}
+
+		switch (Message.Type)
+		{
+		case EColourWarsMatchMessage::CreateMatch:
+		{
+			Reply.Type = EColourWarsMatchMessage::MatchCreated;
+			if (Message.Size < 2 || Message.Size > ColourWarsMatchProtocol::MaxSize || Message.NumberOfPlayers < 2 || Message.NumberOfPlayers > 4)
+			{
+				NumMatches.Decrement();
+				Request.Connection->NumMatches.Decrement();
+				Reply.MatchId = 0;
+				break;
+			}
+
+			FMatch& Match = Matches.Add(Message.MatchId);
+			Match.Owner = Request.Connection.Get();
+			Match.Board.Init(Message.Size, Message.NumberOfPlayers);
+			Reply.Hash = Match.Board.GetHash();
+			break;
+		}
+
+		case EColourWarsMatchMessage::PlayTurn:
+		{
+			Reply.Type = EColourWarsMatchMessage::TurnPlayed;
+
+			FMatch* Match = Matches.Find(Message.MatchId);
+			if (Match == nullptr || Match->Owner != Request.Connection.Get())
+			{
+				break;
+			}
+
+			FColourWarsBoard& Board = Match->Board;
+			if (Message.Turn == Board.GetTurn() && Message.MoveType <= eMoveType::AddOne
+				&& Message.From < Board.GetNumCells() && Message.To < Board.GetNumCells())
+			{
+				const FColourWarsMove Move(Message.MoveType, Board.ToCoord(Message.From), Board.ToCoord(Message.To));
+				Reply.bAccepted = Board.IsLegalMove(Move);
+				if (Reply.bAccepted)
+				{
+					Board.ApplyTurn(Move);
+				}
+			}
+
+			Reply.Turn = Board.GetTurn();
+			Reply.Hash = Board.GetHash();
+
+			// The client still has its own board, the server is done with a finished match
+			if (Board.IsGameOver())
+			{
+				RemoveMatch(Request, Message.MatchId);
+			}
+
+			NumTurns.Increment();
+			Latency.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - Request.ReceivedCycles) * 1000.0);
+			break;
+		}
+
+		case EColourWarsMatchMessage::EndMatch:
+		{
+			FMatch* Match = Matches.Find(Message.MatchId);
+			if (Match != nullptr && Match->Owner == Request.Connection.Get())
+			{
+				RemoveMatch(Request, Message.MatchId);
+			}
+			return;
+		}
+
+		default:
+			return;
+		}
+
+		TArray<uint8> Frame;
+		Reply.AppendFrame(Frame);
+		Request.Connection->Replies.Enqueue(MoveTemp(Frame));
+	}
+
+	TQueue<FRequest, EQueueMode::Spsc> Requests;
+
+	/** Matches owned by this worker, by id */
+	TMap<int32, FMatch> Matches;
+
+	FEvent* WakeUp = nullptr;
+
+	FRunnableThread* Thread = nullptr;
+
+	FThreadSafeBool bStopping = false;
+};
+
+FColourWarsMatchServer::FColourWarsMatchServer()
+	: Listener(nullptr)
+	, NextMatchId(1)
+	, MaxMatches(DefaultMaxMatches)
+	, MaxMatchesPerConnection(DefaultMaxMatchesPerConnection)
+	, LastStatsTime(0.0)
+{
+}
+
+FColourWarsMatchServer::~FColourWarsMatchServer()
+{
+	Stop();
+}
+
+bool FColourWarsMatchServer::Start(int32 Port, int32 NumWorkers, int32 InMaxMatches, int32 InMaxMatchesPerConnection)
+{
+	Stop();
+
+	MaxMatches = FMath::Max(1, InMaxMatches);
+	MaxMatchesPerConnection = FMath::Max(1, InMaxMatchesPerConnection);
+
+	Listener = FTcpSocketBuilder(TEXT("ColourWarsMatchServer"))
+		.AsNonBlocking()
+		.AsReusable()
+		.BoundToPort(Port)
+		.Listening(256)
+		.Build();
+
+	if (Listener == nullptr)
+	{
+		UE_LOG(LogColourWarsServer, Error, TEXT("Could not listen on port %d."), Port);
+		return false;
+	}
+
+	for (int32 WorkerIndex = 0; WorkerIndex < FMath::Max(1, NumWorkers); WorkerIndex++)
+	{
+		Workers.Add(MakeUnique<FWorker>(WorkerIndex));
+	}
+
+	LastStatsTime = FPlatformTime::Seconds();
+
+	UE_LOG(LogColourWarsServer, Display, TEXT("Listening on port %d with %d workers."), Port, Workers.Num());
+	return true;
+}
+
+void FColourWarsMatchServer::Stop()
+{
+	while (Connections.Num() > 0)
+	{
+		CloseConnection(Connections.Num() - 1);
+	}
+
+	Workers.Reset();
+
+	if (Listener != nullptr)
+	{
+		Listener->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Listener);
+		Listener = nullptr;
+	}
+}
+
+bool FColourWarsMatchServer::Tick()
+{
+	if (Listener == nullptr)
+	{
+		return false;
+	}
+
+	bool bDidWork = false;
+
+	bool bHasPendingConnection = false;
+	while (Listener->HasPendingConnection(bHasPendingConnection) && bHasPendingConnection)
+	{
+		FSocket* Socket = Listener->Accept(TEXT("ColourWarsMatchConnection"));
+		if (Socket == nullptr)
+		{
+			break;
+		}
+
+		Socket->SetNonBlocking(true);
+		Socket->SetNoDelay(true);
+
+		FConnectionPtr Connection = MakeShared<FConnection, ESPMode::ThreadSafe>();
+		Connection->Socket = Socket;
+		Connections.Add(Connection);
+		bDidWork = true;
+	}
+
+	for (int32 ConnectionIndex = Connections.Num() - 1; ConnectionIndex >= 0; ConnectionIndex--)
+	{
+		const FConnectionPtr& Connection = Connections[ConnectionIndex];
+		bool bOpen = Connection->Reader.ReadFromSocket(*Connection->Socket);
+
+		FColourWarsMatchMessage Message;
+		while (bOpen && Connection->Reader.NextMessage(Message))
+		{
+			bOpen = Dispatch(Connection, Message);
+			bDidWork = true;
+		}
+
+		TArray<uint8> Reply;
+		while (Connection->Replies.Dequeue(Reply))
+		{
+			Connection->SendBuffer.Append(Reply);
+			bDidWork = true;
+		}
+
+		bOpen = bOpen && !Connection->Reader.IsCorrupt() && ColourWarsMatchProtocol::SendPending(*Connection->Socket, Connection->SendBuffer);
+		if (!bOpen)
+		{
+			CloseConnection(ConnectionIndex);
+		}
+	}
+
+	return bDidWork;
+}
+
+bool FColourWarsMatchServer::Dispatch(const FConnectionPtr& Connection, FColourWarsMatchMessage& Message)
+{
+	switch (Message.Type)
+	{
+	case EColourWarsMatchMessage::CreateMatch:
+		if (Connection->NumMatches.GetValue() >= MaxMatchesPerConnection || GetNumMatches() >= MaxMatches)
+		{
+			// Refused here, before the worker allocates a board for it
+			FColourWarsMatchMessage Reply;
+			Reply.Type = EColourWarsMatchMessage::MatchCreated;
+			Reply.MatchId = 0;
+
+			TArray<uint8> Frame;
+			Reply.AppendFrame(Frame);
+			Connection->Replies.Enqueue(MoveTemp(Frame));
+			return true;
+		}
+
+		Message.MatchId = NextMatchId++;
+		Connection->NumMatches.Increment();
+		Workers[(uint32)Message.MatchId % (uint32)Workers.Num()]->NumMatches.Increment();
+		break;
+	case EColourWarsMatchMessage::PlayTurn:
+	case EColourWarsMatchMessage::EndMatch:
+		break;
+	default:
+		// Clients never send the server's replies
+		return false;
+	}
+
+	FRequest Request;
+	Request.Connection = Connection;
+	Request.Message = Message;
+	Request.ReceivedCycles = FPlatformTime::Cycles64();
+
+	Workers[(uint32)Message.MatchId % (uint32)Workers.Num()]->Enqueue(MoveTemp(Request));
+	return true;
+}
+
+void FColourWarsMatchServer::CloseConnection(int32 ConnectionIndex)
+{
+	FConnectionPtr Connection = Connections[ConnectionIndex];
+	Connections.RemoveAtSwap(ConnectionIndex);
+
+	for (TUniquePtr<FWorker>& Worker : Workers)
+	{
+		FRequest Request;
+		Request.Connection = Connection;
+		Request.bConnectionClosed = true;
+		Worker->Enqueue(MoveTemp(Request));
+	}
+
+	Connection->Socket->Close();
+	ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Connection->Socket);
+	Connection->Socket = nullptr;
+}
+
+/// <summary>
+/// Only this thread counts matches up, so the workers counting theirs down at the same time can only make this high
+/// </summary>
+int32 FColourWarsMatchServer::GetNumMatches() const
+{
+	int32 NumMatches = 0;
+	for (const TUniquePtr<FWorker>& Worker : Workers)
+	{
+		NumMatches += Worker->NumMatches.GetValue();
+	}
+
+	return NumMatches;
+}
+
+void FColourWarsMatchServer::LogStats()
+{
+	const double Now = FPlatformTime::Seconds();
+	const double Elapsed = FMath::Max(Now - LastStatsTime, 0.001);
+	LastStatsTime = Now;
+
+	int64 Totals[FColourWarsLatencyHistogram::NumBuckets] = {};
+	int32 NumMatches = 0;
+	int32 NumTurns = 0;
+	for (TUniquePtr<FWorker>& Worker : Workers)
+	{
+		NumMatches += Worker->NumMatches.GetValue();
+		NumTurns += Worker->NumTurns.Reset();
+		Worker->Latency.DrainInto(Totals);
+	}
+
+	UE_LOG(LogColourWarsServer, Display, TEXT("%d connections, %d matches (%.1f per core), %.0f turns/s, p99 turn latency %.3f ms"),
+		Connections.Num(), NumMatches, (float)NumMatches / FPlatformMisc::NumberOfCores(), NumTurns / Elapsed,
+		FColourWarsLatencyHistogram::Percentile(Totals, 0.99) / 1000.0);
+}
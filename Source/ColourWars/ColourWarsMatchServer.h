@@ -0,0 +1,88 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "ColourWarsMatchProtocol.h"
+
+class FSocket;
+
+/** Latency histogram in eighth of an octave buckets, that several threads can add to at once */
+struct COLOURWARS_API FColourWarsLatencyHistogram
+{
+	/** Enough buckets for a little over a second */
+	static const int32 NumBuckets = 160;
+
+	FThreadSafeCounter Buckets[NumBuckets];
+
+	void Add(double Microseconds);
+
+	/** Add the counts into Totals and empty the histogram */
+	void DrainInto(int64 (&Totals)[NumBuckets]);
+
+	/** Latency in microseconds that the fraction of samples in Totals are at or below, rounded up to a bucket */
+	static double Percentile(const int64 (&Totals)[NumBuckets], double Fraction);
+};
+
+/**
+ * Hosts many independent matches in one process, without any worlds or actors.
+ *
+ * Each match is just an FColourWarsBoard. Matches are sharded over a pool of worker threads by their id, so a
+ * match is only ever touched by the one worker that owns it and needs no locking. The calling thread runs the
+ * sockets: it reads messages, queues them on the worker that owns the match and sends back the replies.
+ *
+ * Every match holds a board, so the number of matches is capped for each connection and for the whole server, and
+ * a CreateMatch over either cap is refused.
+ */
+class COLOURWARS_API FColourWarsMatchServer
+{
+public:
+	static const int32 DefaultMaxMatches = 32768;
+	static const int32 DefaultMaxMatchesPerConnection = 256;
+
+	FColourWarsMatchServer();
+	~FColourWarsMatchServer();
+
+	/** Listen on the port and start the workers */
+	bool Start(int32 Port, int32 NumWorkers, int32 InMaxMatches = DefaultMaxMatches, int32 InMaxMatchesPerConnection = DefaultMaxMatchesPerConnection);
+
+	void Stop();
+
+	/** Accept connections, dispatch their messages and send replies, returns false if there was nothing to do */
+	bool Tick();
+
+	/** Log matches per core, turns per second and the p99 turn latency since the last call */
+	void LogStats();
+
+private:
+	struct FConnection;
+	struct FRequest;
+	class FWorker;
+
+	typedef TSharedPtr<FConnection, ESPMode::ThreadSafe> FConnectionPtr;
+
+	/** Queue a message on the worker that owns its match */
+	bool Dispatch(const FConnectionPtr& Connection, FColourWarsMatchMessage& Message);
+
+	/** Close the socket and have the workers drop the connection's matches */
+	void CloseConnection(int32 ConnectionIndex);
+
+	/** Matches the workers hold or have been sent to create */
+	int32 GetNumMatches() const;
+
+	FSocket* Listener;
+
+	TArray<FConnectionPtr> Connections;
+
+	TArray<TUniquePtr<FWorker>> Workers;
+
+	/** Ids start at 1, a MatchCreated with id 0 means the match was refused */
+	int32 NextMatchId;
+
+	int32 MaxMatches;
+
+	int32 MaxMatchesPerConnection;
+
+	double LastStatsTime;
+};
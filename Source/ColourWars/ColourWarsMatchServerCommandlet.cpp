@@ -0,0 +1,56 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsMatchServerCommandlet.h"
+#include "ColourWarsMatchServer.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/CoreMisc.h"
+
+UColourWarsMatchServerCommandlet::UColourWarsMatchServerCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UColourWarsMatchServerCommandlet::Main(const FString& Params)
+{
+	int32 Port = ColourWarsMatchProtocol::DefaultPort;
+	int32 NumWorkers = FMath::Max(1, FPlatformMisc::NumberOfCores() - 1);
+	float StatsInterval = 5.f;
+	float Duration = 0.f;
+	int32 MaxMatches = FColourWarsMatchServer::DefaultMaxMatches;
+	int32 MaxMatchesPerConnection = FColourWarsMatchServer::DefaultMaxMatchesPerConnection;
+	FParse::Value(*Params, TEXT("Port="), Port);
+	FParse::Value(*Params, TEXT("Workers="), NumWorkers);
+	FParse::Value(*Params, TEXT("StatsInterval="), StatsInterval);
+	FParse::Value(*Params, TEXT("Duration="), Duration);
+	FParse::Value(*Params, TEXT("MaxMatches="), MaxMatches);
+	FParse::Value(*Params, TEXT("MaxMatchesPerConnection="), MaxMatchesPerConnection);
+
+	FColourWarsMatchServer Server;
+	if (!Server.Start(Port, NumWorkers, MaxMatches, MaxMatchesPerConnection))
+	{
+		return 1;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	double NextStatsTime = StartTime + StatsInterval;
+	while (!IsEngineExitRequested() && (Duration <= 0.f || FPlatformTime::Seconds() - StartTime < Duration))
+	{
+		// Only sleep when idle, so a busy server replies as soon as a worker has played the turn
+		if (!Server.Tick())
+		{
+			FPlatformProcess::Sleep(0.0002f);
+		}
+
+		if (FPlatformTime::Seconds() >= NextStatsTime)
+		{
+			Server.LogStats();
+			NextStatsTime += StatsInterval;
+		}
+	}
+
+	Server.Stop();
+	return 0;
+}
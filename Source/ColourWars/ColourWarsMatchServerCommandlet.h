@@ -0,0 +1,25 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ColourWarsMatchServerCommandlet.generated.h"
+
+/**
+ * Headless server hosting many matches at once, see FColourWarsMatchServer.
+ *
+ * Usage: ColourWars -run=ColourWarsMatchServer [-Port=7777] [-Workers=<n>] [-StatsInterval=5] [-Duration=<seconds>]
+ *        [-MaxMatches=32768] [-MaxMatchesPerConnection=256]
+ * Workers defaults to one less than the number of cores, the main thread runs the sockets.
+ */
+UCLASS()
+class UColourWarsMatchServerCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UColourWarsMatchServerCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,78 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Z-order (Morton) cell indices, for boards that store their cells in Z-order rather than row by row.
+ *
+ * The bits of Y go in the even bits of the index and the bits of X in the odd ones, so every aligned 2^N x 2^N square
+ * of cells is a contiguous run of indices and a cell's neighbours are mostly a few cache lines from it. A neighbour's
+ * index is worked out from the cell's index directly: filling the other coordinate's bits with 1s before an add, or
+ * 0s before a subtract, carries straight through them.
+ */
+namespace ColourWarsMorton
+{
+	/** Bits of the X and Y coordinates in an index */
+	const uint32 XBits = 0xAAAAAAAA;
+	const uint32 YBits = 0x55555555;
+
+	/** Spread the low 16 bits of a value out to the even bits */
+	FORCEINLINE uint32 Spread(uint32 Value)
+	{
+		Value &= 0x0000FFFF;
+		Value = (Value | (Value << 8)) & 0x00FF00FF;
+		Value = (Value | (Value << 4)) & 0x0F0F0F0F;
+		Value = (Value | (Value << 2)) & 0x33333333;
+		Value = (Value | (Value << 1)) & 0x55555555;
+		return Value;
+	}
+
+	/** Gather the even bits of a value back into its low 16 bits */
+	FORCEINLINE uint32 Gather(uint32 Value)
+	{
+		Value &= 0x55555555;
+		Value = (Value | (Value >> 1)) & 0x33333333;
+		Value = (Value | (Value >> 2)) & 0x0F0F0F0F;
+		Value = (Value | (Value >> 4)) & 0x00FF00FF;
+		Value = (Value | (Value >> 8)) & 0x0000FFFF;
+		return Value;
+	}
+
+	FORCEINLINE int32 Encode(int32 X, int32 Y)
+	{
+		return static_cast<int32>((Spread(X) << 1) | Spread(Y));
+	}
+
+	FORCEINLINE int32 DecodeX(int32 Index)
+	{
+		return static_cast<int32>(Gather(static_cast<uint32>(Index) >> 1));
+	}
+
+	FORCEINLINE int32 DecodeY(int32 Index)
+	{
+		return static_cast<int32>(Gather(static_cast<uint32>(Index)));
+	}
+
+	/** Index of the cell one step along X or Y, the caller checks the step stays on the board */
+	FORCEINLINE int32 AddX(int32 Index)
+	{
+		return static_cast<int32>((((Index | YBits) + 2) & XBits) | (Index & YBits));
+	}
+
+	FORCEINLINE int32 SubtractX(int32 Index)
+	{
+		return static_cast<int32>((((Index & XBits) - 2) & XBits) | (Index & YBits));
+	}
+
+	FORCEINLINE int32 AddY(int32 Index)
+	{
+		return static_cast<int32>((((Index | XBits) + 1) & YBits) | (Index & XBits));
+	}
+
+	FORCEINLINE int32 SubtractY(int32 Index)
+	{
+		return static_cast<int32>((((Index & YBits) - 1) & YBits) | (Index & XBits));
+	}
+}
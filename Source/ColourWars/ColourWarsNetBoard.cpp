@@ -0,0 +1,67 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsNetBoard.h"
+#include "ColourWarsGameState.h"
+
+void FColourWarsNetCell::PostReplicatedAdd(const FColourWarsNetBoard& InArraySerializer)
+{
+	PostReplicatedChange(InArraySerializer);
+}
+
+void FColourWarsNetCell::PostReplicatedChange(const FColourWarsNetBoard& InArraySerializer)
+{
+	if (InArraySerializer.Owner != nullptr)
+	{
+		InArraySerializer.Owner->OnNetCellChanged(*this);
+	}
+}
+
+void FColourWarsNetBoard::Reset(const FColourWarsBoard& Board)
+{
+	Cells.Reset();
+	CellItems.Init(INDEX_NONE, Board.GetNumCells());
+
+	for (int32 Index = 0; Index < Board.GetNumCells(); Index++)
+	{
+		if (Board.GetBlockType(Index) != eBlockType::None || Board.GetScore(Index) != 0 || Board.IsCapitalBlock(Index))
+		{
+			UpdateCell(Board, Index);
+		}
+	}
+
+	MarkArrayDirty();
+}
+
+void FColourWarsNetBoard::UpdateCells(const FColourWarsBoard& Board, const FColourWarsTurnDelta& Delta)
+{
+	for (const FColourWarsCellChange& Change : Delta.Cells)
+	{
+		UpdateCell(Board, Change.Index);
+	}
+}
+
+void FColourWarsNetBoard::UpdateCell(const FColourWarsBoard& Board, int32 Index)
+{
+	if (CellItems[Index] == INDEX_NONE)
+	{
+		CellItems[Index] = Cells.AddDefaulted();
+		Cells[CellItems[Index]].Index = Index;
+	}
+
+	FColourWarsNetCell& Cell = Cells[CellItems[Index]];
+	Cell.Score = Board.GetScore(Index);
+	Cell.TypeAndCapital = static_cast<uint8>(Board.GetBlockType(Index)) | (Board.IsCapitalBlock(Index) ? 0x80 : 0);
+
+	MarkItemDirty(Cell);
+}
+
+void FColourWarsNetBoard::ApplyTo(FColourWarsBoard& Board) const
+{
+	for (const FColourWarsNetCell& Cell : Cells)
+	{
+		if (Cell.Index >= 0 && Cell.Index < Board.GetNumCells())
+		{
+			Board.SetCell(Cell.Index, static_cast<eBlockType>(Cell.TypeAndCapital & 0x7F), Cell.Score, (Cell.TypeAndCapital & 0x80) != 0);
+		}
+	}
+}
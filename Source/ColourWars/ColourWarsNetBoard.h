@@ -0,0 +1,123 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "ColourWarsBoard.h"
+#include "ColourWarsNetBoard.generated.h"
+
+struct FColourWarsNetBoard;
+
+/** One occupied cell of the replicated board */
+USTRUCT()
+struct FColourWarsNetCell : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	/** Cell index on the board, items are not kept in board order on clients */
+	UPROPERTY()
+		int32 Index = 0;
+
+	UPROPERTY()
+		int32 Score = 0;
+
+	/** eBlockType in the low bits and the capital flag in the top bit, as in FColourWarsBoard::Serialize */
+	UPROPERTY()
+		uint8 TypeAndCapital = 0;
+
+	void PostReplicatedAdd(const FColourWarsNetBoard& InArraySerializer);
+	void PostReplicatedChange(const FColourWarsNetBoard& InArraySerializer);
+};
+
+/**
+ * Board cells replicated as a single delta serialised array, rather than an actor channel per block.
+ *
+ * Only occupied cells are added, as a cell is never emptied once it has a block, and a turn only marks
+ * the few cells it changed dirty, so each turn sends a handful of items whatever the size of the grid.
+ */
+USTRUCT()
+struct FColourWarsNetBoard : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TArray<FColourWarsNetCell> Cells;
+
+	/** Game state this array belongs to, told about cells as they arrive on clients */
+	UPROPERTY(NotReplicated)
+		class AColourWarsGameState* Owner = nullptr;
+
+	/** Replace every cell with those of the board */
+	void Reset(const FColourWarsBoard& Board);
+
+	/** Send the cells a turn changed */
+	void UpdateCells(const FColourWarsBoard& Board, const FColourWarsTurnDelta& Delta);
+
+	/** Copy every replicated cell onto a board that has been set up with the right size */
+	void ApplyTo(FColourWarsBoard& Board) const;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FColourWarsNetCell, FColourWarsNetBoard>(Cells, DeltaParms, *this);
+	}
+
+private:
+	/** Set the item of a cell, adding it if the cell has not been sent before */
+	void UpdateCell(const FColourWarsBoard& Board, int32 Index);
+
+	/** Position in Cells of each board cell's item, or INDEX_NONE, only used on the server */
+	TArray<int32> CellItems;
+};
+
+template<>
+struct TStructOpsTypeTraits<FColourWarsNetBoard> : public TStructOpsTypeTraitsBase2<FColourWarsNetBoard>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/** Everything about the board besides its cells, replicated alongside them */
+USTRUCT()
+struct FColourWarsNetTurnState
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		int32 Size = 0;
+
+	UPROPERTY()
+		uint8 NumberOfPlayers = 0;
+
+	UPROPERTY()
+		int32 Turn = 0;
+
+	UPROPERTY()
+		eBlockType CurrentPlayer = eBlockType::Red;
+
+	UPROPERTY()
+		bool bGameOver = false;
+};
+
+/** A turn as sent to every peer of a lockstep match, the same size whatever the size of the grid */
+USTRUCT()
+struct FColourWarsNetTurn
+{
+	GENERATED_BODY()
+
+	/** Turn of the board the move is played on */
+	UPROPERTY()
+		int32 Turn = 0;
+
+	UPROPERTY()
+		eMoveType MoveType = eMoveType::Invalid;
+
+	/** Cell indices of the move's From and To */
+	UPROPERTY()
+		int32 From = 0;
+
+	UPROPERTY()
+		int32 To = 0;
+};
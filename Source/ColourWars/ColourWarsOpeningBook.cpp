@@ -0,0 +1,220 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsOpeningBook.h"
+#include "ColourWarsSymmetry.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogColourWarsOpeningBook, Log, All);
+
+TArray<TUniquePtr<FColourWarsOpeningBook>> FColourWarsOpeningBook::Mounted;
+
+FColourWarsOpeningBook::FColourWarsOpeningBook()
+	: Size(0)
+	, NumberOfPlayers(0)
+	, NumEntries(0)
+	, Keys(nullptr)
+	, MoveFrom(nullptr)
+	, MoveTo(nullptr)
+	, MoveTypes(nullptr)
+{
+}
+
+FColourWarsOpeningBook::~FColourWarsOpeningBook()
+{
+	// The region has to go before the file it maps
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+bool FColourWarsOpeningBook::Write(const FString& Filename, int32 Size, int32 NumberOfPlayers, TArray<FColourWarsBookEntry> Entries)
+{
+	TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Ar.IsValid())
+	{
+		return false;
+	}
+
+	Entries.Sort();
+
+	uint32 Magic = ColourWarsOpeningBook::FileMagic;
+	uint16 Version = ColourWarsOpeningBook::Version;
+	uint16 PackedPlayers = NumberOfPlayers;
+	int32 PackedSize = Size;
+	uint32 Reserved = 0;
+	int64 Count = Entries.Num();
+	*Ar << Magic;
+	*Ar << Version;
+	*Ar << PackedPlayers;
+	*Ar << PackedSize;
+	*Ar << Reserved;
+	*Ar << Count;
+
+	TArray<uint64> KeysColumn;
+	TArray<uint32> FromColumn;
+	TArray<uint32> ToColumn;
+	TArray<uint8> TypesColumn;
+	KeysColumn.Reserve(Entries.Num());
+	FromColumn.Reserve(Entries.Num());
+	ToColumn.Reserve(Entries.Num());
+	TypesColumn.Reserve(Entries.Num());
+	for (const FColourWarsBookEntry& Entry : Entries)
+	{
+		KeysColumn.Add(Entry.Key);
+		FromColumn.Add(Entry.Move.From.X * Size + Entry.Move.From.Y);
+		ToColumn.Add(Entry.Move.To.X * Size + Entry.Move.To.Y);
+		TypesColumn.Add(static_cast<uint8>(Entry.Move.MoveType));
+	}
+
+	Ar->Serialize(KeysColumn.GetData(), KeysColumn.Num() * sizeof(uint64));
+	Ar->Serialize(FromColumn.GetData(), FromColumn.Num() * sizeof(uint32));
+	Ar->Serialize(ToColumn.GetData(), ToColumn.Num() * sizeof(uint32));
+	Ar->Serialize(TypesColumn.GetData(), TypesColumn.Num());
+
+	return Ar->Close();
+}
+
+bool FColourWarsOpeningBook::Open(const FString& Filename)
+{
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	LoadedFile.Empty();
+	NumEntries = 0;
+
+	const uint8* Data = nullptr;
+	int64 DataSize = 0;
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (MappedFile.IsValid() && MappedFile->GetFileSize() > 0)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion());
+	}
+
+	if (MappedRegion.IsValid())
+	{
+		Data = MappedRegion->GetMappedPtr();
+		DataSize = MappedRegion->GetMappedSize();
+	}
+	else if (FFileHelper::LoadFileToArray(LoadedFile, *Filename))
+	{
+		Data = LoadedFile.GetData();
+		DataSize = LoadedFile.Num();
+	}
+	else
+	{
+		return false;
+	}
+
+	if (DataSize < ColourWarsOpeningBook::HeaderSize)
+	{
+		return false;
+	}
+
+	uint32 Magic;
+	uint16 Version;
+	uint16 Players;
+	int32 BookSize;
+	int64 Count;
+	FMemory::Memcpy(&Magic, Data, sizeof(Magic));
+	FMemory::Memcpy(&Version, Data + 4, sizeof(Version));
+	FMemory::Memcpy(&Players, Data + 6, sizeof(Players));
+	FMemory::Memcpy(&BookSize, Data + 8, sizeof(BookSize));
+	FMemory::Memcpy(&Count, Data + 16, sizeof(Count));
+
+	const int64 EntryBytes = sizeof(uint64) + 2 * sizeof(uint32) + sizeof(uint8);
+	if (Magic != ColourWarsOpeningBook::FileMagic || Version > ColourWarsOpeningBook::Version || Players < 2 || Players > 4
+		|| BookSize < 2 || BookSize > FColourWarsBoard::MaxSize || Count < 0 || ColourWarsOpeningBook::HeaderSize + Count * EntryBytes > DataSize)
+	{
+		return false;
+	}
+
+	Size = BookSize;
+	NumberOfPlayers = Players;
+	NumEntries = Count;
+	Keys = reinterpret_cast<const uint64*>(Data + ColourWarsOpeningBook::HeaderSize);
+	MoveFrom = reinterpret_cast<const uint32*>(Keys + NumEntries);
+	MoveTo = MoveFrom + NumEntries;
+	MoveTypes = reinterpret_cast<const uint8*>(MoveTo + NumEntries);
+
+	return true;
+}
+
+/// <summary>
+/// Binary search the keys for the canonical hash of the position, then take the book move back from the canonical
+/// form to the board. The move is checked to be legal, so a hash that happens to match never plays a bad move.
+/// </summary>
+bool FColourWarsOpeningBook::Probe(const FColourWarsBoard& Board, FColourWarsMove& OutMove) const
+{
+	if (Board.GetSize() != Size || Board.GetNumberOfPlayers() != NumberOfPlayers || Board.IsGameOver())
+	{
+		return false;
+	}
+
+	FColourWarsSymmetry Symmetry;
+	const uint64 Key = FColourWarsSymmetry::Canonicalise(Board, Symmetry);
+
+	int64 Low = 0;
+	int64 High = NumEntries;
+	while (Low < High)
+	{
+		const int64 Middle = Low + (High - Low) / 2;
+		if (Keys[Middle] < Key)
+		{
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle;
+		}
+	}
+
+	if (Low == NumEntries || Keys[Low] != Key)
+	{
+		return false;
+	}
+
+	const int64 NumCells = (int64)Size * Size;
+	if (MoveFrom[Low] >= NumCells || MoveTo[Low] >= NumCells)
+	{
+		return false;
+	}
+
+	const FColourWarsMove Move(static_cast<eMoveType>(MoveTypes[Low]), Board.ToCoord(MoveFrom[Low]), Board.ToCoord(MoveTo[Low]));
+	OutMove = Symmetry.Invert(Move, Size);
+	return OutMove.MoveType != eMoveType::Invalid && Board.IsLegalMove(OutMove);
+}
+
+void FColourWarsOpeningBook::MountAll(const FString& Directory)
+{
+	TArray<FString> Filenames;
+	IFileManager::Get().FindFiles(Filenames, *(Directory / TEXT("*.cwob")), true, false);
+
+	for (const FString& Filename : Filenames)
+	{
+		TUniquePtr<FColourWarsOpeningBook> Book = MakeUnique<FColourWarsOpeningBook>();
+		if (!Book->Open(Directory / Filename))
+		{
+			UE_LOG(LogColourWarsOpeningBook, Warning, TEXT("Could not open the opening book '%s'."), *Filename);
+			continue;
+		}
+
+		UE_LOG(LogColourWarsOpeningBook, Log, TEXT("Mounted '%s': %dx%d, %d players, %lld positions."),
+			*Filename, Book->GetSize(), Book->GetSize(), Book->GetNumberOfPlayers(), Book->GetNumEntries());
+		Mounted.Add(MoveTemp(Book));
+	}
+}
+
+const FColourWarsOpeningBook* FColourWarsOpeningBook::Find(int32 Size, int32 NumberOfPlayers)
+{
+	for (const TUniquePtr<FColourWarsOpeningBook>& Book : Mounted)
+	{
+		if (Book->GetSize() == Size && Book->GetNumberOfPlayers() == NumberOfPlayers)
+		{
+			return Book.Get();
+		}
+	}
+
+	return nullptr;
+}
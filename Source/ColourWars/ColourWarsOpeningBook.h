@@ -0,0 +1,81 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColourWarsBoard.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Opening books hold the move to play in positions near the start of a game, for one board size and player count.
+ *
+ * Header: uint32 magic, uint16 version, uint16 number of players, int32 size, uint32 reserved, int64 entry count
+ * Then four columns sorted by key: uint64 canonical hash, uint32 From index, uint32 To index, uint8 eMoveType.
+ * Moves are stored for the canonical form of the position, see FColourWarsSymmetry.
+ */
+namespace ColourWarsOpeningBook
+{
+	const uint32 FileMagic = 0x424F5743;
+	const uint16 Version = 1;
+	const int32 HeaderSize = 24;
+}
+
+/** A position of the book and its move, both in canonical form */
+struct FColourWarsBookEntry
+{
+	uint64 Key;
+	FColourWarsMove Move;
+
+	bool operator<(const FColourWarsBookEntry& Other) const { return Key < Other.Key; }
+};
+
+/** An opening book file, memory mapped so nothing is parsed when it is loaded */
+class COLOURWARS_API FColourWarsOpeningBook
+{
+public:
+	FColourWarsOpeningBook();
+	~FColourWarsOpeningBook();
+
+	/** Write the entries of a book, sorting them by key */
+	static bool Write(const FString& Filename, int32 Size, int32 NumberOfPlayers, TArray<FColourWarsBookEntry> Entries);
+
+	bool Open(const FString& Filename);
+
+	int32 GetSize() const { return Size; }
+
+	int32 GetNumberOfPlayers() const { return NumberOfPlayers; }
+
+	int64 GetNumEntries() const { return NumEntries; }
+
+	/** The book move for a position, false if the book does not have it */
+	bool Probe(const FColourWarsBoard& Board, FColourWarsMove& OutMove) const;
+
+	/** Map every book in a directory, done once at startup */
+	static void MountAll(const FString& Directory);
+
+	/** The mounted book for a board size and player count, or nullptr if there is none */
+	static const FColourWarsOpeningBook* Find(int32 Size, int32 NumberOfPlayers);
+
+private:
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	/** The whole file, when it could not be mapped */
+	TArray<uint8> LoadedFile;
+
+	int32 Size;
+
+	int32 NumberOfPlayers;
+
+	int64 NumEntries;
+
+	/** Columns in the file */
+	const uint64* Keys;
+	const uint32* MoveFrom;
+	const uint32* MoveTo;
+	const uint8* MoveTypes;
+
+	static TArray<TUniquePtr<FColourWarsOpeningBook>> Mounted;
+};
@@ -0,0 +1,237 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsOpeningBookCommandlet.h"
+#include "ColourWarsOpeningBook.h"
+#include "ColourWarsSearch.h"
+#include "ColourWarsSymmetry.h"
+#include "Async/ParallelFor.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogColourWarsOpeningBookGen, Log, All);
+
+namespace
+{
+	/** Transposition table of each worker's search */
+	const int32 TableSizeLog2 = 18;
+
+	/**
+	 * A position of the book in canonical form, so Red is to move. Bit N of Seats is set if the player of colour N + 1
+	 * has played the book move on each of their turns so far, so a player following the book can meet the position.
+	 */
+	struct FBookPosition
+	{
+		uint64 Key;
+		uint8 Seats;
+		FColourWarsBoard Board;
+	};
+
+	/** Parse a comma separated list of numbers */
+	void ParseList(const FString& List, TArray<int32>& OutValues)
+	{
+		TArray<FString> Items;
+		List.ParseIntoArray(Items, TEXT(","));
+		for (const FString& Item : Items)
+		{
+			OutValues.Add(FCString::Atoi(*Item));
+		}
+	}
+
+	/** Make the canonical form of a position, carrying the seats over to its colours */
+	FBookPosition MakePosition(const FColourWarsBoard& Board, uint8 Seats)
+	{
+		FColourWarsSymmetry Symmetry;
+		FBookPosition Position;
+		Position.Key = FColourWarsSymmetry::Canonicalise(Board, Symmetry);
+		Position.Seats = 0;
+		Symmetry.Apply(Board, Position.Board);
+
+		for (int32 Player = 1; Player <= Board.GetNumberOfPlayers(); Player++)
+		{
+			if (Seats & (1 << (Player - 1)))
+			{
+				Position.Seats |= 1 << (static_cast<int32>(Symmetry.Apply(static_cast<eBlockType>(Player), Board.GetNumberOfPlayers())) - 1);
+			}
+		}
+
+		return Position;
+	}
+
+	/**
+	 * Build the book a turn at a time from the start of a game. On worker threads, each position whose player to move
+	 * follows the book is searched for its book move, then every move is played to find the next turn's positions:
+	 * all of them keep the seats of the players still following the book, except that the player to move drops out
+	 * on every move but the book one. Positions no seat can meet are dropped, and ones met before are not repeated.
+	 */
+	void BuildBook(int32 Size, int32 NumberOfPlayers, int32 Turns, int32 Depth, TArray<FColourWarsBookEntry>& OutEntries)
+	{
+		FColourWarsBoard Start;
+		Start.Init(Size, NumberOfPlayers);
+
+		TArray<FBookPosition> Positions;
+		Positions.Add(MakePosition(Start, static_cast<uint8>((1 << NumberOfPlayers) - 1)));
+
+		TSet<uint64> Visited;
+		Visited.Add(Positions[0].Key);
+
+		const int32 NumTasks = FPlatformMisc::NumberOfCoresIncludingHyperthreads() * 4;
+		TArray<TArray<FColourWarsBookEntry>> TaskEntries;
+		TArray<TArray<FBookPosition>> TaskPositions;
+		TaskEntries.SetNum(NumTasks);
+		TaskPositions.SetNum(NumTasks);
+
+		for (int32 Turn = 0; Turn < Turns && Positions.Num() > 0; Turn++)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			const bool bLastTurn = Turn == Turns - 1;
+
+			ParallelFor(NumTasks, [&](int32 Task)
+			{
+				TArray<FColourWarsBookEntry>& Entries = TaskEntries[Task];
+				TArray<FBookPosition>& NextPositions = TaskPositions[Task];
+				Entries.Reset();
+				NextPositions.Reset();
+
+				// No book is mounted while a book is built, so the search always searches
+				TUniquePtr<FColourWarsSearch> Search;
+				TArray<FColourWarsMove> Moves;
+
+				const int32 Begin = (int64)Positions.Num() * Task / NumTasks;
+				const int32 End = (int64)Positions.Num() * (Task + 1) / NumTasks;
+				for (int32 Index = Begin; Index < End; Index++)
+				{
+					const FBookPosition& Position = Positions[Index];
+
+					// Red is to move in the canonical form
+					const bool bFollowsBook = (Position.Seats & 1) != 0;
+					FColourWarsMove BookMove;
+					if (bFollowsBook)
+					{
+						if (!Search.IsValid())
+						{
+							Search = MakeUnique<FColourWarsSearch>(FColourWarsEvalWeights::GetDefault(), TableSizeLog2);
+						}
+
+						Search->Start(Position.Board, Depth);
+						Search->Step(MAX_int32);
+						BookMove = Search->GetBestMove();
+						Entries.Add({ Position.Key, BookMove });
+					}
+
+					if (bLastTurn)
+					{
+						continue;
+					}
+
+					Moves.Reset();
+					Position.Board.GetLegalMoves(Moves);
+					for (const FColourWarsMove& Move : Moves)
+					{
+						const uint8 Seats = bFollowsBook && Move == BookMove ? Position.Seats : Position.Seats & ~1;
+						if (Seats == 0)
+						{
+							continue;
+						}
+
+						FColourWarsBoard Next = Position.Board;
+						Next.ApplyTurn(Move);
+						if (!Next.IsGameOver())
+						{
+							NextPositions.Add(MakePosition(Next, Seats));
+						}
+					}
+				}
+			});
+
+			int32 NumSearched = 0;
+			for (const TArray<FColourWarsBookEntry>& Entries : TaskEntries)
+			{
+				OutEntries.Append(Entries);
+				NumSearched += Entries.Num();
+			}
+
+			// Merge the positions the tasks found, a position met more than once can be met by any of the seats
+			TArray<FBookPosition> NextPositions;
+			TMap<uint64, int32> NextIndices;
+			for (TArray<FBookPosition>& Found : TaskPositions)
+			{
+				for (FBookPosition& Position : Found)
+				{
+					if (const int32* Existing = NextIndices.Find(Position.Key))
+					{
+						NextPositions[*Existing].Seats |= Position.Seats;
+					}
+					else if (!Visited.Contains(Position.Key))
+					{
+						Visited.Add(Position.Key);
+						NextIndices.Add(Position.Key, NextPositions.Num());
+						NextPositions.Add(MoveTemp(Position));
+					}
+				}
+			}
+
+			UE_LOG(LogColourWarsOpeningBookGen, Display, TEXT("%dx%d, %d players, turn %d: searched %d of %d positions in %.1f seconds."),
+				Size, Size, NumberOfPlayers, Turn + 1, NumSearched, Positions.Num(), FPlatformTime::Seconds() - StartTime);
+
+			Positions = MoveTemp(NextPositions);
+		}
+	}
+}
+
+UColourWarsOpeningBookCommandlet::UColourWarsOpeningBookCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UColourWarsOpeningBookCommandlet::Main(const FString& Params)
+{
+	FString SizeList = TEXT("7");
+	FString PlayerList = TEXT("2");
+	int32 Turns = 8;
+	int32 Depth = 6;
+	FString Output = FPaths::ProjectContentDir() / TEXT("OpeningBooks");
+	FParse::Value(*Params, TEXT("Sizes="), SizeList, false);
+	FParse::Value(*Params, TEXT("Players="), PlayerList, false);
+	FParse::Value(*Params, TEXT("Turns="), Turns);
+	FParse::Value(*Params, TEXT("Depth="), Depth);
+	FParse::Value(*Params, TEXT("Output="), Output);
+
+	TArray<int32> Sizes;
+	TArray<int32> PlayerCounts;
+	ParseList(SizeList, Sizes);
+	ParseList(PlayerList, PlayerCounts);
+
+	const bool bValidSizes = Sizes.Num() > 0 && !Sizes.ContainsByPredicate([](int32 Size) { return Size < 2 || Size > FColourWarsBoard::MaxSize; });
+	const bool bValidPlayers = PlayerCounts.Num() > 0 && !PlayerCounts.ContainsByPredicate([](int32 Players) { return Players < 2 || Players > 4; });
+	if (!bValidSizes || !bValidPlayers || Turns < 1 || Depth < 1 || Depth > FColourWarsSearch::MaxPly)
+	{
+		UE_LOG(LogColourWarsOpeningBookGen, Error, TEXT("Need sizes of 2 to %d, 2 to 4 players, at least one turn and a depth of 1 to %d."),
+			FColourWarsBoard::MaxSize, FColourWarsSearch::MaxPly);
+		return 1;
+	}
+
+	for (int32 Size : Sizes)
+	{
+		for (int32 NumberOfPlayers : PlayerCounts)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+
+			TArray<FColourWarsBookEntry> Entries;
+			BuildBook(Size, NumberOfPlayers, Turns, Depth, Entries);
+
+			const FString Filename = Output / FString::Printf(TEXT("ColourWars_%dx%d_%dp.cwob"), Size, Size, NumberOfPlayers);
+			if (!FColourWarsOpeningBook::Write(Filename, Size, NumberOfPlayers, Entries))
+			{
+				UE_LOG(LogColourWarsOpeningBookGen, Error, TEXT("Could not write '%s'."), *Filename);
+				return 1;
+			}
+
+			UE_LOG(LogColourWarsOpeningBookGen, Display, TEXT("Wrote %d positions to '%s' in %.1f seconds."),
+				Entries.Num(), *Filename, FPlatformTime::Seconds() - StartTime);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,26 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ColourWarsOpeningBookCommandlet.generated.h"
+
+/**
+ * Searches the openings of each board size and player count and writes the best move of every position to a book.
+ *
+ * Usage: ColourWars -run=ColourWarsOpeningBook [-Sizes=7] [-Players=2] [-Turns=8] [-Depth=6] [-Output=<directory>]
+ * Output defaults to Content/OpeningBooks, where the game mounts books at startup, with one file for each size and
+ * player count named ColourWars_<Size>x<Size>_<Players>p.cwob. The book covers every position of the first Turns
+ * turns that a player following the book can meet, whatever the other players do, each searched to Depth plies.
+ */
+UCLASS()
+class UColourWarsOpeningBookCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UColourWarsOpeningBookCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
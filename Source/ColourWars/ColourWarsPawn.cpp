@@ -4,6 +4,8 @@
 #include "ColourWarsBlock.h"
 #include "HeadMountedDisplayFunctionLibrary.h"
 #include "Camera/CameraComponent.h"
+#include "Camera/CameraTypes.h"
+#include "Components/InputComponent.h"
 #include "GameFramework/PlayerController.h"
 #include "Engine/World.h"
 #include "DrawDebugHelpers.h"
@@ -17,11 +19,90 @@ AColourWarsPawn::AColourWarsPawn(const FObjectInitializer& ObjectInitializer)
 void AColourWarsPawn::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 {
 	Super::SetupPlayerInputComponent(PlayerInputComponent);
+
+	PlayerInputComponent->BindAxis("PanRight", this, &AColourWarsPawn::PanRight);
+	PlayerInputComponent->BindAxis("PanUp", this, &AColourWarsPawn::PanUp);
+	PlayerInputComponent->BindAxis("Zoom", this, &AColourWarsPawn::Zoom);
 }
 
+/// <summary>
+/// Look straight down at the board from above the pawn, moved along the board by the pan and towards it by the zoom.
+/// Screen right is +X on the board and screen up is -Y.
+/// </summary>
 void AColourWarsPawn::CalcCamera(float DeltaTime, struct FMinimalViewInfo& OutResult)
 {
 	Super::CalcCamera(DeltaTime, OutResult);
 
 	OutResult.Rotation = FRotator(-90.0f, -90.0f, 0.0f);
+	OutResult.Location.X += CameraPan.X;
+	OutResult.Location.Y += CameraPan.Y;
+	OutResult.Location.Z = BoardZ + (OutResult.Location.Z - BoardZ) / CameraZoom;
+
+	ViewportWidth = 0;
+	int32 ViewportHeight = 0;
+	const APlayerController* PlayerController = Cast<APlayerController>(GetController());
+	if (PlayerController != nullptr)
+	{
+		PlayerController->GetViewportSize(ViewportWidth, ViewportHeight);
+	}
+
+	// The field of view is horizontal
+	const float HalfWidth = (OutResult.Location.Z - BoardZ) * FMath::Tan(FMath::DegreesToRadians(OutResult.FOV * 0.5f));
+	const float AspectRatio = ViewportWidth > 0 && ViewportHeight > 0 ? static_cast<float>(ViewportWidth) / ViewportHeight : OutResult.AspectRatio;
+	ViewExtent = FVector2D(HalfWidth, HalfWidth / AspectRatio);
+	ViewCentre = FVector2D(OutResult.Location.X, OutResult.Location.Y);
+}
+
+void AColourWarsPawn::SetBoardBounds(float InBoardZ, const FVector2D& InBoardMin, const FVector2D& InBoardMax)
+{
+	BoardZ = InBoardZ;
+	BoardMin = InBoardMin;
+	BoardMax = InBoardMax;
+}
+
+bool AColourWarsPawn::GetBoardView(FVector2D& OutMin, FVector2D& OutMax) const
+{
+	if (ViewExtent.IsZero())
+	{
+		return false;
+	}
+
+	OutMin = ViewCentre - ViewExtent;
+	OutMax = ViewCentre + ViewExtent;
+	return true;
+}
+
+/// <summary>
+/// Pan by the same part of the view whatever the zoom, keeping the centre of the view over the board
+/// </summary>
+void AColourWarsPawn::PanRight(float Value)
+{
+	if (Value == 0.f || ViewExtent.IsZero())
+	{
+		return;
+	}
+
+	const float Pan = Value * PanSpeed * ViewExtent.X * 2.f * GetWorld()->GetDeltaSeconds();
+	CameraPan.X = FMath::Clamp(ViewCentre.X + Pan, BoardMin.X, BoardMax.X) - (ViewCentre.X - CameraPan.X);
+}
+
+void AColourWarsPawn::PanUp(float Value)
+{
+	if (Value == 0.f || ViewExtent.IsZero())
+	{
+		return;
+	}
+
+	const float Pan = -Value * PanSpeed * ViewExtent.Y * 2.f * GetWorld()->GetDeltaSeconds();
+	CameraPan.Y = FMath::Clamp(ViewCentre.Y + Pan, BoardMin.Y, BoardMax.Y) - (ViewCentre.Y - CameraPan.Y);
+}
+
+void AColourWarsPawn::Zoom(float Value)
+{
+	if (Value == 0.f)
+	{
+		return;
+	}
+
+	CameraZoom = FMath::Clamp(CameraZoom * FMath::Pow(ZoomStep, Value), MinZoom, MaxZoom);
 }
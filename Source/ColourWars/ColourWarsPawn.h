@@ -17,6 +17,58 @@ public:
 
 	virtual void CalcCamera(float DeltaTime, struct FMinimalViewInfo& OutResult) override;
 
+	/** Speed the camera pans at, in views per second */
+	UPROPERTY(Category = Camera, EditAnywhere, BlueprintReadWrite)
+		float PanSpeed = 1.f;
+
+	/** Change in zoom for each step of the mouse wheel */
+	UPROPERTY(Category = Camera, EditAnywhere, BlueprintReadWrite)
+		float ZoomStep = 1.25f;
+
+	/** Furthest the camera zooms out and closest it zooms in, relative to where the pawn was placed */
+	UPROPERTY(Category = Camera, EditAnywhere, BlueprintReadWrite)
+		float MinZoom = 0.25f;
+
+	UPROPERTY(Category = Camera, EditAnywhere, BlueprintReadWrite)
+		float MaxZoom = 8.f;
+
+	/** Set the plane the board lies in and its extent, the camera zooms towards the plane and pans within the extent */
+	void SetBoardBounds(float InBoardZ, const FVector2D& InBoardMin, const FVector2D& InBoardMax);
+
+	/** Part of the board plane the camera saw on the last frame, false before the first frame */
+	bool GetBoardView(FVector2D& OutMin, FVector2D& OutMax) const;
+
+	/** Pixels across the screen each unit of the board plane took up on the last frame, 0 without a viewport */
+	float GetPixelsPerUnit() const { return ViewExtent.X > 0.f ? ViewportWidth / (ViewExtent.X * 2.f) : 0.f; }
+
 protected:
 
+	/** Handle the pan and zoom axes */
+	void PanRight(float Value);
+
+	void PanUp(float Value);
+
+	void Zoom(float Value);
+
+private:
+
+	/** Offset of the camera from the pawn along the board */
+	FVector2D CameraPan = FVector2D::ZeroVector;
+
+	/** Height of the pawn above the board is divided by this */
+	float CameraZoom = 1.f;
+
+	float BoardZ = 0.f;
+
+	/** Extent of the board, the camera can pan anywhere until the grid sets it */
+	FVector2D BoardMin = FVector2D(-BIG_NUMBER, -BIG_NUMBER);
+
+	FVector2D BoardMax = FVector2D(BIG_NUMBER, BIG_NUMBER);
+
+	/** Half the width and height of the board plane seen on the last frame, and the point seen at the centre */
+	FVector2D ViewExtent = FVector2D::ZeroVector;
+
+	FVector2D ViewCentre = FVector2D::ZeroVector;
+
+	int32 ViewportWidth = 0;
 };
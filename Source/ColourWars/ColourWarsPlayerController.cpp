@@ -3,22 +3,126 @@
 #include "ColourWarsPlayerController.h"
 #include "Kismet/GameplayStatics.h"
 #include "Engine/World.h"
+#include "Components/InputComponent.h"
+#include "Net/UnrealNetwork.h"
+
+namespace
+{
+	/** Positions a hint searches between checks of the clock, a few microseconds each even on a large board */
+	const int32 HintNodesPerTimeCheck = 8;
+}
 
 AColourWarsPlayerController::AColourWarsPlayerController()
 {
 	bShowMouseCursor = true;
-	bEnableClickEvents = true;
-	bEnableTouchEvents = true;
 	DefaultMouseCursor = EMouseCursor::Crosshairs;
+
+	// Clicks are picked on the board plane rather than traced against components
+	bEnableClickEvents = false;
+	bEnableTouchEvents = false;
+}
+
+void AColourWarsPlayerController::SetupInputComponent()
+{
+	Super::SetupInputComponent();
+
+	InputComponent->BindAction("SelectCell", IE_Pressed, this, &AColourWarsPlayerController::SelectCellUnderCursor);
+	InputComponent->BindTouch(IE_Pressed, this, &AColourWarsPlayerController::SelectCellUnderFinger);
+}
+
+void AColourWarsPlayerController::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AColourWarsPlayerController, Seat);
+}
+
+void AColourWarsPlayerController::PlayerTick(float DeltaTime)
+{
+	Super::PlayerTick(DeltaTime);
+
+	if (bHintRunning)
+	{
+		StepHint();
+	}
+}
+
+bool AColourWarsPlayerController::CanPlayFor(eBlockType Player) const
+{
+	return GetNetMode() == NM_Standalone || Seat == Player;
 }
 
 void AColourWarsPlayerController::EndTurn()
 {
-	GetGameMode()->NextTurn();
+	const FColourWarsMove Move = GetGameState()->GetSelectedTurnMove();
+	const FColourWarsBoard& Board = GetGameState()->GetGameGrid()->GetBoard();
+
+	// Only the move is sent, the server plays it and replicates the cells it changed back
+	ServerPlayTurn(Move.MoveType, Board.ToIndex(Move.From), Board.ToIndex(Move.To));
 
 	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, TEXT("Turn ended."));
 }
 
+bool AColourWarsPlayerController::ServerPlayTurn_Validate(eMoveType MoveType, int32 FromIndex, int32 ToIndex)
+{
+	return MoveType <= eMoveType::AddOne && FromIndex >= 0 && ToIndex >= 0;
+}
+
+void AColourWarsPlayerController::ServerPlayTurn_Implementation(eMoveType MoveType, int32 FromIndex, int32 ToIndex)
+{
+	const FColourWarsBoard& Board = GetGameState()->GetGameGrid()->GetBoard();
+	if (FromIndex >= Board.GetNumCells() || ToIndex >= Board.GetNumCells())
+	{
+		return;
+	}
+
+	GetGameMode()->PlayTurn(this, FColourWarsMove(MoveType, Board.ToCoord(FromIndex), Board.ToCoord(ToIndex)));
+}
+
+void AColourWarsPlayerController::SelectCellUnderCursor()
+{
+	if (GetGameState()->GetGameOver())
+	{
+		return;
+	}
+
+	float MouseX = 0.f;
+	float MouseY = 0.f;
+	if (GetMousePosition(MouseX, MouseY))
+	{
+		SelectCellAt(FVector2D(MouseX, MouseY));
+	}
+}
+
+void AColourWarsPlayerController::SelectCellUnderFinger(ETouchIndex::Type FingerIndex, FVector Location)
+{
+	if (!GetGameState()->GetGameOver())
+	{
+		SelectCellAt(FVector2D(Location));
+	}
+}
+
+/// <summary>
+/// Turn the point into a ray from the camera and let the grid work out the cell it meets, without any trace
+/// </summary>
+void AColourWarsPlayerController::SelectCellAt(const FVector2D& ScreenPosition)
+{
+	AColourWarsBlockGrid* Grid = GetGameState()->GetGameGrid();
+	if (Grid == nullptr || !Grid->HasSpawnedBlocks())
+	{
+		return;
+	}
+
+	FVector RayOrigin;
+	FVector RayDirection;
+	IntVector GridCoord;
+	if (DeprojectScreenPositionToWorld(ScreenPosition.X, ScreenPosition.Y, RayOrigin, RayDirection)
+		&& Grid->GetCellUnderRay(RayOrigin, RayDirection, GridCoord))
+	{
+		Grid->ClickCell(GridCoord);
+	}
+}
+
 void AColourWarsPlayerController::SetMove(eMoveType MoveType)
 {
 	if (MoveType == eMoveType::Invalid)
@@ -34,6 +138,118 @@ void AColourWarsPlayerController::SetMove(eMoveType MoveType)
 	}
 }
 
+void AColourWarsPlayerController::Hint()
+{
+	const FColourWarsBoard& Board = GetGameState()->GetGameGrid()->GetBoard();
+	if (Board.IsGameOver() || !CanPlayFor(Board.GetCurrentPlayer()))
+	{
+		return;
+	}
+
+	if (!HintSearch.IsValid())
+	{
+		HintSearch = MakeUnique<FColourWarsSearch>();
+	}
+
+	HintSearch->Start(Board);
+	HintBoardHash = Board.GetHash();
+	HintEndTime = FPlatformTime::Seconds() + HintSeconds;
+	HintMove = FColourWarsMove();
+	bHintRunning = true;
+
+	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, TEXT("Looking for a hint."));
+}
+
+/// <summary>
+/// Step the search a few positions at a time until this frame's slice is used up, so a hint never costs a frame
+/// more than the slice, then select the blocks of the best move so far. The search is anytime: it always has the
+/// best move of its deepest finished iteration, and the hint settles on it once the budget runs out.
+/// </summary>
+void AColourWarsPlayerController::StepHint()
+{
+	const FColourWarsBoard& Board = GetGameState()->GetGameGrid()->GetBoard();
+	if (Board.GetHash() != HintBoardHash)
+	{
+		bHintRunning = false;
+		return;
+	}
+
+	const double SliceEndTime = FMath::Min(FPlatformTime::Seconds() + HintMillisecondsPerFrame / 1000.0, HintEndTime);
+	bool bFinished = HintSearch->IsFinished();
+	while (!bFinished && FPlatformTime::Seconds() < SliceEndTime)
+	{
+		bFinished = HintSearch->Step(HintNodesPerTimeCheck);
+	}
+
+	const FColourWarsMove BestMove = HintSearch->GetBestMove();
+	if (!(BestMove == HintMove) && BestMove.MoveType != eMoveType::Invalid)
+	{
+		HintMove = BestMove;
+		GetGameState()->SelectTurnMove(HintMove);
+	}
+
+	if (bFinished || FPlatformTime::Seconds() >= HintEndTime)
+	{
+		bHintRunning = false;
+		GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, FString::Printf(TEXT("Hint searched %d turns ahead."), HintSearch->GetCompletedDepth()));
+	}
+}
+
+void AColourWarsPlayerController::ServerReportHash_Implementation(int32 Turn, uint64 Hash)
+{
+	GetGameState()->CheckLockstepHash(this, Turn, Hash);
+}
+
+void AColourWarsPlayerController::ClientReportDesync_Implementation(int32 Turn)
+{
+	GEngine->AddOnScreenDebugMessage(-1, 30.f, FColor::Red, FString::Printf(TEXT("Desynced from the server playing turn %d."), Turn));
+}
+
+void AColourWarsPlayerController::ToggleAnalysis()
+{
+	AColourWarsBlockGrid* Grid = GetGameState()->GetGameGrid();
+	Grid->SetShowAnalysis(!Grid->IsShowingAnalysis());
+
+	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, Grid->IsShowingAnalysis() ? TEXT("Analysis shown.") : TEXT("Analysis hidden."));
+}
+
+void AColourWarsPlayerController::Undo()
+{
+	// Only the server has a game mode
+	if (GetGameMode() == nullptr)
+	{
+		return;
+	}
+
+	GetGameMode()->UndoTurn();
+
+	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, TEXT("Turn undone."));
+}
+
+void AColourWarsPlayerController::Redo()
+{
+	if (GetGameMode() == nullptr)
+	{
+		return;
+	}
+
+	GetGameMode()->RedoTurn();
+
+	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, TEXT("Turn redone."));
+}
+
+void AColourWarsPlayerController::SaveGame()
+{
+	if (GetGameMode() == nullptr)
+	{
+		return;
+	}
+
+	GetGameMode()->SaveGame();
+
+	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, TEXT("Game saved."));
+}
+
 AColourWarsGameState* AColourWarsPlayerController::GetGameState()
 {
 	if (GameState == nullptr)
@@ -6,6 +6,7 @@
 #include "ColourWarsBlock.h"
 #include "ColourWarsGameState.h"
 #include "ColourWarsGameMode.h"
+#include "ColourWarsSearch.h"
 #include "GameFramework/PlayerController.h"
 #include "ColourWarsPlayerController.generated.h"
 
@@ -27,14 +28,98 @@ private:
 
 	AColourWarsGameMode* GetGameMode();
 
+	/** Player this controller plays as in an online match, None for a spectator */
+	UPROPERTY(Replicated)
+		eBlockType Seat = eBlockType::None;
+
+	/** Ask the server to play a turn, the cells are sent as indices on the board */
+	UFUNCTION(Server, Reliable, WithValidation)
+		void ServerPlayTurn(eMoveType MoveType, int32 FromIndex, int32 ToIndex);
+
+	/** Search behind the hint, kept between hints so its table carries on from earlier turns */
+	TUniquePtr<FColourWarsSearch> HintSearch;
+
+	bool bHintRunning = false;
+
+	/** Time the hint settles on its move */
+	double HintEndTime = 0.0;
+
+	/** Hash of the board the hint is for, the hint stops if a turn is played or undone */
+	uint64 HintBoardHash = 0;
+
+	/** Move the blocks are showing */
+	FColourWarsMove HintMove;
+
+	/** Search the hint for this frame's share of time and show its best move if it changed */
+	void StepHint();
+
+	/** Click the cell under the cursor */
+	void SelectCellUnderCursor();
+
+	/** Click the cell under a finger that has touched the screen */
+	void SelectCellUnderFinger(ETouchIndex::Type FingerIndex, FVector Location);
+
+	/** Click the cell of the board under a point on the screen, if there is one */
+	void SelectCellAt(const FVector2D& ScreenPosition);
+
+protected:
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	virtual void SetupInputComponent() override;
+
 public:
 	AColourWarsPlayerController();
 
+	virtual void PlayerTick(float DeltaTime) override;
+
+	/** Time a hint searches for before it settles on its move */
+	UPROPERTY(Category = Hint, EditAnywhere, BlueprintReadWrite)
+		float HintSeconds = 1.f;
+
+	/** Time a hint searches for in each frame, small enough that a frame is never dropped */
+	UPROPERTY(Category = Hint, EditAnywhere, BlueprintReadWrite)
+		float HintMillisecondsPerFrame = 2.f;
+
+	void SetSeat(eBlockType InSeat) { Seat = InSeat; }
+
+	eBlockType GetSeat() const { return Seat; }
+
+	/** Can this controller take the turns of the player, any player can be played in a local game */
+	bool CanPlayFor(eBlockType Player) const;
+
+	/** Send the client's board hash after playing a turn of a lockstep match */
+	UFUNCTION(Server, Reliable)
+		void ServerReportHash(int32 Turn, uint64 Hash);
+
+	/** Tell the client its board no longer matches the server's */
+	UFUNCTION(Client, Reliable)
+		void ClientReportDesync(int32 Turn);
+
 	UFUNCTION(BluePrintCallable, meta = (DisplayName = "End Turn"), Category = Moves)
 		void EndTurn();
 
 	UFUNCTION(BluePrintCallable, meta = (DisplayName = "Set Move"), Category = Moves)
 		void SetMove(eMoveType MoveType);
+
+	/** Search for a good move over the next frames, selecting its blocks as it improves */
+	UFUNCTION(BluePrintCallable, meta = (DisplayName = "Hint"), Category = Moves)
+		void Hint();
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = Moves)
+		bool IsHintRunning() const { return bHintRunning; }
+
+	/** Show or hide the heat of the best move onto each block for the player to move */
+	UFUNCTION(BluePrintCallable, meta = (DisplayName = "Toggle Analysis"), Category = Moves)
+		void ToggleAnalysis();
+
+	UFUNCTION(BluePrintCallable, meta = (DisplayName = "Undo"), Category = Moves)
+		void Undo();
+
+	UFUNCTION(BluePrintCallable, meta = (DisplayName = "Redo"), Category = Moves)
+		void Redo();
+
+	UFUNCTION(BluePrintCallable, meta = (DisplayName = "Save Game"), Category = Moves)
+		void SaveGame();
 };
 
 
@@ -0,0 +1,425 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsReplay.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogColourWarsReplay, Log, All);
+
+FColourWarsReplayWriter::FColourWarsReplayWriter()
+	: KeyframeInterval(ColourWarsReplay::DefaultKeyframeInterval)
+	, Size(0)
+	, NumTurns(0)
+{
+}
+
+FColourWarsReplayWriter::~FColourWarsReplayWriter()
+{
+	Finish();
+}
+
+bool FColourWarsReplayWriter::Begin(const FString& Filename, uint32 Seed, const FColourWarsBoard& Board, int32 InKeyframeInterval)
+{
+	Finish();
+
+	// The file is written through a handle rather than a file writer archive, so undo can truncate it
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Filename));
+	FileHandle.Reset(PlatformFile.OpenWrite(*Filename));
+	if (!FileHandle.IsValid())
+	{
+		UE_LOG(LogColourWarsReplay, Error, TEXT("Could not create replay %s."), *Filename);
+		return false;
+	}
+
+	ReplayFilename = Filename;
+	KeyframeInterval = FMath::Max(1, InKeyframeInterval);
+	Size = Board.GetSize();
+	NumTurns = 0;
+	Keyframes.Reset();
+	TurnOffsets.Reset();
+
+	uint32 Magic = ColourWarsReplay::FileMagic;
+	uint16 Version = ColourWarsReplay::Version;
+	uint32 PackedSize = Size;
+	uint8 Players = Board.GetNumberOfPlayers();
+	uint32 PackedInterval = KeyframeInterval;
+
+	FMemoryWriter Ar(Buffer);
+	Ar << Magic;
+	Ar << Version;
+	Ar << Seed;
+	Ar.SerializeIntPacked(PackedSize);
+	Ar << Players;
+	Ar.SerializeIntPacked(PackedInterval);
+
+	if (!WriteBuffer())
+	{
+		FileHandle.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+void FColourWarsReplayWriter::RecordTurn(const FColourWarsMove& Move, const FColourWarsBoard& Board)
+{
+	if (!FileHandle.IsValid())
+	{
+		return;
+	}
+
+	const int64 TurnOffset = FileHandle->Tell();
+	TurnOffsets.Add(TurnOffset);
+
+	FMemoryWriter Ar(Buffer);
+
+	// The first turn always has a keyframe, as a resumed match does not start from turn 0
+	if (Keyframes.Num() == 0 || Board.GetTurn() % KeyframeInterval == 0)
+	{
+		Keyframes.Add({ Board.GetTurn(), TurnOffset });
+
+		uint8 Tag = ColourWarsReplay::KeyframeTag;
+		Ar << Tag;
+
+		// Serialize only reads from the board when saving
+		const_cast<FColourWarsBoard&>(Board).Serialize(Ar);
+	}
+
+	uint8 Tag = static_cast<uint8>(Move.MoveType);
+	Ar << Tag;
+
+	if (Move.MoveType != eMoveType::Invalid)
+	{
+		uint32 From = Board.ToIndex(Move.From);
+		Ar.SerializeIntPacked(From);
+	}
+
+	if (Move.MoveType == eMoveType::Move)
+	{
+		uint32 To = Board.ToIndex(Move.To);
+		Ar.SerializeIntPacked(To);
+	}
+
+	NumTurns++;
+	WriteBuffer();
+}
+
+/// <summary>
+/// Truncate the file at the offset the turn's records start at, so the file never holds turns that were undone,
+/// even if the match is never finished
+/// </summary>
+void FColourWarsReplayWriter::UndoTurn()
+{
+	if (!FileHandle.IsValid() || NumTurns == 0)
+	{
+		return;
+	}
+
+	NumTurns--;
+	const int64 TurnOffset = TurnOffsets.Pop();
+	Keyframes.RemoveAll([TurnOffset](const FColourWarsReplayKeyframe& Keyframe) { return Keyframe.Offset >= TurnOffset; });
+
+	// Recording carries on from the turn's offset either way, so the next turn overwrites the undone one
+	if (!FileHandle->Truncate(TurnOffset))
+	{
+		UE_LOG(LogColourWarsReplay, Warning, TEXT("Could not truncate replay %s to %lld bytes, the undone turn is left after the last record."),
+			*ReplayFilename, TurnOffset);
+	}
+
+	FileHandle->Seek(TurnOffset);
+}
+
+bool FColourWarsReplayWriter::WriteBuffer()
+{
+	const bool bWritten = FileHandle->Write(Buffer.GetData(), Buffer.Num());
+	if (!bWritten)
+	{
+		UE_LOG(LogColourWarsReplay, Error, TEXT("Could not write to replay %s."), *ReplayFilename);
+	}
+
+	Buffer.Reset();
+	return bWritten;
+}
+
+void FColourWarsReplayWriter::Finish()
+{
+	if (!FileHandle.IsValid())
+	{
+		return;
+	}
+
+	int64 IndexOffset = FileHandle->Tell();
+	FMemoryWriter Ar(Buffer);
+
+	uint8 Tag = ColourWarsReplay::IndexTag;
+	uint32 PackedTurns = NumTurns;
+	uint32 PackedKeyframes = Keyframes.Num();
+	Ar << Tag;
+	Ar.SerializeIntPacked(PackedTurns);
+	Ar.SerializeIntPacked(PackedKeyframes);
+
+	for (FColourWarsReplayKeyframe& Keyframe : Keyframes)
+	{
+		uint32 PackedTurn = Keyframe.Turn;
+		Ar.SerializeIntPacked(PackedTurn);
+		Ar << Keyframe.Offset;
+	}
+
+	uint32 Magic = ColourWarsReplay::IndexMagic;
+	Ar << IndexOffset;
+	Ar << Magic;
+
+	WriteBuffer();
+	FileHandle.Reset();
+}
+
+FColourWarsReplayReader::FColourWarsReplayReader()
+	: RecordsStart(0)
+	, RecordsEnd(0)
+	, Seed(0)
+	, Size(0)
+	, NumberOfPlayers(0)
+	, KeyframeInterval(ColourWarsReplay::DefaultKeyframeInterval)
+	, NumTurns(0)
+{
+}
+
+bool FColourWarsReplayReader::Open(const FString& Filename)
+{
+	Archive.Reset(IFileManager::Get().CreateFileReader(*Filename));
+	if (!Archive.IsValid())
+	{
+		return false;
+	}
+
+	FArchive& Ar = *Archive;
+
+	uint32 Magic = 0;
+	uint16 Version = 0;
+	uint32 PackedSize = 0;
+	uint8 Players = 0;
+	uint32 PackedInterval = 0;
+
+	Ar << Magic;
+	Ar << Version;
+	if (Ar.IsError() || Magic != ColourWarsReplay::FileMagic || Version > ColourWarsReplay::Version)
+	{
+		Archive.Reset();
+		return false;
+	}
+
+	Ar << Seed;
+	Ar.SerializeIntPacked(PackedSize);
+	Ar << Players;
+	Ar.SerializeIntPacked(PackedInterval);
+
+	// Cell indices are divided by the size, so a corrupt header is refused before any turn is read
+	if (Ar.IsError() || PackedSize < 2 || PackedSize > FColourWarsBoard::MaxSize || Players < 2 || Players > 4)
+	{
+		Archive.Reset();
+		return false;
+	}
+
+	Size = PackedSize;
+	NumberOfPlayers = Players;
+	KeyframeInterval = FMath::Max<int32>(1, PackedInterval);
+	RecordsStart = Ar.Tell();
+	RecordsEnd = Ar.TotalSize();
+	Keyframes.Reset();
+	NumTurns = 0;
+
+	// Read the index through the trailer at the end of the file
+	const int64 TrailerSize = sizeof(int64) + sizeof(uint32);
+	if (Ar.TotalSize() - TrailerSize > RecordsStart)
+	{
+		int64 IndexOffset = 0;
+		uint32 TrailerMagic = 0;
+		Ar.Seek(Ar.TotalSize() - TrailerSize);
+		Ar << IndexOffset;
+		Ar << TrailerMagic;
+
+		if (TrailerMagic == ColourWarsReplay::IndexMagic && IndexOffset >= RecordsStart && IndexOffset < Ar.TotalSize())
+		{
+			uint8 Tag = 0;
+			uint32 PackedTurns = 0;
+			uint32 PackedKeyframes = 0;
+			Ar.Seek(IndexOffset);
+			Ar << Tag;
+			Ar.SerializeIntPacked(PackedTurns);
+			Ar.SerializeIntPacked(PackedKeyframes);
+
+			for (uint32 KeyframeIndex = 0; KeyframeIndex < PackedKeyframes && !Ar.IsError(); KeyframeIndex++)
+			{
+				uint32 PackedTurn = 0;
+				FColourWarsReplayKeyframe Keyframe;
+				Ar.SerializeIntPacked(PackedTurn);
+				Ar << Keyframe.Offset;
+				Keyframe.Turn = PackedTurn;
+				Keyframes.Add(Keyframe);
+			}
+
+			if (Tag == ColourWarsReplay::IndexTag && !Ar.IsError())
+			{
+				NumTurns = PackedTurns;
+				RecordsEnd = IndexOffset;
+			}
+			else
+			{
+				Keyframes.Reset();
+			}
+		}
+	}
+
+	if (RecordsEnd == Ar.TotalSize())
+	{
+		RebuildIndex();
+	}
+
+	return true;
+}
+
+void FColourWarsReplayReader::RebuildIndex()
+{
+	FArchive& Ar = *Archive;
+	Ar.Seek(RecordsStart);
+	Keyframes.Reset();
+	NumTurns = 0;
+
+	FColourWarsBoard KeyframeBoard;
+	FColourWarsMove Move;
+	while (!Ar.AtEnd())
+	{
+		const int64 RecordOffset = Ar.Tell();
+		uint8 Tag = 0;
+		Ar << Tag;
+		Ar.Seek(RecordOffset);
+
+		if (!ReadTurn(Move, &KeyframeBoard))
+		{
+			// A truncated last record is dropped
+			break;
+		}
+
+		if (Tag == ColourWarsReplay::KeyframeTag)
+		{
+			Keyframes.Add({ KeyframeBoard.GetTurn(), RecordOffset });
+		}
+
+		NumTurns++;
+	}
+}
+
+bool FColourWarsReplayReader::ReadTurn(FColourWarsMove& OutMove, FColourWarsBoard* KeyframeBoard)
+{
+	FArchive& Ar = *Archive;
+	if (Ar.Tell() >= RecordsEnd)
+	{
+		return false;
+	}
+
+	uint8 Tag = 0;
+	Ar << Tag;
+
+	if (Tag == ColourWarsReplay::KeyframeTag)
+	{
+		FColourWarsBoard SkippedBoard;
+		(KeyframeBoard != nullptr ? *KeyframeBoard : SkippedBoard).Serialize(Ar);
+		Ar << Tag;
+	}
+
+	if (Ar.IsError() || Tag > static_cast<uint8>(eMoveType::AddOne))
+	{
+		return false;
+	}
+
+	OutMove = FColourWarsMove();
+	OutMove.MoveType = static_cast<eMoveType>(Tag);
+
+	if (OutMove.MoveType != eMoveType::Invalid)
+	{
+		uint32 From = 0;
+		Ar.SerializeIntPacked(From);
+		if (From >= (uint32)(Size * Size))
+		{
+			return false;
+		}
+		OutMove.From = IntVector(From / Size, From % Size);
+	}
+
+	if (OutMove.MoveType == eMoveType::Move)
+	{
+		uint32 To = 0;
+		Ar.SerializeIntPacked(To);
+		if (To >= (uint32)(Size * Size))
+		{
+			return false;
+		}
+		OutMove.To = IntVector(To / Size, To % Size);
+	}
+
+	return !Ar.IsError() && Ar.Tell() <= RecordsEnd;
+}
+
+bool FColourWarsReplayReader::SeekToTurn(int32 Turn, FColourWarsBoard& OutBoard)
+{
+	if (!Archive.IsValid() || Keyframes.Num() == 0 || Turn < GetFirstTurn() || Turn > GetFirstTurn() + NumTurns)
+	{
+		return false;
+	}
+
+	// Keyframes are written every KeyframeInterval turns so the right one can be found directly,
+	// the first is the exception when the match was resumed part way through
+	int32 KeyframeIndex = FMath::Min(Turn / KeyframeInterval - GetFirstTurn() / KeyframeInterval, Keyframes.Num() - 1);
+	while (KeyframeIndex > 0 && Keyframes[KeyframeIndex].Turn > Turn)
+	{
+		KeyframeIndex--;
+	}
+
+	FArchive& Ar = *Archive;
+	Ar.Seek(Keyframes[KeyframeIndex].Offset);
+
+	uint8 Tag = 0;
+	Ar << Tag;
+	OutBoard.Serialize(Ar);
+	if (Ar.IsError() || Tag != ColourWarsReplay::KeyframeTag || OutBoard.GetSize() != Size)
+	{
+		return false;
+	}
+
+	while (OutBoard.GetTurn() < Turn)
+	{
+		if (!Step(OutBoard))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FColourWarsReplayReader::Step(FColourWarsBoard& Board, FColourWarsMove* OutMove)
+{
+	FColourWarsMove Move;
+	if (!Archive.IsValid() || !ReadTurn(Move, nullptr))
+	{
+		return false;
+	}
+
+	// A recorded turn was legal when it was played, one that is not comes from a corrupt file
+	if (!Board.IsLegalMove(Move))
+	{
+		return false;
+	}
+
+	Board.ApplyTurn(Move);
+
+	if (OutMove != nullptr)
+	{
+		*OutMove = Move;
+	}
+
+	return true;
+}
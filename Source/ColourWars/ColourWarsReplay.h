@@ -0,0 +1,137 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColourWarsBoard.h"
+
+class IFileHandle;
+
+/**
+ * Replay files are a header followed by a stream of records and, once the match has finished, an index.
+ *
+ * Header:   uint32 magic, uint16 version, uint32 seed, packed size, uint8 players, packed keyframe interval
+ * Turn:     uint8 eMoveType, then the packed cell index of From (and of To for a Move)
+ * Keyframe: uint8 ReplayKeyframeTag, then the FColourWarsBoard at the start of that turn
+ * Index:    uint8 ReplayIndexTag, packed turn count, packed keyframe count, then (packed turn, int64 offset) pairs
+ * Trailer:  int64 offset of the index, uint32 index magic
+ *
+ * A keyframe is written before the first recorded turn and every KeyframeInterval'th turn after it, so seeking
+ * never replays more than that many turns. A resumed match starts recording part way through, at its first keyframe.
+ * If the trailer is missing, because the app was closed mid match, the index is rebuilt by scanning the records.
+ * Undoing a turn cuts its records off the end of the file, so the records are always the turns still in the match.
+ */
+namespace ColourWarsReplay
+{
+	const uint32 FileMagic = 0x50525743;
+	const uint32 IndexMagic = 0x49525743;
+	const uint16 Version = 1;
+	const uint8 KeyframeTag = 0x80;
+	const uint8 IndexTag = 0x81;
+	const int32 DefaultKeyframeInterval = 32;
+}
+
+/** Position in the file of the full board at the start of a turn */
+struct FColourWarsReplayKeyframe
+{
+	int32 Turn;
+	int64 Offset;
+};
+
+/** Streams the turns of a match to a replay file as they are played */
+class COLOURWARS_API FColourWarsReplayWriter
+{
+public:
+	FColourWarsReplayWriter();
+	~FColourWarsReplayWriter();
+
+	/** Create the file and write the header */
+	bool Begin(const FString& Filename, uint32 Seed, const FColourWarsBoard& Board, int32 InKeyframeInterval = ColourWarsReplay::DefaultKeyframeInterval);
+
+	/** Record a turn before it is applied to the board, writing a keyframe first if one is due */
+	void RecordTurn(const FColourWarsMove& Move, const FColourWarsBoard& Board);
+
+	/** Truncate the last recorded turn off the file after it has been undone */
+	void UndoTurn();
+
+	/** Write the index and close the file */
+	void Finish();
+
+	bool IsRecording() const { return FileHandle.IsValid(); }
+
+private:
+	/** Write the records serialised into Buffer to the file and empty it, logging if the write fails */
+	bool WriteBuffer();
+
+	TUniquePtr<IFileHandle> FileHandle;
+
+	FString ReplayFilename;
+
+	/** Records of the turn being written, written to the file in one go */
+	TArray<uint8> Buffer;
+
+	TArray<FColourWarsReplayKeyframe> Keyframes;
+
+	/** Offset each turn's records start at */
+	TArray<int64> TurnOffsets;
+
+	int32 KeyframeInterval;
+
+	int32 Size;
+
+	int32 NumTurns;
+};
+
+/** Reads a replay file and reconstructs the board at any turn */
+class COLOURWARS_API FColourWarsReplayReader
+{
+public:
+	FColourWarsReplayReader();
+
+	/** Open the file and read the header and index */
+	bool Open(const FString& Filename);
+
+	uint32 GetSeed() const { return Seed; }
+
+	int32 GetSize() const { return Size; }
+
+	int32 GetNumberOfPlayers() const { return NumberOfPlayers; }
+
+	int32 GetNumTurns() const { return NumTurns; }
+
+	/** Turn the recording starts at, which is only non zero for a resumed match */
+	int32 GetFirstTurn() const { return Keyframes.Num() > 0 ? Keyframes[0].Turn : 0; }
+
+	/** Set the board to the position at the start of the turn, replaying at most one keyframe interval of turns */
+	bool SeekToTurn(int32 Turn, FColourWarsBoard& OutBoard);
+
+	/** Read the next turn after the board's current one and apply it, returns false at the end of the replay */
+	bool Step(FColourWarsBoard& Board, FColourWarsMove* OutMove = nullptr);
+
+private:
+	/** Scan every record to recover the index of a replay that was never finished */
+	void RebuildIndex();
+
+	/** Read the next turn, reading any keyframe in front of it into KeyframeBoard */
+	bool ReadTurn(FColourWarsMove& OutMove, FColourWarsBoard* KeyframeBoard);
+
+	TUniquePtr<FArchive> Archive;
+
+	TArray<FColourWarsReplayKeyframe> Keyframes;
+
+	/** Offset of the first record after the header */
+	int64 RecordsStart;
+
+	/** Offset of the index, or the end of file when there is none */
+	int64 RecordsEnd;
+
+	uint32 Seed;
+
+	int32 Size;
+
+	int32 NumberOfPlayers;
+
+	int32 KeyframeInterval;
+
+	int32 NumTurns;
+};
@@ -0,0 +1,88 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsReplayCommandlet.h"
+#include "ColourWarsReplay.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogColourWarsReplay, Log, All);
+
+UColourWarsReplayCommandlet::UColourWarsReplayCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UColourWarsReplayCommandlet::Main(const FString& Params)
+{
+	FString Filename;
+	if (!FParse::Value(*Params, TEXT("Replay="), Filename))
+	{
+		UE_LOG(LogColourWarsReplay, Error, TEXT("Usage: -run=ColourWarsReplay -Replay=<file> [-Turn=<n>]"));
+		return 1;
+	}
+
+	FColourWarsReplayReader Reader;
+	if (!Reader.Open(Filename))
+	{
+		UE_LOG(LogColourWarsReplay, Error, TEXT("Could not read replay '%s'."), *Filename);
+		return 1;
+	}
+
+	UE_LOG(LogColourWarsReplay, Display, TEXT("Seed %u, %dx%d grid, %d players, %d turns."),
+		Reader.GetSeed(), Reader.GetSize(), Reader.GetSize(), Reader.GetNumberOfPlayers(), Reader.GetNumTurns());
+
+	FColourWarsBoard Board;
+	int32 Turn = 0;
+	if (FParse::Value(*Params, TEXT("Turn="), Turn))
+	{
+		if (!Reader.SeekToTurn(Turn, Board))
+		{
+			UE_LOG(LogColourWarsReplay, Error, TEXT("Could not seek to turn %d."), Turn);
+			return 1;
+		}
+
+		UE_LOG(LogColourWarsReplay, Display, TEXT("Turn %d, player %d to move:"), Turn, static_cast<int32>(Board.GetCurrentPlayer()));
+
+		// One row per X with each cell as <type><score>, capital blocks marked with a *
+		const TCHAR BlockLetters[] = TEXT(".RGBP");
+		for (int32 X = 0; X < Board.GetSize(); X++)
+		{
+			FString Row;
+			for (int32 Y = 0; Y < Board.GetSize(); Y++)
+			{
+				const int32 Index = Board.ToIndex(X, Y);
+				Row += FString::Printf(TEXT("%c%-3d%c"), BlockLetters[static_cast<int32>(Board.GetBlockType(Index))],
+					Board.GetScore(Index), Board.IsCapitalBlock(Index) ? TEXT('*') : TEXT(' '));
+			}
+			UE_LOG(LogColourWarsReplay, Display, TEXT("%s"), *Row);
+		}
+
+		return 0;
+	}
+
+	if (!Reader.SeekToTurn(Reader.GetFirstTurn(), Board))
+	{
+		UE_LOG(LogColourWarsReplay, Error, TEXT("Replay has no turns."));
+		return 1;
+	}
+
+	const TCHAR* MoveNames[] = { TEXT("Pass"), TEXT("Move"), TEXT("Combine"), TEXT("AddOne") };
+	FColourWarsMove Move;
+	while (Reader.Step(Board, &Move))
+	{
+		int32 Scores[5];
+		Board.GetPlayerScores(Scores);
+
+		UE_LOG(LogColourWarsReplay, Display, TEXT("%4d %-7s (%d,%d)->(%d,%d)  Red:%d Green:%d Blue:%d Purple:%d"),
+			Board.GetTurn(), MoveNames[static_cast<int32>(Move.MoveType)], Move.From.X, Move.From.Y, Move.To.X, Move.To.Y,
+			Scores[1], Scores[2], Scores[3], Scores[4]);
+	}
+
+	if (Board.IsGameOver())
+	{
+		UE_LOG(LogColourWarsReplay, Display, TEXT("Game over, winner is player %d."), static_cast<int32>(Board.GetCurrentPlayer()));
+	}
+
+	return 0;
+}
@@ -0,0 +1,24 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ColourWarsReplayCommandlet.generated.h"
+
+/**
+ * Headless replayer for analysing recorded matches.
+ *
+ * Usage: ColourWars -run=ColourWarsReplay -Replay=<file> [-Turn=<n>]
+ * Without -Turn every turn is listed with the player scores after it, with -Turn the board at that turn is printed.
+ */
+UCLASS()
+class UColourWarsReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UColourWarsReplayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
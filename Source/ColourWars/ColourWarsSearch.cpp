@@ -0,0 +1,319 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsSearch.h"
+#include "ColourWarsOpeningBook.h"
+
+namespace
+{
+	/** Scores at least this far from zero are won or lost positions, less the turns it takes to reach them */
+	const float DecidedScore = FColourWarsEval::WinScore - 4 * FColourWarsSearch::MaxPly;
+
+	/** Positions searched between checks of the clock */
+	const int32 NodesPerTimeCheck = 256;
+
+	/** Won and lost scores count plies from the root while searching, and from the position itself in the table */
+	float ToTableValue(float Value, int32 Ply)
+	{
+		return Value >= DecidedScore ? Value + Ply : Value <= -DecidedScore ? Value - Ply : Value;
+	}
+
+	float FromTableValue(float Value, int32 Ply)
+	{
+		return Value >= DecidedScore ? Value - Ply : Value <= -DecidedScore ? Value + Ply : Value;
+	}
+}
+
+FColourWarsTranspositionTable::FColourWarsTranspositionTable(int32 SizeLog2)
+{
+	Entries.SetNumZeroed(1 << FMath::Clamp(SizeLog2, 4, 30));
+	Mask = Entries.Num() - 1;
+}
+
+void FColourWarsTranspositionTable::Clear()
+{
+	FMemory::Memzero(Entries.GetData(), Entries.Num() * sizeof(FColourWarsSearchEntry));
+}
+
+const FColourWarsSearchEntry* FColourWarsTranspositionTable::Find(uint64 Key) const
+{
+	const FColourWarsSearchEntry& Entry = Entries[Key & Mask];
+	return Entry.Key == Key && Entry.Bound != EColourWarsSearchBound::None ? &Entry : nullptr;
+}
+
+void FColourWarsTranspositionTable::Store(const FColourWarsSearchEntry& Entry)
+{
+	Entries[Entry.Key & Mask] = Entry;
+}
+
+FColourWarsSearch::FColourWarsSearch(const FColourWarsEvalWeights& Weights, int32 TableSizeLog2)
+	: Eval(Weights)
+	, Table(TableSizeLog2)
+	, RootPlayer(eBlockType::None)
+	, MaxDepth(0)
+	, IterationDepth(0)
+	, CompletedDepth(0)
+	, BestScore(0.f)
+	, bFinished(true)
+	, NumNodes(0)
+	, StackDepth(0)
+{
+	// The root and one frame for each ply below it, so frames never move while they are referenced
+	Frames.SetNum(MaxPly + 1);
+}
+
+void FColourWarsSearch::Start(const FColourWarsBoard& InBoard, int32 InMaxDepth)
+{
+	Board = InBoard;
+	RootPlayer = Board.GetCurrentPlayer();
+	MaxDepth = FMath::Clamp(InMaxDepth, 1, MaxPly);
+	IterationDepth = 0;
+	CompletedDepth = 0;
+	BestMove = FColourWarsMove();
+	BestScore = 0.f;
+	NumNodes = 0;
+	StackDepth = 0;
+	Moves.Reset();
+
+	if (!Board.IsGameOver())
+	{
+		Board.GetLegalMoves(Moves);
+	}
+
+	// Something to play even if no iteration finishes
+	bFinished = Moves.Num() == 0;
+	if (!bFinished)
+	{
+		BestMove = Moves[0];
+	}
+	Moves.Reset();
+
+	// Book positions are played without searching
+	const FColourWarsOpeningBook* Book = FColourWarsOpeningBook::Find(Board.GetSize(), Board.GetNumberOfPlayers());
+	FColourWarsMove BookMove;
+	if (!bFinished && Book != nullptr && Book->Probe(Board, BookMove))
+	{
+		BestMove = BookMove;
+		bFinished = true;
+	}
+}
+
+/// <summary>
+/// Search the frame on top of the stack a position at a time: expand it, then search each of its moves in turn
+/// on a new frame, until every move is searched or one is good enough for the other side to avoid it
+/// </summary>
+bool FColourWarsSearch::Step(int32 NumNodesToSearch)
+{
+	int32 NodesLeft = NumNodesToSearch;
+
+	while (!bFinished && NodesLeft > 0)
+	{
+		if (StackDepth == 0)
+		{
+			if (IterationDepth >= MaxDepth)
+			{
+				bFinished = true;
+				break;
+			}
+
+			IterationDepth++;
+			PushFrame(IterationDepth, 0, -TNumericLimits<float>::Max(), TNumericLimits<float>::Max());
+		}
+
+		FFrame& Frame = Frames[StackDepth - 1];
+		if (!Frame.bExpanded)
+		{
+			NumNodes++;
+			NodesLeft--;
+
+			if (!ExpandFrame())
+			{
+				continue;
+			}
+		}
+
+		if (Frame.NextMove < Frame.NumMoves && Frame.Alpha < Frame.Beta)
+		{
+			const FColourWarsMove Move = Moves[Frame.FirstMove + Frame.NextMove++];
+			Board.ApplyTurn(Move, Frame.Delta);
+			PushFrame(Frame.Depth - 1, Frame.Ply + 1, Frame.Alpha, Frame.Beta);
+			continue;
+		}
+
+		FColourWarsSearchEntry Entry;
+		Entry.Key = Frame.Key;
+		Entry.Value = ToTableValue(Frame.BestValue, Frame.Ply);
+		Entry.Depth = Frame.Depth;
+		Entry.Bound = Frame.BestValue <= Frame.StartAlpha ? EColourWarsSearchBound::Upper
+			: Frame.BestValue >= Frame.StartBeta ? EColourWarsSearchBound::Lower
+			: EColourWarsSearchBound::Exact;
+		const FColourWarsMove CanonicalMove = Frame.Symmetry.Apply(Frame.BestMove, Board.GetSize());
+		Entry.MoveType = CanonicalMove.MoveType;
+		Entry.MoveFrom = Board.ToIndex(CanonicalMove.From);
+		Entry.MoveTo = Board.ToIndex(CanonicalMove.To);
+		Table.Store(Entry);
+
+		ReturnValue(Frame.BestValue);
+	}
+
+	return bFinished;
+}
+
+FColourWarsMove FColourWarsSearch::Search(const FColourWarsBoard& InBoard, double Seconds, int32 InMaxDepth)
+{
+	Start(InBoard, InMaxDepth);
+
+	const double EndTime = FPlatformTime::Seconds() + Seconds;
+	while (!Step(NodesPerTimeCheck) && FPlatformTime::Seconds() < EndTime)
+	{
+	}
+
+	return BestMove;
+}
+
+void FColourWarsSearch::PushFrame(int32 Depth, int32 Ply, float Alpha, float Beta)
+{
+	FFrame& Frame = Frames[StackDepth++];
+	Frame.Depth = Depth;
+	Frame.Ply = Ply;
+	Frame.Alpha = Alpha;
+	Frame.Beta = Beta;
+	Frame.StartAlpha = Alpha;
+	Frame.StartBeta = Beta;
+	Frame.BestMove = FColourWarsMove();
+	Frame.bExpanded = false;
+	Frame.FirstMove = Moves.Num();
+	Frame.NumMoves = 0;
+	Frame.NextMove = 0;
+}
+
+bool FColourWarsSearch::ExpandFrame()
+{
+	FFrame& Frame = Frames[StackDepth - 1];
+
+	if (Frame.Depth <= 0 || Board.IsGameOver() || !Board.HasBlocks(RootPlayer))
+	{
+		float Value = Eval.Evaluate(Board, RootPlayer);
+
+		// Prefer the quickest win and the slowest loss
+		if (Value >= FColourWarsEval::WinScore)
+		{
+			Value -= Frame.Ply;
+		}
+		else if (Value <= -FColourWarsEval::WinScore)
+		{
+			Value += Frame.Ply;
+		}
+
+		ReturnValue(Value);
+		return false;
+	}
+
+	Frame.Key = FColourWarsSymmetry::Canonicalise(Board, Frame.Symmetry, RootPlayer);
+	const FColourWarsSearchEntry* Entry = Table.Find(Frame.Key);
+
+	// The root always searches its moves, the stored entry only orders them
+	if (Entry != nullptr && StackDepth > 1 && Entry->Depth >= Frame.Depth)
+	{
+		const float Value = FromTableValue(Entry->Value, Frame.Ply);
+		if (Entry->Bound == EColourWarsSearchBound::Exact
+			|| (Entry->Bound == EColourWarsSearchBound::Lower && Value >= Frame.Beta)
+			|| (Entry->Bound == EColourWarsSearchBound::Upper && Value <= Frame.Alpha))
+		{
+			ReturnValue(Value);
+			return false;
+		}
+	}
+
+	Board.GetLegalMoves(Moves);
+	Frame.NumMoves = Moves.Num() - Frame.FirstMove;
+	Frame.bExpanded = true;
+	Frame.bMaximising = Board.GetCurrentPlayer() == RootPlayer;
+	Frame.BestValue = Frame.bMaximising ? -TNumericLimits<float>::Max() : TNumericLimits<float>::Max();
+
+	OrderMoves(Frame, Entry);
+	Frame.BestMove = Moves[Frame.FirstMove];
+
+	return true;
+}
+
+void FColourWarsSearch::ReturnValue(float Value)
+{
+	Moves.SetNum(Frames[StackDepth - 1].FirstMove, false);
+	StackDepth--;
+
+	if (StackDepth == 0)
+	{
+		// An iteration finished, its best move is at least as good as the last one's
+		BestMove = Frames[0].BestMove;
+		BestScore = Value;
+		CompletedDepth = IterationDepth;
+
+		if (FMath::Abs(Value) >= DecidedScore)
+		{
+			bFinished = true;
+		}
+		return;
+	}
+
+	FFrame& Parent = Frames[StackDepth - 1];
+	Board.UndoTurn(Parent.Delta);
+
+	if (Parent.bMaximising)
+	{
+		if (Value > Parent.BestValue)
+		{
+			Parent.BestValue = Value;
+			Parent.BestMove = Parent.Delta.Move;
+		}
+		Parent.Alpha = FMath::Max(Parent.Alpha, Value);
+	}
+	else
+	{
+		if (Value < Parent.BestValue)
+		{
+			Parent.BestValue = Value;
+			Parent.BestMove = Parent.Delta.Move;
+		}
+		Parent.Beta = FMath::Min(Parent.Beta, Value);
+	}
+}
+
+void FColourWarsSearch::OrderMoves(FFrame& Frame, const FColourWarsSearchEntry* Entry)
+{
+	const eBlockType Player = Board.GetCurrentPlayer();
+
+	auto Priority = [this, Player](const FColourWarsMove& Move)
+	{
+		switch (Move.MoveType)
+		{
+			case eMoveType::Move:
+			{
+				const eBlockType Target = Board.GetBlockType(Board.ToIndex(Move.To));
+				return Target == eBlockType::None ? 2 : Target == Player ? 3 : 0;
+			}
+			case eMoveType::Combine:
+				return 1;
+			default:
+				return 4;
+		}
+	};
+
+	FColourWarsMove* FrameMoves = Moves.GetData() + Frame.FirstMove;
+	Sort(FrameMoves, Frame.NumMoves, [&Priority](const FColourWarsMove& A, const FColourWarsMove& B)
+	{
+		return Priority(A) < Priority(B);
+	});
+
+	if (Entry != nullptr && Entry->MoveType != eMoveType::Invalid)
+	{
+		const FColourWarsMove StoredMove = Frame.Symmetry.Invert(FColourWarsMove(Entry->MoveType, Board.ToCoord(Entry->MoveFrom), Board.ToCoord(Entry->MoveTo)), Board.GetSize());
+		for (int32 Index = 0; Index < Frame.NumMoves; Index++)
+		{
+			if (FrameMoves[Index] == StoredMove)
+			{
+				Swap(FrameMoves[0], FrameMoves[Index]);
+				break;
+			}
+		}
+	}
+}
@@ -0,0 +1,174 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColourWarsBoard.h"
+#include "ColourWarsEval.h"
+#include "ColourWarsSymmetry.h"
+
+/** How a stored value bounds the true value of a position */
+enum class EColourWarsSearchBound : uint8
+{
+	None,
+	Exact,
+
+	/** The true value is at least the stored one */
+	Lower,
+
+	/** The true value is at most the stored one */
+	Upper,
+};
+
+/** A searched position, keyed by the canonical hash of the board so each symmetric form is stored once */
+struct FColourWarsSearchEntry
+{
+	uint64 Key;
+	float Value;
+	int16 Depth;
+	EColourWarsSearchBound Bound;
+
+	/** Best move found, with cell indices in the canonical form of the position */
+	eMoveType MoveType;
+	int32 MoveFrom;
+	int32 MoveTo;
+};
+
+/** Fixed size table of searched positions, newer entries replace older ones in the same slot */
+class COLOURWARS_API FColourWarsTranspositionTable
+{
+public:
+	explicit FColourWarsTranspositionTable(int32 SizeLog2 = 16);
+
+	void Clear();
+
+	/** Entry for a key, or nullptr if it is not in the table */
+	const FColourWarsSearchEntry* Find(uint64 Key) const;
+
+	void Store(const FColourWarsSearchEntry& Entry);
+
+private:
+	TArray<FColourWarsSearchEntry> Entries;
+
+	uint64 Mask;
+};
+
+/**
+ * Iterative deepening alpha-beta search over FColourWarsBoard, scored by FColourWarsEval.
+ *
+ * With more than two players the search is paranoid: every opponent is assumed to play against the searching
+ * player. The search keeps its own stack of frames instead of recursing, so it can be stepped a few nodes at a time
+ * and carry on later, e.g. over several frames, and always has the best move of the deepest finished iteration.
+ * A position in a mounted opening book is answered with the book move straight away. Tablebases are not probed, they
+ * are solved for a game with capped scores and the search plays the real one.
+ */
+class COLOURWARS_API FColourWarsSearch
+{
+public:
+	/** Deepest iteration a search can reach */
+	static const int32 MaxPly = 64;
+
+	explicit FColourWarsSearch(const FColourWarsEvalWeights& Weights = FColourWarsEvalWeights::GetDefault(), int32 TableSizeLog2 = 16);
+
+	/** Start searching a copy of the board for its current player */
+	void Start(const FColourWarsBoard& InBoard, int32 InMaxDepth = MaxPly);
+
+	/** Search up to NumNodes more positions, returns true once the search is finished */
+	bool Step(int32 NumNodes);
+
+	/** Search until the time is up or MaxDepth has been searched, and return the best move */
+	FColourWarsMove Search(const FColourWarsBoard& InBoard, double Seconds, int32 InMaxDepth = MaxPly);
+
+	/** Has MaxDepth been searched, or the result been decided */
+	bool IsFinished() const { return bFinished; }
+
+	/** Best move of the deepest finished iteration, the first legal move before one has finished and a pass if the game is over */
+	FColourWarsMove GetBestMove() const { return BestMove; }
+
+	/** Score of the best move of the deepest finished iteration, for the player searching */
+	float GetBestScore() const { return BestScore; }
+
+	/** Depth of the deepest finished iteration */
+	int32 GetCompletedDepth() const { return CompletedDepth; }
+
+	/** Positions visited since Start */
+	int64 GetNumNodes() const { return NumNodes; }
+
+	eBlockType GetPlayer() const { return RootPlayer; }
+
+	/** Forget every searched position, e.g. before a new game */
+	void ClearTable() { Table.Clear(); }
+
+private:
+	/** A position on the search stack */
+	struct FFrame
+	{
+		int32 Depth;
+		int32 Ply;
+		float Alpha;
+		float Beta;
+
+		/** Window the frame was searched with, to tell what bound its value is */
+		float StartAlpha;
+		float StartBeta;
+
+		float BestValue;
+		FColourWarsMove BestMove;
+		bool bMaximising;
+		bool bExpanded;
+
+		/** Canonical hash of the position and the symmetry that takes it to the canonical form */
+		uint64 Key;
+		FColourWarsSymmetry Symmetry;
+
+		/** Moves of this position in the Moves stack */
+		int32 FirstMove;
+		int32 NumMoves;
+		int32 NextMove;
+
+		/** The move being searched from this position, to undo it once the child returns */
+		FColourWarsTurnDelta Delta;
+	};
+
+	void PushFrame(int32 Depth, int32 Ply, float Alpha, float Beta);
+
+	/** Expand the frame on top of the stack, returns false if it is a leaf whose value was returned */
+	bool ExpandFrame();
+
+	/** Pop the frame on top of the stack and pass its value to its parent */
+	void ReturnValue(float Value);
+
+	/** Order a frame's moves: the stored best move, then captures, combines, moves and adding one */
+	void OrderMoves(FFrame& Frame, const FColourWarsSearchEntry* Entry);
+
+	FColourWarsEval Eval;
+
+	FColourWarsTranspositionTable Table;
+
+	FColourWarsBoard Board;
+
+	eBlockType RootPlayer;
+
+	int32 MaxDepth;
+
+	/** Depth of the iteration being searched */
+	int32 IterationDepth;
+
+	int32 CompletedDepth;
+
+	FColourWarsMove BestMove;
+
+	float BestScore;
+
+	bool bFinished;
+
+	int64 NumNodes;
+
+	TArray<FFrame> Frames;
+
+	/** Frames in use */
+	int32 StackDepth;
+
+	/** Legal moves of every frame on the stack */
+	TArray<FColourWarsMove> Moves;
+};
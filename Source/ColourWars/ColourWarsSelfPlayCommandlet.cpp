@@ -0,0 +1,169 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsSelfPlayCommandlet.h"
+#include "ColourWarsBatch.h"
+#include "ColourWarsTrainingData.h"
+#include "Async/ParallelFor.h"
+#include "Math/RandomStream.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogColourWarsSelfPlay, Log, All);
+
+namespace
+{
+	struct FSelfPlayTotals
+	{
+		int64 NumTurns = 0;
+
+		/** Games that ended with one player left, by the winner's eBlockType */
+		int64 Wins[5] = {};
+
+		/** Games stopped at the turn limit */
+		int64 NumUnfinished = 0;
+	};
+}
+
+UColourWarsSelfPlayCommandlet::UColourWarsSelfPlayCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UColourWarsSelfPlayCommandlet::Main(const FString& Params)
+{
+	int32 GamesPerBatch = 4096;
+	int32 NumBatches = FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+	int32 Size = 10;
+	int32 NumberOfPlayers = 2;
+	int32 MaxTurns = 500;
+	float Duration = 30.f;
+	int32 Seed = 1;
+	FString ExportDir;
+	FParse::Value(*Params, TEXT("Games="), GamesPerBatch);
+	FParse::Value(*Params, TEXT("Batches="), NumBatches);
+	FParse::Value(*Params, TEXT("Size="), Size);
+	FParse::Value(*Params, TEXT("Players="), NumberOfPlayers);
+	FParse::Value(*Params, TEXT("MaxTurns="), MaxTurns);
+	FParse::Value(*Params, TEXT("Duration="), Duration);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("Export="), ExportDir);
+
+	if (Size < 2 || Size > FColourWarsBoard::MaxSize || NumberOfPlayers < 2 || NumberOfPlayers > 4 || GamesPerBatch < 1 || NumBatches < 1)
+	{
+		UE_LOG(LogColourWarsSelfPlay, Error, TEXT("Need a size of 2 to %d, 2 to 4 players and at least one game and batch."), FColourWarsBoard::MaxSize);
+		return 1;
+	}
+
+	UE_LOG(LogColourWarsSelfPlay, Display, TEXT("Playing %d batches of %d %dx%d games for %d players for %.0f seconds."),
+		NumBatches, GamesPerBatch, Size, Size, NumberOfPlayers, Duration);
+
+	TArray<FSelfPlayTotals> BatchTotals;
+	BatchTotals.SetNum(NumBatches);
+
+	const double StartTime = FPlatformTime::Seconds();
+	ParallelFor(NumBatches, [&](int32 BatchIndex)
+	{
+		FSelfPlayTotals& Totals = BatchTotals[BatchIndex];
+		FRandomStream Random(Seed + BatchIndex);
+		FColourWarsBatch Batch;
+		Batch.Init(GamesPerBatch, Size, NumberOfPlayers);
+
+		FColourWarsTrainingDataWriter Writer;
+		if (!ExportDir.IsEmpty() && !Writer.Begin(ExportDir / FString::Printf(TEXT("SelfPlay_%d.cwdata"), BatchIndex), Size, NumberOfPlayers))
+		{
+			UE_LOG(LogColourWarsSelfPlay, Error, TEXT("Could not create a training data file in '%s'."), *ExportDir);
+		}
+
+		// Id of the game being played in each slot of the batch, ids are only unique within a file
+		TArray<int32> GameIds;
+		GameIds.SetNumUninitialized(GamesPerBatch);
+		for (int32 Game = 0; Game < GamesPerBatch; Game++)
+		{
+			GameIds[Game] = Game;
+		}
+		int32 NextGameId = GamesPerBatch;
+
+		TArray<int32> CellScores;
+		TArray<uint8> Cells;
+		CellScores.SetNumUninitialized(Size * Size);
+		Cells.SetNumUninitialized(Size * Size);
+
+		while (!IsEngineExitRequested() && FPlatformTime::Seconds() - StartTime < Duration)
+		{
+			// Check the time every few turns rather than every one
+			for (int32 Step = 0; Step < 16; Step++)
+			{
+				Batch.ChooseRandomMoves(Random);
+
+				for (int32 Game = 0; Writer.IsWriting() && Game < GamesPerBatch; Game++)
+				{
+					const FColourWarsMove Move = Batch.GetMove(Game);
+
+					FColourWarsTrainingPosition Position;
+					Position.GameId = GameIds[Game];
+					Position.Turn = Batch.GetTurn(Game);
+					Position.Player = Batch.GetCurrentPlayer(Game);
+					Position.NumLegalMoves = Batch.GetNumLegalMoves(Game);
+					Position.MoveType = Move.MoveType;
+					// The batch only sets the cells a move uses, the others are off the board
+					Position.From = Move.MoveType != eMoveType::Invalid ? Move.From.X * Size + Move.From.Y : 0;
+					Position.To = Move.MoveType == eMoveType::Move ? Move.To.X * Size + Move.To.Y : 0;
+
+					Batch.GetCells(Game, CellScores.GetData(), Cells.GetData());
+					Writer.AddPosition(Position, CellScores.GetData(), Cells.GetData());
+				}
+
+				Batch.Step();
+
+				for (int32 Game = 0; Game < GamesPerBatch; Game++)
+				{
+					if (Batch.IsGameOver(Game))
+					{
+						Totals.Wins[static_cast<int32>(Batch.GetCurrentPlayer(Game))]++;
+					}
+					else if (Batch.GetTurn(Game) >= MaxTurns)
+					{
+						Totals.NumUnfinished++;
+					}
+					else
+					{
+						continue;
+					}
+
+					Totals.NumTurns += Batch.GetTurn(Game);
+					Writer.AddResult(GameIds[Game], Batch.IsGameOver(Game) ? Batch.GetCurrentPlayer(Game) : eBlockType::None, Batch.GetTurn(Game));
+					GameIds[Game] = NextGameId++;
+					Batch.ResetGame(Game);
+				}
+			}
+		}
+	});
+	const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+	FSelfPlayTotals Totals;
+	for (const FSelfPlayTotals& Batch : BatchTotals)
+	{
+		Totals.NumTurns += Batch.NumTurns;
+		Totals.NumUnfinished += Batch.NumUnfinished;
+		for (int32 Player = 0; Player < UE_ARRAY_COUNT(Totals.Wins); Player++)
+		{
+			Totals.Wins[Player] += Batch.Wins[Player];
+		}
+	}
+
+	int64 NumGames = Totals.NumUnfinished;
+	FString Wins;
+	for (int32 Player = 1; Player <= NumberOfPlayers; Player++)
+	{
+		NumGames += Totals.Wins[Player];
+		Wins += FString::Printf(TEXT(" %lld"), Totals.Wins[Player]);
+	}
+
+	UE_LOG(LogColourWarsSelfPlay, Display, TEXT("%lld games in %.1f seconds, %.0f games/hour, %.0f turns/s."),
+		NumGames, Elapsed, NumGames / Elapsed * 3600.0, Totals.NumTurns / Elapsed);
+	UE_LOG(LogColourWarsSelfPlay, Display, TEXT("Wins by player:%s, %lld stopped at %d turns."), *Wins, Totals.NumUnfinished, MaxTurns);
+
+	return 0;
+}
@@ -0,0 +1,27 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ColourWarsSelfPlayCommandlet.generated.h"
+
+/**
+ * Plays random games as fast as it can with FColourWarsBatch, for playouts and throughput testing.
+ *
+ * Usage: ColourWars -run=ColourWarsSelfPlay [-Games=4096] [-Batches=<cores>] [-Size=10] [-Players=2] [-MaxTurns=500]
+ *        [-Duration=30] [-Seed=1] [-Export=<dir>]
+ * Games is per batch and each batch is stepped on its own thread. A finished game, or one that reaches MaxTurns
+ * without a winner, is replaced by a new one. With -Export every position, its legal move count, the move played
+ * and each game's result are written to a training data file per batch in the directory.
+ */
+UCLASS()
+class UColourWarsSelfPlayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UColourWarsSelfPlayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
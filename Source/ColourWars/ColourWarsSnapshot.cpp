@@ -0,0 +1,75 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsSnapshot.h"
+#include "Kismet/GameplayStatics.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+const TCHAR* FColourWarsSnapshot::SlotName = TEXT("ColourWarsMatch");
+
+FColourWarsSnapshot::FColourWarsSnapshot()
+	: Seed(0)
+	, SelectedMove(eMoveType::Move)
+{
+}
+
+void FColourWarsSnapshot::Serialize(FArchive& Ar)
+{
+	uint32 SnapshotMagic = Magic;
+	uint16 SnapshotVersion = Version;
+	Ar << SnapshotMagic;
+	Ar << SnapshotVersion;
+
+	if (SnapshotMagic != Magic || SnapshotVersion > Version)
+	{
+		Ar.SetError();
+		return;
+	}
+
+	uint8 Move = static_cast<uint8>(SelectedMove);
+	Ar << Seed;
+	Ar << Move;
+
+	if (Ar.IsLoading() && Move > static_cast<uint8>(eMoveType::AddOne))
+	{
+		Ar.SetError();
+		return;
+	}
+
+	SelectedMove = static_cast<eMoveType>(Move);
+
+	Board.Serialize(Ar);
+}
+
+bool FColourWarsSnapshot::SaveToSlot()
+{
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+	Serialize(Writer);
+
+	return UGameplayStatics::SaveDataToSlot(Data, SlotName, 0);
+}
+
+bool FColourWarsSnapshot::LoadFromSlot()
+{
+	TArray<uint8> Data;
+	if (!UGameplayStatics::LoadDataFromSlot(Data, SlotName, 0))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Data);
+	Serialize(Reader);
+
+	return !Reader.IsError() && Board.GetNumCells() > 0;
+}
+
+bool FColourWarsSnapshot::DoesSlotExist()
+{
+	return UGameplayStatics::DoesSaveGameExist(SlotName, 0);
+}
+
+void FColourWarsSnapshot::DeleteSlot()
+{
+	UGameplayStatics::DeleteGameInSlot(SlotName, 0);
+}
@@ -0,0 +1,40 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColourWarsBoard.h"
+
+/**
+ * Everything needed to resume a match: the board, the turn flow and the selected move.
+ *
+ * Layout: uint32 magic, uint16 version, uint32 seed, uint8 selected eMoveType, then the FColourWarsBoard.
+ * Older versions are still read, newer ones are refused.
+ */
+struct COLOURWARS_API FColourWarsSnapshot
+{
+	static const uint32 Magic = 0x56535743;
+	static const uint16 Version = 1;
+
+	/** Save game slot the match in progress is kept in */
+	static const TCHAR* SlotName;
+
+	FColourWarsSnapshot();
+
+	uint32 Seed;
+
+	eMoveType SelectedMove;
+
+	FColourWarsBoard Board;
+
+	/** Read or write the snapshot, setting the archive's error flag if it is not a snapshot this build can read */
+	void Serialize(FArchive& Ar);
+
+	bool SaveToSlot();
+
+	bool LoadFromSlot();
+
+	static bool DoesSlotExist();
+
+	static void DeleteSlot();
+};
@@ -0,0 +1,160 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsSymmetry.h"
+
+namespace
+{
+	const int32 NumTransforms = 8;
+}
+
+/// <summary>
+/// Shift the colours so the player to move is Red, then hash the occupied cells at their place under all 8
+/// transforms in one pass and keep the smallest. Empty cells hash to 0, so a sparse board is quick to canonicalise.
+/// </summary>
+uint64 FColourWarsSymmetry::Canonicalise(const FColourWarsBoard& Board, FColourWarsSymmetry& OutSymmetry, eBlockType Player)
+{
+	const int32 Size = Board.GetSize();
+	const int32 NumberOfPlayers = Board.GetNumberOfPlayers();
+	const int32 CurrentPlayer = static_cast<int32>(Board.GetCurrentPlayer());
+
+	FColourWarsSymmetry Symmetry;
+	Symmetry.ColourShift = CurrentPlayer > 0 ? static_cast<uint8>((NumberOfPlayers - CurrentPlayer + 1) % NumberOfPlayers) : 0;
+
+	uint64 Hashes[NumTransforms] = {};
+	for (int32 Index = 0; Index < Board.GetNumCells(); Index++)
+	{
+		const eBlockType BlockType = Board.GetBlockType(Index);
+		const int32 Score = Board.GetScore(Index);
+		const uint8 bIsCapital = Board.IsCapitalBlock(Index) ? 1 : 0;
+		if (BlockType == eBlockType::None && Score == 0 && bIsCapital == 0)
+		{
+			continue;
+		}
+
+		const uint8 Type = static_cast<uint8>(Symmetry.Apply(BlockType, NumberOfPlayers));
+		// Places are row-major whatever the board's layout, so a position has one canonical hash
+		const IntVector Coord = Board.ToCoord(Index);
+		const int32 X = Coord.X;
+		const int32 Y = Coord.Y;
+		const int32 FlippedX = Size - 1 - X;
+		const int32 FlippedY = Size - 1 - Y;
+
+		// Transform bits in order: transpose, flip X, flip Y
+		const int32 Places[NumTransforms] =
+		{
+			X * Size + Y,               Y * Size + X,
+			FlippedX * Size + Y,        FlippedY * Size + X,
+			X * Size + FlippedY,        Y * Size + FlippedX,
+			FlippedX * Size + FlippedY, FlippedY * Size + FlippedX
+		};
+
+		for (int32 Transform = 0; Transform < NumTransforms; Transform++)
+		{
+			Hashes[Transform] ^= FColourWarsBoard::HashCell(Places[Transform], Type, Score, bIsCapital);
+		}
+	}
+
+	int32 Best = 0;
+	for (int32 Transform = 1; Transform < NumTransforms; Transform++)
+	{
+		if (Hashes[Transform] < Hashes[Best])
+		{
+			Best = Transform;
+		}
+	}
+
+	Symmetry.Transform = static_cast<uint8>(Best);
+	OutSymmetry = Symmetry;
+
+	const uint64 Flow = ((uint64)NumberOfPlayers << 24)
+		| ((uint64)Symmetry.Apply(Player, NumberOfPlayers) << 16)
+		| ((uint64)Symmetry.Apply(Board.GetCurrentPlayer(), NumberOfPlayers) << 8)
+		| (Board.IsGameOver() ? 1 : 0);
+	return Hashes[Best] ^ FColourWarsBoard::Mix64(Flow);
+}
+
+IntVector FColourWarsSymmetry::Apply(IntVector Coord, int32 Size) const
+{
+	if (Transform & 1)
+	{
+		Swap(Coord.X, Coord.Y);
+	}
+	if (Transform & 2)
+	{
+		Coord.X = Size - 1 - Coord.X;
+	}
+	if (Transform & 4)
+	{
+		Coord.Y = Size - 1 - Coord.Y;
+	}
+	return Coord;
+}
+
+/// <summary>
+/// The flips undo themselves and do not depend on each other, so undoing a transform is the flips then the transpose
+/// </summary>
+IntVector FColourWarsSymmetry::Invert(IntVector Coord, int32 Size) const
+{
+	if (Transform & 2)
+	{
+		Coord.X = Size - 1 - Coord.X;
+	}
+	if (Transform & 4)
+	{
+		Coord.Y = Size - 1 - Coord.Y;
+	}
+	if (Transform & 1)
+	{
+		Swap(Coord.X, Coord.Y);
+	}
+	return Coord;
+}
+
+int32 FColourWarsSymmetry::ApplyToIndex(int32 Index, int32 Size) const
+{
+	const IntVector Coord = Apply(IntVector(Index / Size, Index % Size), Size);
+	return Coord.X * Size + Coord.Y;
+}
+
+eBlockType FColourWarsSymmetry::Apply(eBlockType BlockType, int32 NumberOfPlayers) const
+{
+	const int32 Type = static_cast<int32>(BlockType);
+	if (Type == 0 || Type > NumberOfPlayers)
+	{
+		return BlockType;
+	}
+	return static_cast<eBlockType>((Type - 1 + ColourShift) % NumberOfPlayers + 1);
+}
+
+eBlockType FColourWarsSymmetry::Invert(eBlockType BlockType, int32 NumberOfPlayers) const
+{
+	const int32 Type = static_cast<int32>(BlockType);
+	if (Type == 0 || Type > NumberOfPlayers)
+	{
+		return BlockType;
+	}
+	return static_cast<eBlockType>((Type - 1 + NumberOfPlayers - ColourShift % NumberOfPlayers) % NumberOfPlayers + 1);
+}
+
+FColourWarsMove FColourWarsSymmetry::Apply(const FColourWarsMove& Move, int32 Size) const
+{
+	return FColourWarsMove(Move.MoveType, Apply(Move.From, Size), Move.MoveType == eMoveType::Move ? Apply(Move.To, Size) : Move.To);
+}
+
+FColourWarsMove FColourWarsSymmetry::Invert(const FColourWarsMove& Move, int32 Size) const
+{
+	return FColourWarsMove(Move.MoveType, Invert(Move.From, Size), Move.MoveType == eMoveType::Move ? Invert(Move.To, Size) : Move.To);
+}
+
+void FColourWarsSymmetry::Apply(const FColourWarsBoard& Board, FColourWarsBoard& OutBoard) const
+{
+	const int32 Size = Board.GetSize();
+	const int32 NumberOfPlayers = Board.GetNumberOfPlayers();
+
+	OutBoard.Init(Size, NumberOfPlayers);
+	for (int32 Index = 0; Index < Board.GetNumCells(); Index++)
+	{
+		OutBoard.SetCell(OutBoard.ToIndex(Apply(Board.ToCoord(Index), Size)), Apply(Board.GetBlockType(Index), NumberOfPlayers), Board.GetScore(Index), Board.IsCapitalBlock(Index));
+	}
+	OutBoard.SetTurnFlow(Apply(Board.GetCurrentPlayer(), NumberOfPlayers), Board.GetTurn(), Board.IsGameOver());
+}
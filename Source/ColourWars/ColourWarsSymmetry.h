@@ -0,0 +1,41 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColourWarsBoard.h"
+
+/**
+ * One symmetry of a position: one of the 8 rotations and reflections of the square board, and a shift of every colour
+ * round the turn order. Each colour is also weak against the next one round, so the rules play a shifted position
+ * exactly as they play the original, and the capitals SetCapitalBlocks puts in the corners swap places with each other.
+ */
+struct COLOURWARS_API FColourWarsSymmetry
+{
+	/** Transpose if bit 0 is set, then flip X if bit 1 is set and flip Y if bit 2 is set */
+	uint8 Transform = 0;
+
+	/** Places each colour moves on round the turn order */
+	uint8 ColourShift = 0;
+
+	/**
+	 * Find the symmetry that takes a position to its canonical form, which has Red to move, and return the hash of that
+	 * form. Every symmetric form of a position has the same hash, and the hash also covers Player if one is given,
+	 * e.g. the player a search scores positions for. The turn count is left out, so transpositions match too.
+	 */
+	static uint64 Canonicalise(const FColourWarsBoard& Board, FColourWarsSymmetry& OutSymmetry, eBlockType Player = eBlockType::None);
+
+	IntVector Apply(IntVector Coord, int32 Size) const;
+	IntVector Invert(IntVector Coord, int32 Size) const;
+
+	int32 ApplyToIndex(int32 Index, int32 Size) const;
+
+	eBlockType Apply(eBlockType BlockType, int32 NumberOfPlayers) const;
+	eBlockType Invert(eBlockType BlockType, int32 NumberOfPlayers) const;
+
+	FColourWarsMove Apply(const FColourWarsMove& Move, int32 Size) const;
+	FColourWarsMove Invert(const FColourWarsMove& Move, int32 Size) const;
+
+	/** Set OutBoard to the transformed position laid out row by row, the turn count is kept */
+	void Apply(const FColourWarsBoard& Board, FColourWarsBoard& OutBoard) const;
+};
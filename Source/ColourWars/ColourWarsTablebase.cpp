@@ -0,0 +1,384 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsTablebase.h"
+#include "ColourWarsSymmetry.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogColourWarsTablebase, Log, All);
+
+TArray<TUniquePtr<FColourWarsTablebase>> FColourWarsTablebase::Mounted;
+
+FColourWarsTablebase::FColourWarsTablebase()
+	: Size(0)
+	, MaxScore(0)
+	, NumEntries(0)
+	, Cells(nullptr)
+	, Capitals(nullptr)
+	, Values(nullptr)
+{
+}
+
+FColourWarsTablebase::~FColourWarsTablebase()
+{
+	// The region has to go before the file it maps
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+/// <summary>
+/// Pack each cell into a nibble with the colours swapped if Green is to move, then pack the nibbles in the order of
+/// each symmetry of the board and keep the smallest. The rules of a two player game treat both colours and every
+/// direction the same, so all 16 forms of a position have the same value for the player to move.
+/// </summary>
+bool FColourWarsTablebase::MakeKey(const FColourWarsBoard& Board, int32 MaxScore, FColourWarsTablebaseKey& OutKey)
+{
+	const int32 Size = Board.GetSize();
+	if (Size > ColourWarsTablebase::MaxSize || Board.GetNumberOfPlayers() != 2 || MaxScore > ColourWarsTablebase::MaxScore)
+	{
+		return false;
+	}
+
+	// Swaps the colours if Green is to move
+	FColourWarsSymmetry Symmetry;
+	Symmetry.ColourShift = Board.GetCurrentPlayer() == eBlockType::Green ? 1 : 0;
+
+	uint8 Nibbles[ColourWarsTablebase::MaxSize * ColourWarsTablebase::MaxSize];
+	int32 CapitalIndices[2] = { ColourWarsTablebase::NoCapital, ColourWarsTablebase::NoCapital };
+
+	for (int32 Index = 0; Index < Board.GetNumCells(); Index++)
+	{
+		int32 Type = static_cast<int32>(Board.GetBlockType(Index));
+		const int32 Score = Board.GetScore(Index);
+
+		if (Type == 0)
+		{
+			if (Score != 0)
+			{
+				return false;
+			}
+			Nibbles[Index] = 0;
+			continue;
+		}
+
+		if (Type > 2 || Score < 1 || Score > MaxScore)
+		{
+			return false;
+		}
+
+		Type = static_cast<int32>(Symmetry.Apply(static_cast<eBlockType>(Type), 2));
+		Nibbles[Index] = static_cast<uint8>(Type | ((Score - 1) << 2));
+		if (Board.IsCapitalBlock(Index))
+		{
+			CapitalIndices[Type - 1] = Index;
+		}
+	}
+
+	bool bFirst = true;
+	for (int32 Transform = 0; Transform < 8; Transform++)
+	{
+		Symmetry.Transform = static_cast<uint8>(Transform);
+
+		FColourWarsTablebaseKey Key;
+		Key.Cells = 0;
+
+		for (int32 Index = 0; Index < Board.GetNumCells(); Index++)
+		{
+			Key.Cells |= (uint64)Nibbles[Index] << (4 * Symmetry.ApplyToIndex(Index, Size));
+		}
+
+		uint16 TransformedCapitals[2];
+		for (int32 Player = 0; Player < 2; Player++)
+		{
+			TransformedCapitals[Player] = ColourWarsTablebase::NoCapital;
+			if (CapitalIndices[Player] != ColourWarsTablebase::NoCapital)
+			{
+				TransformedCapitals[Player] = static_cast<uint16>(Symmetry.ApplyToIndex(CapitalIndices[Player], Size));
+			}
+		}
+		Key.Capitals = TransformedCapitals[0] | (TransformedCapitals[1] << 5);
+
+		if (bFirst || Key < OutKey)
+		{
+			OutKey = Key;
+			bFirst = false;
+		}
+	}
+
+	return true;
+}
+
+void FColourWarsTablebase::GetBoard(const FColourWarsTablebaseKey& Key, int32 Size, FColourWarsBoard& OutBoard)
+{
+	OutBoard.Init(Size, 2);
+
+	for (int32 Index = 0; Index < Size * Size; Index++)
+	{
+		const int32 Nibble = (Key.Cells >> (4 * Index)) & 0xF;
+		const int32 Type = Nibble & 3;
+		OutBoard.SetCell(Index, static_cast<eBlockType>(Type), Type != 0 ? (Nibble >> 2) + 1 : 0, false);
+	}
+
+	for (int32 Player = 0; Player < 2; Player++)
+	{
+		const int32 CapitalIndex = (Key.Capitals >> (5 * Player)) & 0x1F;
+		if (CapitalIndex != ColourWarsTablebase::NoCapital)
+		{
+			OutBoard.SetCell(CapitalIndex, OutBoard.GetBlockType(CapitalIndex), OutBoard.GetScore(CapitalIndex), true);
+		}
+	}
+
+	OutBoard.SetTurnFlow(eBlockType::Red, 0, false);
+}
+
+void FColourWarsTablebase::ApplyCappedTurn(FColourWarsBoard& Board, const FColourWarsMove& Move, int32 MaxScore)
+{
+	Board.ApplyTurn(Move);
+
+	for (int32 Index = 0; Index < Board.GetNumCells(); Index++)
+	{
+		if (Board.GetScore(Index) > MaxScore)
+		{
+			Board.SetScore(Index, MaxScore);
+		}
+	}
+}
+
+bool FColourWarsTablebase::Write(const FString& Filename, int32 Size, int32 MaxScore, const TArray<FColourWarsTablebaseKey>& Keys, const TArray<uint8>& InValues)
+{
+	TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Ar.IsValid())
+	{
+		return false;
+	}
+
+	uint32 Magic = ColourWarsTablebase::FileMagic;
+	uint16 Version = ColourWarsTablebase::Version;
+	uint8 PackedSize = Size;
+	uint8 PackedMaxScore = MaxScore;
+	int64 Count = Keys.Num();
+	*Ar << Magic;
+	*Ar << Version;
+	*Ar << PackedSize;
+	*Ar << PackedMaxScore;
+	*Ar << Count;
+
+	TArray<uint64> CellsColumn;
+	TArray<uint16> CapitalsColumn;
+	CellsColumn.Reserve(Keys.Num());
+	CapitalsColumn.Reserve(Keys.Num());
+	for (const FColourWarsTablebaseKey& Key : Keys)
+	{
+		CellsColumn.Add(Key.Cells);
+		CapitalsColumn.Add(Key.Capitals);
+	}
+
+	Ar->Serialize(CellsColumn.GetData(), CellsColumn.Num() * sizeof(uint64));
+	Ar->Serialize(CapitalsColumn.GetData(), CapitalsColumn.Num() * sizeof(uint16));
+	Ar->Serialize(const_cast<uint8*>(InValues.GetData()), InValues.Num());
+
+	return Ar->Close();
+}
+
+bool FColourWarsTablebase::Open(const FString& Filename)
+{
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	LoadedFile.Empty();
+	NumEntries = 0;
+
+	const uint8* Data = nullptr;
+	int64 DataSize = 0;
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (MappedFile.IsValid() && MappedFile->GetFileSize() > 0)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion());
+	}
+
+	if (MappedRegion.IsValid())
+	{
+		Data = MappedRegion->GetMappedPtr();
+		DataSize = MappedRegion->GetMappedSize();
+	}
+	else if (FFileHelper::LoadFileToArray(LoadedFile, *Filename))
+	{
+		Data = LoadedFile.GetData();
+		DataSize = LoadedFile.Num();
+	}
+	else
+	{
+		return false;
+	}
+
+	if (DataSize < ColourWarsTablebase::HeaderSize)
+	{
+		return false;
+	}
+
+	uint32 Magic;
+	uint16 Version;
+	int64 Count;
+	FMemory::Memcpy(&Magic, Data, sizeof(Magic));
+	FMemory::Memcpy(&Version, Data + 4, sizeof(Version));
+	FMemory::Memcpy(&Count, Data + 8, sizeof(Count));
+
+	const int64 EntryBytes = sizeof(uint64) + sizeof(uint16) + sizeof(uint8);
+	if (Magic != ColourWarsTablebase::FileMagic || Version > ColourWarsTablebase::Version || Data[6] > ColourWarsTablebase::MaxSize
+		|| Data[7] > ColourWarsTablebase::MaxScore || Count < 0 || ColourWarsTablebase::HeaderSize + Count * EntryBytes > DataSize)
+	{
+		return false;
+	}
+
+	Size = Data[6];
+	MaxScore = Data[7];
+	NumEntries = Count;
+	Cells = reinterpret_cast<const uint64*>(Data + ColourWarsTablebase::HeaderSize);
+	Capitals = reinterpret_cast<const uint16*>(Cells + NumEntries);
+	Values = reinterpret_cast<const uint8*>(Capitals + NumEntries);
+
+	return true;
+}
+
+uint8 FColourWarsTablebase::FindValue(const FColourWarsTablebaseKey& Key) const
+{
+	// First entry with cells not below the key's, the few entries that share them differ only in capitals
+	int64 Low = 0;
+	int64 High = NumEntries;
+	while (Low < High)
+	{
+		const int64 Middle = Low + (High - Low) / 2;
+		if (Cells[Middle] < Key.Cells)
+		{
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle;
+		}
+	}
+
+	for (int64 Entry = Low; Entry < NumEntries && Cells[Entry] == Key.Cells; Entry++)
+	{
+		if (Capitals[Entry] == Key.Capitals)
+		{
+			return Values[Entry];
+		}
+	}
+
+	return 0;
+}
+
+bool FColourWarsTablebase::Probe(const FColourWarsBoard& Board, FColourWarsTablebaseResult& OutResult) const
+{
+	if (Board.GetSize() != Size || Board.GetNumberOfPlayers() != 2)
+	{
+		return false;
+	}
+
+	if (Board.IsGameOver())
+	{
+		// The player left is the one to move
+		OutResult.bWin = true;
+		OutResult.Distance = 0;
+		return true;
+	}
+
+	FColourWarsTablebaseKey Key;
+	if (!MakeKey(Board, MaxScore, Key))
+	{
+		return false;
+	}
+
+	const uint8 Value = FindValue(Key);
+	if (Value == 0)
+	{
+		return false;
+	}
+
+	OutResult.bWin = (Value & ColourWarsTablebase::WinFlag) != 0;
+	OutResult.Distance = Value & ColourWarsTablebase::MaxDistance;
+	return true;
+}
+
+/// <summary>
+/// Look up the position after each legal move, which is from the opponent's side: a move to a position the
+/// opponent loses wins, and one to a position that is not in the table draws
+/// </summary>
+bool FColourWarsTablebase::GetBestMove(const FColourWarsBoard& Board, FColourWarsMove& OutMove) const
+{
+	FColourWarsTablebaseKey Key;
+	if (Board.GetSize() != Size || Board.IsGameOver() || !MakeKey(Board, MaxScore, Key))
+	{
+		return false;
+	}
+
+	TArray<FColourWarsMove> Moves;
+	Board.GetLegalMoves(Moves);
+
+	// Lower is better: wins by distance, then draws, then losses by how long they hold out
+	int32 BestRank = MAX_int32;
+	for (const FColourWarsMove& Move : Moves)
+	{
+		FColourWarsBoard Next = Board;
+		ApplyCappedTurn(Next, Move, MaxScore);
+
+		FColourWarsTablebaseResult Result;
+		int32 Rank;
+		if (!Probe(Next, Result))
+		{
+			Rank = 2 * ColourWarsTablebase::MaxDistance + 2;
+		}
+		else if (Next.IsGameOver() || !Result.bWin)
+		{
+			Rank = Result.Distance;
+		}
+		else
+		{
+			Rank = 4 * ColourWarsTablebase::MaxDistance - Result.Distance;
+		}
+
+		if (Rank < BestRank)
+		{
+			BestRank = Rank;
+			OutMove = Move;
+		}
+	}
+
+	return BestRank != MAX_int32;
+}
+
+void FColourWarsTablebase::MountAll(const FString& Directory)
+{
+	TArray<FString> Filenames;
+	IFileManager::Get().FindFiles(Filenames, *(Directory / TEXT("*.cwtb")), true, false);
+
+	for (const FString& Filename : Filenames)
+	{
+		TUniquePtr<FColourWarsTablebase> Table = MakeUnique<FColourWarsTablebase>();
+		if (!Table->Open(Directory / Filename))
+		{
+			UE_LOG(LogColourWarsTablebase, Warning, TEXT("Could not open the tablebase '%s'."), *Filename);
+			continue;
+		}
+
+		UE_LOG(LogColourWarsTablebase, Log, TEXT("Mounted '%s': %dx%d, scores up to %d, %lld positions."),
+			*Filename, Table->GetSize(), Table->GetSize(), Table->GetMaxScore(), Table->GetNumEntries());
+		Mounted.Add(MoveTemp(Table));
+	}
+}
+
+const FColourWarsTablebase* FColourWarsTablebase::Find(int32 Size)
+{
+	for (const TUniquePtr<FColourWarsTablebase>& Table : Mounted)
+	{
+		if (Table->GetSize() == Size)
+		{
+			return Table.Get();
+		}
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,122 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColourWarsBoard.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Tablebases hold the won and lost positions of small two player boards, solved for a capped game where every score
+ * above MaxScore is cut back to it at the end of each turn. Positions that are not in the table are draws.
+ *
+ * Header: uint32 magic, uint16 version, uint8 size, uint8 max score, int64 entry count
+ * Then three columns sorted by key: uint64 cells, uint16 capitals, uint8 value. The value is the number of turns
+ * until the game ends with best play, with WinFlag set if the player to move wins.
+ */
+namespace ColourWarsTablebase
+{
+	const uint32 FileMagic = 0x42545743;
+	const uint16 Version = 1;
+	const int32 HeaderSize = 16;
+
+	/** Every cell of a key fits in 4 bits, so boards of up to 16 cells with scores of up to 4 */
+	const int32 MaxSize = 4;
+	const int32 MaxScore = 4;
+
+	/** Capital index of a player without one */
+	const uint16 NoCapital = 31;
+
+	const uint8 WinFlag = 0x80;
+	const int32 MaxDistance = 0x7F;
+}
+
+/**
+ * A two player position packed for the tablebase. Colours are swapped when Green is to move, so the player to move is
+ * always Red, and of the 8 rotations and reflections of the board the one with the smallest key is used.
+ */
+struct COLOURWARS_API FColourWarsTablebaseKey
+{
+	/** 4 bits per cell in index order: the eBlockType in the low 2 bits and the score less one in the high 2 */
+	uint64 Cells;
+
+	/** Index of Red's capital in the low 5 bits and Green's in the next 5, NoCapital for a player without one */
+	uint16 Capitals;
+
+	bool operator==(const FColourWarsTablebaseKey& Other) const { return Cells == Other.Cells && Capitals == Other.Capitals; }
+	bool operator<(const FColourWarsTablebaseKey& Other) const { return Cells < Other.Cells || (Cells == Other.Cells && Capitals < Other.Capitals); }
+};
+
+/** Value of a won or lost position for the player to move */
+struct FColourWarsTablebaseResult
+{
+	bool bWin = false;
+
+	/** Turns until the game ends with best play */
+	int32 Distance = 0;
+};
+
+/** A tablebase file, memory mapped so looking up a position reads only the pages it touches */
+class COLOURWARS_API FColourWarsTablebase
+{
+public:
+	FColourWarsTablebase();
+	~FColourWarsTablebase();
+
+	/** Pack a position, false if it is not a two player board the size of a key with scores of 1 to MaxScore */
+	static bool MakeKey(const FColourWarsBoard& Board, int32 MaxScore, FColourWarsTablebaseKey& OutKey);
+
+	/** Set a board to the position of a key, with Red to move */
+	static void GetBoard(const FColourWarsTablebaseKey& Key, int32 Size, FColourWarsBoard& OutBoard);
+
+	/** Play a turn of the capped game */
+	static void ApplyCappedTurn(FColourWarsBoard& Board, const FColourWarsMove& Move, int32 MaxScore);
+
+	/** Write a table of keys sorted in ascending order and their values */
+	static bool Write(const FString& Filename, int32 Size, int32 MaxScore, const TArray<FColourWarsTablebaseKey>& Keys, const TArray<uint8>& Values);
+
+	bool Open(const FString& Filename);
+
+	int32 GetSize() const { return Size; }
+
+	int32 GetMaxScore() const { return MaxScore; }
+
+	int64 GetNumEntries() const { return NumEntries; }
+
+	/** Look up a position, false if it is a draw or the table does not hold positions like it */
+	bool Probe(const FColourWarsBoard& Board, FColourWarsTablebaseResult& OutResult) const;
+
+	/** Quickest win, slowest loss or a move that keeps the draw, false if the table does not hold positions like this */
+	bool GetBestMove(const FColourWarsBoard& Board, FColourWarsMove& OutMove) const;
+
+	/** Map every table in a directory */
+	static void MountAll(const FString& Directory);
+
+	/** The mounted table for a board size, or nullptr if there is none */
+	static const FColourWarsTablebase* Find(int32 Size);
+
+private:
+	/** Find a key's value in the table, 0 if it is not there */
+	uint8 FindValue(const FColourWarsTablebaseKey& Key) const;
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	/** The whole file, when it could not be mapped */
+	TArray<uint8> LoadedFile;
+
+	int32 Size;
+
+	int32 MaxScore;
+
+	int64 NumEntries;
+
+	/** Columns in the file */
+	const uint64* Cells;
+	const uint16* Capitals;
+	const uint8* Values;
+
+	static TArray<TUniquePtr<FColourWarsTablebase>> Mounted;
+};
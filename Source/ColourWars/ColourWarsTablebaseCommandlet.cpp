@@ -0,0 +1,279 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsTablebaseCommandlet.h"
+#include "ColourWarsTablebase.h"
+#include "Algo/BinarySearch.h"
+#include "Async/ParallelFor.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogColourWarsTablebaseGen, Log, All);
+
+namespace
+{
+	/** Sort keys and drop the repeats */
+	void SortUnique(TArray<FColourWarsTablebaseKey>& Keys)
+	{
+		Keys.Sort();
+
+		int32 NumUnique = 0;
+		for (int32 Index = 0; Index < Keys.Num(); Index++)
+		{
+			if (NumUnique == 0 || !(Keys[Index] == Keys[NumUnique - 1]))
+			{
+				Keys[NumUnique++] = Keys[Index];
+			}
+		}
+		Keys.SetNum(NumUnique, false);
+	}
+
+	/** Split NumItems into one range per task and call Func(Begin, End, Task) on worker threads */
+	template<typename FuncType>
+	void ParallelForRanges(int32 NumItems, int32 NumTasks, FuncType Func)
+	{
+		ParallelFor(NumTasks, [NumItems, NumTasks, &Func](int32 Task)
+		{
+			const int32 Begin = (int64)NumItems * Task / NumTasks;
+			const int32 End = (int64)NumItems * (Task + 1) / NumTasks;
+			Func(Begin, End, Task);
+		});
+	}
+
+	/**
+	 * Every position that can be reached from the start of a game and is not over, a turn at a time: the positions
+	 * after each move of the positions found last turn are made on worker threads, then sorted and merged into
+	 * the ones already found, which stay sorted so the values pass can find them by binary search.
+	 */
+	void FindPositions(int32 Size, int32 MaxScore, int32 NumTasks, TArray<FColourWarsTablebaseKey>& OutPositions)
+	{
+		FColourWarsBoard Start;
+		Start.Init(Size, 2);
+
+		FColourWarsTablebaseKey StartKey;
+		FColourWarsTablebase::MakeKey(Start, MaxScore, StartKey);
+
+		OutPositions.Reset();
+		OutPositions.Add(StartKey);
+
+		TArray<FColourWarsTablebaseKey> Frontier = OutPositions;
+		TArray<TArray<FColourWarsTablebaseKey>> TaskPositions;
+		TaskPositions.SetNum(NumTasks);
+
+		for (int32 Turn = 1; Frontier.Num() > 0; Turn++)
+		{
+			ParallelForRanges(Frontier.Num(), NumTasks, [&](int32 Begin, int32 End, int32 Task)
+			{
+				TArray<FColourWarsTablebaseKey>& Positions = TaskPositions[Task];
+				Positions.Reset();
+
+				FColourWarsBoard Board;
+				TArray<FColourWarsMove> Moves;
+				for (int32 Index = Begin; Index < End; Index++)
+				{
+					FColourWarsTablebase::GetBoard(Frontier[Index], Size, Board);
+					Moves.Reset();
+					Board.GetLegalMoves(Moves);
+
+					for (const FColourWarsMove& Move : Moves)
+					{
+						FColourWarsBoard Next = Board;
+						FColourWarsTablebase::ApplyCappedTurn(Next, Move, MaxScore);
+
+						FColourWarsTablebaseKey Key;
+						if (!Next.IsGameOver() && FColourWarsTablebase::MakeKey(Next, MaxScore, Key))
+						{
+							Positions.Add(Key);
+						}
+					}
+				}
+
+				SortUnique(Positions);
+			});
+
+			TArray<FColourWarsTablebaseKey> Found;
+			for (const TArray<FColourWarsTablebaseKey>& Positions : TaskPositions)
+			{
+				Found.Append(Positions);
+			}
+			SortUnique(Found);
+
+			// Merge the two sorted lists, keeping the new positions as the next frontier
+			TArray<FColourWarsTablebaseKey> Merged;
+			Merged.Reserve(OutPositions.Num() + Found.Num());
+			Frontier.Reset();
+
+			int32 Old = 0;
+			for (const FColourWarsTablebaseKey& Key : Found)
+			{
+				while (Old < OutPositions.Num() && OutPositions[Old] < Key)
+				{
+					Merged.Add(OutPositions[Old++]);
+				}
+
+				if (Old < OutPositions.Num() && OutPositions[Old] == Key)
+				{
+					continue;
+				}
+
+				Merged.Add(Key);
+				Frontier.Add(Key);
+			}
+			Merged.Append(OutPositions.GetData() + Old, OutPositions.Num() - Old);
+			OutPositions = MoveTemp(Merged);
+
+			UE_LOG(LogColourWarsTablebaseGen, Display, TEXT("Turn %d: %d new positions, %d in all."), Turn, Frontier.Num(), OutPositions.Num());
+		}
+	}
+
+	/**
+	 * Solve the positions a turn at a time from the end of the game. Each pass reads only the values found by
+	 * earlier passes, so a position solved on pass N is won or lost in exactly N turns: it is won if some move
+	 * wins at once or leaves the opponent lost, and lost once every move leaves the opponent won. Whatever is left
+	 * when a pass solves nothing is drawn.
+	 */
+	int32 SolvePositions(int32 Size, int32 MaxScore, int32 NumTasks, const TArray<FColourWarsTablebaseKey>& Positions, TArray<uint8>& OutValues)
+	{
+		OutValues.SetNumZeroed(Positions.Num());
+
+		TArray<int32> Unsolved;
+		Unsolved.SetNumUninitialized(Positions.Num());
+		for (int32 Index = 0; Index < Positions.Num(); Index++)
+		{
+			Unsolved[Index] = Index;
+		}
+
+		TArray<uint8> PassValues;
+		int32 Pass = 1;
+		for (; Unsolved.Num() > 0; Pass++)
+		{
+			PassValues.SetNumZeroed(Unsolved.Num());
+			const uint8 Distance = static_cast<uint8>(FMath::Min(Pass, ColourWarsTablebase::MaxDistance));
+
+			ParallelForRanges(Unsolved.Num(), NumTasks, [&](int32 Begin, int32 End, int32 Task)
+			{
+				FColourWarsBoard Board;
+				TArray<FColourWarsMove> Moves;
+				for (int32 Index = Begin; Index < End; Index++)
+				{
+					FColourWarsTablebase::GetBoard(Positions[Unsolved[Index]], Size, Board);
+					Moves.Reset();
+					Board.GetLegalMoves(Moves);
+
+					bool bWin = false;
+					bool bAllLost = true;
+					for (const FColourWarsMove& Move : Moves)
+					{
+						FColourWarsBoard Next = Board;
+						FColourWarsTablebase::ApplyCappedTurn(Next, Move, MaxScore);
+
+						if (Next.IsGameOver())
+						{
+							bWin = true;
+							break;
+						}
+
+						FColourWarsTablebaseKey Key;
+						FColourWarsTablebase::MakeKey(Next, MaxScore, Key);
+						const int32 NextIndex = Algo::BinarySearch(Positions, Key);
+						const uint8 NextValue = NextIndex != INDEX_NONE ? OutValues[NextIndex] : 0;
+
+						if (NextValue == 0)
+						{
+							bAllLost = false;
+						}
+						else if ((NextValue & ColourWarsTablebase::WinFlag) == 0)
+						{
+							bWin = true;
+							break;
+						}
+					}
+
+					PassValues[Index] = bWin ? (ColourWarsTablebase::WinFlag | Distance) : bAllLost ? Distance : 0;
+				}
+			});
+
+			int32 NumStillUnsolved = 0;
+			for (int32 Index = 0; Index < Unsolved.Num(); Index++)
+			{
+				if (PassValues[Index] != 0)
+				{
+					OutValues[Unsolved[Index]] = PassValues[Index];
+				}
+				else
+				{
+					Unsolved[NumStillUnsolved++] = Unsolved[Index];
+				}
+			}
+
+			const int32 NumSolved = Unsolved.Num() - NumStillUnsolved;
+			Unsolved.SetNum(NumStillUnsolved, false);
+
+			UE_LOG(LogColourWarsTablebaseGen, Display, TEXT("Pass %d: solved %d positions, %d left."), Pass, NumSolved, Unsolved.Num());
+			if (NumSolved == 0)
+			{
+				break;
+			}
+		}
+
+		return Pass;
+	}
+}
+
+UColourWarsTablebaseCommandlet::UColourWarsTablebaseCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UColourWarsTablebaseCommandlet::Main(const FString& Params)
+{
+	int32 Size = 3;
+	int32 MaxScore = 2;
+	FParse::Value(*Params, TEXT("Size="), Size);
+	FParse::Value(*Params, TEXT("MaxScore="), MaxScore);
+
+	FString Output = FPaths::ProjectContentDir() / TEXT("Tablebases") / FString::Printf(TEXT("ColourWars_%dx%d.cwtb"), Size, Size);
+	FParse::Value(*Params, TEXT("Output="), Output);
+
+	if (Size < 2 || Size > ColourWarsTablebase::MaxSize || MaxScore < 2 || MaxScore > ColourWarsTablebase::MaxScore)
+	{
+		UE_LOG(LogColourWarsTablebaseGen, Error, TEXT("Need a size of 2 to %d and a max score of 2 to %d."), ColourWarsTablebase::MaxSize, ColourWarsTablebase::MaxScore);
+		return 1;
+	}
+
+	const int32 NumTasks = FPlatformMisc::NumberOfCoresIncludingHyperthreads() * 4;
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<FColourWarsTablebaseKey> Positions;
+	FindPositions(Size, MaxScore, NumTasks, Positions);
+
+	TArray<uint8> Values;
+	const int32 NumPasses = SolvePositions(Size, MaxScore, NumTasks, Positions, Values);
+
+	// Only won and lost positions are written, any other position the table covers is a draw
+	TArray<FColourWarsTablebaseKey> Keys;
+	TArray<uint8> KeyValues;
+	int32 NumWon = 0;
+	for (int32 Index = 0; Index < Positions.Num(); Index++)
+	{
+		if (Values[Index] != 0)
+		{
+			Keys.Add(Positions[Index]);
+			KeyValues.Add(Values[Index]);
+			NumWon += (Values[Index] & ColourWarsTablebase::WinFlag) != 0 ? 1 : 0;
+		}
+	}
+
+	UE_LOG(LogColourWarsTablebaseGen, Display, TEXT("%d positions in %.1f seconds and %d passes: %d won, %d lost and %d drawn for the player to move."),
+		Positions.Num(), FPlatformTime::Seconds() - StartTime, NumPasses, NumWon, Keys.Num() - NumWon, Positions.Num() - Keys.Num());
+
+	if (!FColourWarsTablebase::Write(Output, Size, MaxScore, Keys, KeyValues))
+	{
+		UE_LOG(LogColourWarsTablebaseGen, Error, TEXT("Could not write '%s'."), *Output);
+		return 1;
+	}
+
+	UE_LOG(LogColourWarsTablebaseGen, Display, TEXT("Wrote '%s'."), *Output);
+	return 0;
+}
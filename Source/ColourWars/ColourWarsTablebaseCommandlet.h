@@ -0,0 +1,27 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ColourWarsTablebaseCommandlet.generated.h"
+
+/**
+ * Solves every position of a small two player board that can be reached from the start of a game and writes the
+ * won and lost ones to a tablebase.
+ *
+ * Usage: ColourWars -run=ColourWarsTablebase [-Size=3] [-MaxScore=2] [-Output=<file>]
+ * Output defaults to Content/Tablebases/ColourWars_<Size>x<Size>.cwtb, where the game mounts tables at startup.
+ * Scores are capped at MaxScore, at most 4, and positions are stored once for all of their symmetric forms. The
+ * number of positions grows very quickly with both: a 3x3 board capped at 2 has about a million.
+ */
+UCLASS()
+class UColourWarsTablebaseCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UColourWarsTablebaseCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
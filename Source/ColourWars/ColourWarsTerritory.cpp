@@ -0,0 +1,230 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsTerritory.h"
+
+FColourWarsTerritory::FColourWarsTerritory()
+	: Size(0)
+	, NumberOfPlayers(0)
+{
+	FMemory::Memzero(NumRegions);
+	FMemory::Memzero(bNeedsRebuild);
+}
+
+/// <summary>
+/// A block the player gains starts a region of its own and joins the regions of its neighbours, unless the player
+/// is to be built again anyway. The cell's old owner has lost a block, which may have split one of their regions.
+/// </summary>
+void FColourWarsTerritory::UpdateCell(const FColourWarsBoard& Board, int32 Index)
+{
+	if (!IsBuiltFor(Board))
+	{
+		Rebuild(Board);
+		return;
+	}
+
+	const uint8 OldOwner = Owners[Index];
+	const uint8 Owner = static_cast<uint8>(Board.GetBlockType(Index));
+	const uint8 bIsCapital = Board.IsCapitalBlock(Index) ? 1 : 0;
+	if (OldOwner == Owner && Capitals[Index] == bIsCapital)
+	{
+		return;
+	}
+
+	if (Capitals[Index])
+	{
+		CapitalCells[OldOwner].RemoveSingleSwap(Index);
+	}
+	if (bIsCapital)
+	{
+		CapitalCells[Owner].Add(Index);
+	}
+	Capitals[Index] = bIsCapital;
+
+	if (OldOwner == Owner)
+	{
+		return;
+	}
+
+	Owners[Index] = Owner;
+	bNeedsRebuild[OldOwner] = true;
+
+	if (Owner == static_cast<uint8>(eBlockType::None) || bNeedsRebuild[Owner])
+	{
+		return;
+	}
+
+	Parents[Index] = Index;
+	RegionSizes[Index] = 1;
+	NumRegions[Owner]++;
+
+	Board.ForEachNeighbour(Index, false, [&](int32 NeighbourIndex)
+	{
+		if (Owners[NeighbourIndex] == Owner && Union(Index, NeighbourIndex))
+		{
+			NumRegions[Owner]--;
+		}
+	});
+}
+
+void FColourWarsTerritory::Rebuild(const FColourWarsBoard& Board)
+{
+	Size = Board.GetSize();
+	NumberOfPlayers = Board.GetNumberOfPlayers();
+
+	const int32 NumCells = Board.GetNumCells();
+	Owners.SetNumUninitialized(NumCells);
+	Capitals.SetNumUninitialized(NumCells);
+	Parents.SetNumUninitialized(NumCells);
+	RegionSizes.SetNumUninitialized(NumCells);
+	for (TArray<int32>& Cells : CapitalCells)
+	{
+		Cells.Reset();
+	}
+
+	for (int32 Index = 0; Index < NumCells; Index++)
+	{
+		Owners[Index] = static_cast<uint8>(Board.GetBlockType(Index));
+		Capitals[Index] = Board.IsCapitalBlock(Index) ? 1 : 0;
+		if (Capitals[Index])
+		{
+			CapitalCells[Owners[Index]].Add(Index);
+		}
+	}
+
+	// None is never built, empty cells have no regions
+	FMemory::Memzero(NumRegions);
+	for (int32 Player = 1; Player < 5; Player++)
+	{
+		bNeedsRebuild[Player] = true;
+	}
+}
+
+int32 FColourWarsTerritory::GetNumRegions(eBlockType Player) const
+{
+	BuildPlayer(static_cast<uint8>(Player));
+	return NumRegions[static_cast<int32>(Player)];
+}
+
+int32 FColourWarsTerritory::GetRegionSize(int32 Index) const
+{
+	const uint8 Owner = Owners[Index];
+	if (Owner == static_cast<uint8>(eBlockType::None))
+	{
+		return 0;
+	}
+
+	BuildPlayer(Owner);
+	return RegionSizes[Find(Index)];
+}
+
+void FColourWarsTerritory::GetRegionSizes(eBlockType Player, TArray<int32>& OutSizes) const
+{
+	const uint8 Owner = static_cast<uint8>(Player);
+	BuildPlayer(Owner);
+
+	for (int32 Index = 0; Index < Owners.Num(); Index++)
+	{
+		if (Owners[Index] == Owner && Parents[Index] == Index)
+		{
+			OutSizes.Add(RegionSizes[Index]);
+		}
+	}
+}
+
+/// <summary>
+/// Capitals that share a region only count it once
+/// </summary>
+int32 FColourWarsTerritory::GetCapitalArea(eBlockType Player) const
+{
+	const uint8 Owner = static_cast<uint8>(Player);
+	BuildPlayer(Owner);
+
+	TArray<int32, TInlineAllocator<8>> Roots;
+	int32 Area = 0;
+	for (int32 Index : CapitalCells[Owner])
+	{
+		const int32 Root = Find(Index);
+		if (!Roots.Contains(Root))
+		{
+			Roots.Add(Root);
+			Area += RegionSizes[Root];
+		}
+	}
+
+	return Area;
+}
+
+int32 FColourWarsTerritory::Find(int32 Index) const
+{
+	// Path halving, every other cell on the way up points to its grandparent
+	while (Parents[Index] != Index)
+	{
+		Parents[Index] = Parents[Parents[Index]];
+		Index = Parents[Index];
+	}
+
+	return Index;
+}
+
+bool FColourWarsTerritory::Union(int32 IndexA, int32 IndexB) const
+{
+	int32 RootA = Find(IndexA);
+	int32 RootB = Find(IndexB);
+	if (RootA == RootB)
+	{
+		return false;
+	}
+
+	// The smaller region goes under the larger, which keeps the trees shallow
+	if (RegionSizes[RootA] < RegionSizes[RootB])
+	{
+		Swap(RootA, RootB);
+	}
+
+	Parents[RootB] = RootA;
+	RegionSizes[RootA] += RegionSizes[RootB];
+	return true;
+}
+
+/// <summary>
+/// Start every block of the player in a region of its own, then join each one to the blocks after it in X and in Y
+/// </summary>
+void FColourWarsTerritory::BuildPlayer(uint8 Player) const
+{
+	if (Player == static_cast<uint8>(eBlockType::None) || !bNeedsRebuild[Player])
+	{
+		return;
+	}
+
+	bNeedsRebuild[Player] = false;
+	NumRegions[Player] = 0;
+
+	const int32 NumCells = Owners.Num();
+	for (int32 Index = 0; Index < NumCells; Index++)
+	{
+		if (Owners[Index] == Player)
+		{
+			Parents[Index] = Index;
+			RegionSizes[Index] = 1;
+			NumRegions[Player]++;
+		}
+	}
+
+	for (int32 Index = 0; Index < NumCells; Index++)
+	{
+		if (Owners[Index] != Player)
+		{
+			continue;
+		}
+
+		if (Index / Size < Size - 1 && Owners[Index + Size] == Player && Union(Index, Index + Size))
+		{
+			NumRegions[Player]--;
+		}
+
+		if (Index % Size < Size - 1 && Owners[Index + 1] == Player && Union(Index, Index + 1))
+		{
+			NumRegions[Player]--;
+		}
+	}
+}
@@ -0,0 +1,74 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColourWarsBoard.h"
+
+/**
+ * The connected regions of each player's blocks, joined vertically and horizontally, kept up to date a cell at a time
+ * as the board changes.
+ *
+ * Each player's regions are a union-find over their cells. A block a player gains is joined to the regions of its
+ * neighbours, but a block they lose can split a region, which union-find cannot undo, so losing a block marks the
+ * player's regions to be built again the next time they are asked for. Like the threat map, this keeps its own copy
+ * of each cell's owner, so updating a cell that has not changed does nothing.
+ */
+class COLOURWARS_API FColourWarsTerritory
+{
+public:
+	FColourWarsTerritory();
+
+	/** Bring the regions up to date with a cell of the board, call after the cell has been written */
+	void UpdateCell(const FColourWarsBoard& Board, int32 Index);
+
+	/** Build the regions of every player */
+	void Rebuild(const FColourWarsBoard& Board);
+
+	/** Are the regions built for a board of this size and player count */
+	bool IsBuiltFor(const FColourWarsBoard& Board) const { return Size == Board.GetSize() && NumberOfPlayers == Board.GetNumberOfPlayers(); }
+
+	/** Number of separate regions a player's blocks form */
+	int32 GetNumRegions(eBlockType Player) const;
+
+	/** Number of blocks in the region of a cell, 0 for an empty cell */
+	int32 GetRegionSize(int32 Index) const;
+
+	/** Add the size of each of a player's regions, this looks at every cell */
+	void GetRegionSizes(eBlockType Player, TArray<int32>& OutSizes) const;
+
+	/** Number of blocks in the regions that hold at least one of the player's capitals */
+	int32 GetCapitalArea(eBlockType Player) const;
+
+private:
+	int32 Size;
+
+	int32 NumberOfPlayers;
+
+	/** Owner and capital status of every cell as the regions last saw them */
+	TArray<uint8> Owners;
+	TArray<uint8> Capitals;
+
+	/** Capital cells of each player */
+	TArray<int32> CapitalCells[5];
+
+	/**
+	 * Parent of each cell in its player's union-find and the size of each root's region. Finds compress paths and
+	 * a player who has lost a block is built again on their next query, so these change on const queries.
+	 */
+	mutable TArray<int32> Parents;
+	mutable TArray<int32> RegionSizes;
+	mutable int32 NumRegions[5];
+
+	/** Has the player lost a block since their regions were last built */
+	mutable bool bNeedsRebuild[5];
+
+	/** Root of the region of a cell */
+	int32 Find(int32 Index) const;
+
+	/** Join the regions of two cells of one player, returning false if they were already joined */
+	bool Union(int32 IndexA, int32 IndexB) const;
+
+	/** Build a player's regions again if they have lost a block */
+	void BuildPlayer(uint8 Player) const;
+};
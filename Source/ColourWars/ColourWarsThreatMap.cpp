@@ -0,0 +1,152 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsThreatMap.h"
+
+const int32 FColourWarsThreatMap::NoAttack = MIN_int32;
+
+FColourWarsThreatMap::FColourWarsThreatMap()
+	: Size(0)
+	, NumberOfPlayers(0)
+{
+	FMemory::Memzero(NumFrontier);
+}
+
+/// <summary>
+/// A cell's attacks on its neighbours and their attacks on it only depend on the cells themselves, and so does whether
+/// they border another player, so only the cell and its vertical and horizontal neighbours are worked out again
+/// </summary>
+void FColourWarsThreatMap::UpdateCell(const FColourWarsBoard& Board, int32 Index)
+{
+	if (!IsBuiltFor(Board))
+	{
+		Rebuild(Board);
+		return;
+	}
+
+	const uint8 BlockType = static_cast<uint8>(Board.GetBlockType(Index));
+	const int32 Score = Board.GetScore(Index);
+	if (BlockTypes[Index] == BlockType && Scores[Index] == Score)
+	{
+		return;
+	}
+
+	const bool bTypeChanged = BlockTypes[Index] != BlockType;
+	BlockTypes[Index] = BlockType;
+	Scores[Index] = Score;
+
+	RefreshAttacks(Board, Index);
+	ForEachDirection(Index, [&](int32 Direction, int32 NeighbourIndex)
+	{
+		RefreshAttacks(Board, NeighbourIndex);
+		if (bTypeChanged)
+		{
+			RefreshFrontier(NeighbourIndex);
+		}
+	});
+
+	if (bTypeChanged)
+	{
+		RefreshFrontier(Index);
+	}
+}
+
+void FColourWarsThreatMap::Rebuild(const FColourWarsBoard& Board)
+{
+	Size = Board.GetSize();
+	NumberOfPlayers = Board.GetNumberOfPlayers();
+
+	const int32 NumCells = Board.GetNumCells();
+	BlockTypes.SetNumUninitialized(NumCells);
+	Scores.SetNumUninitialized(NumCells);
+	for (int32 Index = 0; Index < NumCells; Index++)
+	{
+		BlockTypes[Index] = static_cast<uint8>(Board.GetBlockType(Index));
+		Scores[Index] = Board.GetScore(Index);
+	}
+
+	AttackMasks.Init(0, NumCells);
+	StrongestAttacks.Init(NoAttack, NumCells);
+	FrontierFlags.Init(0, NumCells);
+	FMemory::Memzero(NumFrontier);
+
+	for (int32 Index = 0; Index < NumCells; Index++)
+	{
+		RefreshAttacks(Board, Index);
+		RefreshFrontier(Index);
+	}
+}
+
+bool FColourWarsThreatMap::CanAttack(int32 AttackingIndex, int32 DefendingIndex) const
+{
+	bool bCanAttack = false;
+	ForEachDirection(AttackingIndex, [&](int32 Direction, int32 NeighbourIndex)
+	{
+		if (NeighbourIndex == DefendingIndex)
+		{
+			bCanAttack = (AttackMasks[AttackingIndex] & (1 << Direction)) != 0;
+		}
+	});
+
+	return bCanAttack;
+}
+
+/// <summary>
+/// Worked out from the types and scores the map has seen rather than the board's, so the map agrees with itself
+/// while some changed cells are still to be updated
+/// </summary>
+int32 FColourWarsThreatMap::GetAttack(const FColourWarsBoard& Board, int32 AttackingIndex, int32 DefendingIndex) const
+{
+	const uint8 AttackingType = BlockTypes[AttackingIndex];
+	const uint8 DefendingType = BlockTypes[DefendingIndex];
+	if (AttackingType == static_cast<uint8>(eBlockType::None) || AttackingType == DefendingType)
+	{
+		return NoAttack;
+	}
+
+	return Scores[AttackingIndex] - Board.AttackingCost(static_cast<eBlockType>(AttackingType), static_cast<eBlockType>(DefendingType), Scores[DefendingIndex]);
+}
+
+void FColourWarsThreatMap::RefreshAttacks(const FColourWarsBoard& Board, int32 Index)
+{
+	uint8 AttackMask = 0;
+	int32 StrongestAttack = NoAttack;
+	ForEachDirection(Index, [&](int32 Direction, int32 NeighbourIndex)
+	{
+		if (GetAttack(Board, Index, NeighbourIndex) > 0)
+		{
+			AttackMask |= 1 << Direction;
+		}
+		StrongestAttack = FMath::Max(StrongestAttack, GetAttack(Board, NeighbourIndex, Index));
+	});
+
+	AttackMasks[Index] = AttackMask;
+	StrongestAttacks[Index] = StrongestAttack;
+}
+
+/// <summary>
+/// The flag holds the player the cell was counted for, so the count it was in is known once the cell has changed hands
+/// </summary>
+void FColourWarsThreatMap::RefreshFrontier(int32 Index)
+{
+	const uint8 BlockType = BlockTypes[Index];
+	bool bFrontier = false;
+	if (BlockType != static_cast<uint8>(eBlockType::None))
+	{
+		ForEachDirection(Index, [&](int32 Direction, int32 NeighbourIndex)
+		{
+			const uint8 NeighbourType = BlockTypes[NeighbourIndex];
+			bFrontier |= NeighbourType != static_cast<uint8>(eBlockType::None) && NeighbourType != BlockType;
+		});
+	}
+
+	if (FrontierFlags[Index] != 0)
+	{
+		NumFrontier[FrontierFlags[Index]]--;
+	}
+
+	FrontierFlags[Index] = bFrontier ? BlockType : 0;
+	if (bFrontier)
+	{
+		NumFrontier[BlockType]++;
+	}
+}
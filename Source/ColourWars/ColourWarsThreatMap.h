@@ -0,0 +1,88 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColourWarsBoard.h"
+
+/**
+ * Which blocks can take which of their neighbours, the strongest attack on every cell and the frontier of each player,
+ * kept up to date a cell at a time as the board changes so they can be read in O(1) per cell.
+ *
+ * The map keeps its own copy of each cell's type and score, so updating a cell that has not changed since it was
+ * last seen does nothing, and the first update after the board changes size or player count builds the whole map.
+ */
+class COLOURWARS_API FColourWarsThreatMap
+{
+public:
+	/** Strongest attack on a cell no enemy block borders */
+	static const int32 NoAttack;
+
+	FColourWarsThreatMap();
+
+	/** Bring the map up to date with a cell of the board, call after the cell has been written */
+	void UpdateCell(const FColourWarsBoard& Board, int32 Index);
+
+	/** Build the map for every cell of the board */
+	void Rebuild(const FColourWarsBoard& Board);
+
+	/** Is the map built for a board of this size and player count */
+	bool IsBuiltFor(const FColourWarsBoard& Board) const { return Size == Board.GetSize() && NumberOfPlayers == Board.GetNumberOfPlayers(); }
+
+	/** Bit for each neighbour the block of a cell can take: X - 1, X + 1, Y - 1 then Y + 1 */
+	uint8 GetAttackMask(int32 Index) const { return AttackMasks[Index]; }
+
+	/** Can the attacking block take its vertical or horizontal neighbour, the same as FColourWarsBoard::CanDefeat */
+	bool CanAttack(int32 AttackingIndex, int32 DefendingIndex) const;
+
+	/**
+	 * Most a neighbour would have left after taking the cell, i.e. its score less the attacking cost, or NoAttack.
+	 * The cell can be taken if this is above 0.
+	 */
+	int32 GetStrongestAttack(int32 Index) const { return StrongestAttacks[Index]; }
+
+	bool IsThreatened(int32 Index) const { return StrongestAttacks[Index] > 0; }
+
+	/** Is the cell a player's block that borders a block of another player */
+	bool IsFrontier(int32 Index) const { return FrontierFlags[Index] != 0; }
+
+	/** Number of frontier blocks a player has */
+	int32 GetNumFrontier(eBlockType Player) const { return NumFrontier[static_cast<int32>(Player)]; }
+
+private:
+	int32 Size;
+
+	int32 NumberOfPlayers;
+
+	/** Type and score of every cell as the map last saw them */
+	TArray<uint8> BlockTypes;
+	TArray<int32> Scores;
+
+	TArray<uint8> AttackMasks;
+	TArray<int32> StrongestAttacks;
+	TArray<uint8> FrontierFlags;
+
+	int32 NumFrontier[5];
+
+	/** Call Func(Direction, NeighbourIndex) for each vertical and horizontal neighbour, Direction being its mask bit */
+	template<typename FuncType>
+	void ForEachDirection(int32 Index, FuncType Func) const
+	{
+		const int32 X = Index / Size;
+		const int32 Y = Index % Size;
+
+		if (X > 0)        { Func(0, Index - Size); }
+		if (X < Size - 1) { Func(1, Index + Size); }
+		if (Y > 0)        { Func(2, Index - 1); }
+		if (Y < Size - 1) { Func(3, Index + 1); }
+	}
+
+	/** Score the attacking block would have left after taking the defending block, NoAttack if it cannot attack it */
+	int32 GetAttack(const FColourWarsBoard& Board, int32 AttackingIndex, int32 DefendingIndex) const;
+
+	/** Work out the attack mask and strongest attack of a cell from its neighbours */
+	void RefreshAttacks(const FColourWarsBoard& Board, int32 Index);
+
+	/** Work out whether a cell is on the frontier, keeping the frontier counts */
+	void RefreshFrontier(int32 Index);
+};
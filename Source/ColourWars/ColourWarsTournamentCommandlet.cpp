@@ -0,0 +1,450 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsTournamentCommandlet.h"
+#include "ColourWarsSearch.h"
+#include "Async/ParallelFor.h"
+#include "Math/RandomStream.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogColourWarsTournament, Log, All);
+
+namespace
+{
+	enum class EBotType : uint8
+	{
+		/** A random legal move */
+		Random,
+
+		/** FColourWarsSearch to a depth or for a time */
+		Search,
+	};
+
+	struct FTournamentBot
+	{
+		/** The bot as given on the command line */
+		FString Name;
+
+		EBotType Type = EBotType::Random;
+
+		/** Time to search each turn, 0 for no limit */
+		double TurnSeconds = 0.0;
+
+		int32 MaxDepth = FColourWarsSearch::MaxPly;
+
+		FColourWarsEvalWeights Weights = FColourWarsEvalWeights::GetDefault();
+	};
+
+	/** One game between two bots, Seats holds 0 or 1 for the bot playing each player */
+	struct FTournamentGame
+	{
+		int32 Opening;
+		int32 Bots[2];
+		uint8 Seats[4];
+	};
+
+	/** Turns one bot played in a game */
+	struct FTournamentTurns
+	{
+		int32 NumTurns = 0;
+		double Seconds = 0.0;
+		double MaxSeconds = 0.0;
+		int64 DepthSum = 0;
+	};
+
+	struct FTournamentResult
+	{
+		/** Score of the game's first bot: 1 for a win, 0.5 for a draw and 0 for a loss */
+		float Score = 0.5f;
+
+		FTournamentTurns Turns[2];
+	};
+
+	/** Totals of one bot over the tournament */
+	struct FTournamentBotTotals
+	{
+		int32 Wins = 0;
+		int32 Draws = 0;
+		int32 Losses = 0;
+		FTournamentTurns Turns;
+	};
+
+	/** Transposition table of each search bot, 2^16 entries is plenty for a few milliseconds a turn */
+	const int32 TableSizeLog2 = 16;
+
+	/** Parse Random, Greedy[:<ini>], Depth:<plies>[:<ini>] or Search:<milliseconds>[:<ini>] */
+	bool ParseBot(const FString& Spec, FTournamentBot& OutBot)
+	{
+		FString Type = Spec;
+		FString Rest;
+		Spec.Split(TEXT(":"), &Type, &Rest);
+
+		// Split at the first colon only, so a Windows path to the weights keeps its drive letter
+		FString Limit = Rest;
+		FString WeightsFile;
+		if (!Type.Equals(TEXT("Greedy"), ESearchCase::IgnoreCase))
+		{
+			Rest.Split(TEXT(":"), &Limit, &WeightsFile);
+		}
+		else
+		{
+			WeightsFile = Rest;
+			Limit.Empty();
+		}
+
+		OutBot.Name = Spec;
+		if (Type.Equals(TEXT("Random"), ESearchCase::IgnoreCase))
+		{
+			OutBot.Type = EBotType::Random;
+			return true;
+		}
+
+		OutBot.Type = EBotType::Search;
+		if (Type.Equals(TEXT("Greedy"), ESearchCase::IgnoreCase))
+		{
+			OutBot.MaxDepth = 1;
+		}
+		else if (Type.Equals(TEXT("Depth"), ESearchCase::IgnoreCase) && Limit.IsNumeric())
+		{
+			OutBot.MaxDepth = FMath::Clamp(FCString::Atoi(*Limit), 1, FColourWarsSearch::MaxPly);
+		}
+		else if (Type.Equals(TEXT("Search"), ESearchCase::IgnoreCase) && Limit.IsNumeric())
+		{
+			OutBot.TurnSeconds = FMath::Max(FCString::Atod(*Limit), 0.1) / 1000.0;
+		}
+		else
+		{
+			return false;
+		}
+
+		return WeightsFile.IsEmpty() || OutBot.Weights.LoadFromFile(WeightsFile);
+	}
+
+	/** Parse a comma separated list of numbers */
+	void ParseList(const FString& List, TArray<int32>& OutValues)
+	{
+		TArray<FString> Items;
+		List.ParseIntoArray(Items, TEXT(","));
+		for (const FString& Item : Items)
+		{
+			OutValues.Add(FCString::Atoi(*Item));
+		}
+	}
+
+	/** Every distinct rotation of the seats alternating between two bots, starting with either of them */
+	void GetSeatings(int32 NumberOfPlayers, TArray<TArray<uint8>>& OutSeatings)
+	{
+		for (int32 FirstBot = 0; FirstBot < 2; FirstBot++)
+		{
+			for (int32 Rotation = 0; Rotation < NumberOfPlayers; Rotation++)
+			{
+				TArray<uint8> Seating;
+				for (int32 Seat = 0; Seat < NumberOfPlayers; Seat++)
+				{
+					Seating.Add(static_cast<uint8>((FirstBot + (Seat + Rotation) % NumberOfPlayers) % 2));
+				}
+				OutSeatings.AddUnique(Seating);
+			}
+		}
+	}
+
+	/**
+	 * Fit Elo ratings to the score of each pair of bots with the Bradley-Terry model, and the standard error of each.
+	 * Each pair that played gets one virtual draw, so a bot that won or lost every game still has a finite rating.
+	 * Ratings average to 0.
+	 */
+	void FitRatings(int32 NumBots, const TArray<float>& PairScores, const TArray<int32>& PairGames, TArray<float>& OutRatings, TArray<float>& OutErrors)
+	{
+		TArray<float> Strengths;
+		Strengths.Init(1.f, NumBots);
+
+		for (int32 Iteration = 0; Iteration < 1000; Iteration++)
+		{
+			float MaxChange = 0.f;
+			for (int32 Bot = 0; Bot < NumBots; Bot++)
+			{
+				float Score = 0.f;
+				float Expected = 0.f;
+				for (int32 Opponent = 0; Opponent < NumBots; Opponent++)
+				{
+					const int32 NumGames = PairGames[Bot * NumBots + Opponent];
+					if (Opponent != Bot && NumGames > 0)
+					{
+						Score += PairScores[Bot * NumBots + Opponent] + 0.5f;
+						Expected += (NumGames + 1) / (Strengths[Bot] + Strengths[Opponent]);
+					}
+				}
+
+				if (Expected > 0.f)
+				{
+					const float Strength = Score / Expected;
+					MaxChange = FMath::Max(MaxChange, FMath::Abs(FMath::Loge(Strength / Strengths[Bot])));
+					Strengths[Bot] = Strength;
+				}
+			}
+
+			float LogMean = 0.f;
+			for (float Strength : Strengths)
+			{
+				LogMean += FMath::Loge(Strength) / NumBots;
+			}
+			for (float& Strength : Strengths)
+			{
+				Strength /= FMath::Exp(LogMean);
+			}
+
+			if (MaxChange < 1e-5f)
+			{
+				break;
+			}
+		}
+
+		const float EloPerLog = 400.f / FMath::Loge(10.f);
+		OutRatings.SetNum(NumBots);
+		OutErrors.SetNum(NumBots);
+
+		for (int32 Bot = 0; Bot < NumBots; Bot++)
+		{
+			float Information = 0.f;
+			for (int32 Opponent = 0; Opponent < NumBots; Opponent++)
+			{
+				const int32 NumGames = PairGames[Bot * NumBots + Opponent];
+				if (Opponent != Bot && NumGames > 0)
+				{
+					const float Expected = Strengths[Bot] / (Strengths[Bot] + Strengths[Opponent]);
+					Information += (NumGames + 1) * Expected * (1.f - Expected);
+				}
+			}
+
+			OutRatings[Bot] = FMath::Loge(Strengths[Bot]) * EloPerLog;
+			OutErrors[Bot] = Information > 0.f ? EloPerLog / FMath::Sqrt(Information) : 0.f;
+		}
+	}
+}
+
+UColourWarsTournamentCommandlet::UColourWarsTournamentCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UColourWarsTournamentCommandlet::Main(const FString& Params)
+{
+	FString BotList = TEXT("Search:10,Greedy,Random");
+	FString SizeList = TEXT("7");
+	FString PlayerList = TEXT("2");
+	int32 NumOpenings = 8;
+	int32 OpeningTurns = 4;
+	int32 NumRounds = 1;
+	int32 MaxTurns = 400;
+	int32 Seed = 1;
+	FParse::Value(*Params, TEXT("Bots="), BotList, false);
+	FParse::Value(*Params, TEXT("Sizes="), SizeList, false);
+	FParse::Value(*Params, TEXT("Players="), PlayerList, false);
+	FParse::Value(*Params, TEXT("Openings="), NumOpenings);
+	FParse::Value(*Params, TEXT("OpeningTurns="), OpeningTurns);
+	FParse::Value(*Params, TEXT("Rounds="), NumRounds);
+	FParse::Value(*Params, TEXT("MaxTurns="), MaxTurns);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	const bool bGauntlet = FParse::Param(*Params, TEXT("Gauntlet"));
+
+	TArray<FString> BotSpecs;
+	BotList.ParseIntoArray(BotSpecs, TEXT(","));
+
+	TArray<FTournamentBot> Bots;
+	for (const FString& Spec : BotSpecs)
+	{
+		FTournamentBot& Bot = Bots.AddDefaulted_GetRef();
+		if (!ParseBot(Spec, Bot))
+		{
+			UE_LOG(LogColourWarsTournament, Error, TEXT("Could not read the bot '%s'."), *Spec);
+			return 1;
+		}
+	}
+
+	TArray<int32> Sizes;
+	TArray<int32> PlayerCounts;
+	ParseList(SizeList, Sizes);
+	ParseList(PlayerList, PlayerCounts);
+
+	const bool bValidSizes = Sizes.Num() > 0 && !Sizes.ContainsByPredicate([](int32 Size) { return Size < 2 || Size > FColourWarsBoard::MaxSize; });
+	const bool bValidPlayers = PlayerCounts.Num() > 0 && !PlayerCounts.ContainsByPredicate([](int32 Players) { return Players < 2 || Players > 4; });
+	if (Bots.Num() < 2 || !bValidSizes || !bValidPlayers || NumOpenings < 1 || NumRounds < 1)
+	{
+		UE_LOG(LogColourWarsTournament, Error, TEXT("Need at least two bots, sizes of 2 to %d, 2 to 4 players and at least one opening and round."), FColourWarsBoard::MaxSize);
+		return 1;
+	}
+
+	// Openings for every size and player count, the same for every pair of bots
+	TArray<FColourWarsBoard> Openings;
+	TArray<FTournamentGame> Games;
+	FRandomStream Random(Seed);
+
+	for (int32 Size : Sizes)
+	{
+		for (int32 NumberOfPlayers : PlayerCounts)
+		{
+			TArray<TArray<uint8>> Seatings;
+			GetSeatings(NumberOfPlayers, Seatings);
+
+			for (int32 OpeningIndex = 0; OpeningIndex < NumOpenings; OpeningIndex++)
+			{
+				FColourWarsBoard& Opening = Openings.AddDefaulted_GetRef();
+				Opening.Init(Size, NumberOfPlayers);
+
+				TArray<FColourWarsMove> Moves;
+				for (int32 Turn = 0; Turn < OpeningTurns && !Opening.IsGameOver(); Turn++)
+				{
+					Moves.Reset();
+					Opening.GetLegalMoves(Moves);
+					Opening.ApplyTurn(Moves[Random.RandHelper(Moves.Num())]);
+				}
+
+				for (int32 First = 0; First < Bots.Num(); First++)
+				{
+					for (int32 Second = First + 1; Second < Bots.Num(); Second++)
+					{
+						if (bGauntlet && First != 0)
+						{
+							continue;
+						}
+
+						for (const TArray<uint8>& Seating : Seatings)
+						{
+							for (int32 Round = 0; Round < NumRounds; Round++)
+							{
+								FTournamentGame& Game = Games.AddDefaulted_GetRef();
+								Game.Opening = Openings.Num() - 1;
+								Game.Bots[0] = First;
+								Game.Bots[1] = Second;
+								FMemory::Memzero(Game.Seats);
+								FMemory::Memcpy(Game.Seats, Seating.GetData(), Seating.Num());
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	UE_LOG(LogColourWarsTournament, Display, TEXT("Playing %d games between %d bots from %d openings."), Games.Num(), Bots.Num(), Openings.Num());
+
+	TArray<FTournamentResult> Results;
+	Results.SetNum(Games.Num());
+
+	const double StartTime = FPlatformTime::Seconds();
+	ParallelFor(Games.Num(), [&](int32 GameIndex)
+	{
+		const FTournamentGame& Game = Games[GameIndex];
+		FTournamentResult& Result = Results[GameIndex];
+		FColourWarsBoard Board = Openings[Game.Opening];
+
+		TUniquePtr<FColourWarsSearch> Searches[2];
+		for (int32 Side = 0; Side < 2; Side++)
+		{
+			const FTournamentBot& Bot = Bots[Game.Bots[Side]];
+			if (Bot.Type == EBotType::Search)
+			{
+				Searches[Side] = MakeUnique<FColourWarsSearch>(Bot.Weights, TableSizeLog2);
+			}
+		}
+
+		FRandomStream GameRandom(Seed + GameIndex);
+		TArray<FColourWarsMove> Moves;
+
+		while (!Board.IsGameOver() && Board.GetTurn() < MaxTurns)
+		{
+			const int32 Side = Game.Seats[static_cast<int32>(Board.GetCurrentPlayer()) - 1];
+			const FTournamentBot& Bot = Bots[Game.Bots[Side]];
+			FTournamentTurns& Turns = Result.Turns[Side];
+
+			const double TurnStart = FPlatformTime::Seconds();
+			FColourWarsMove Move;
+			if (Searches[Side].IsValid())
+			{
+				Move = Searches[Side]->Search(Board, Bot.TurnSeconds > 0.0 ? Bot.TurnSeconds : TNumericLimits<double>::Max(), Bot.MaxDepth);
+				Turns.DepthSum += Searches[Side]->GetCompletedDepth();
+			}
+			else
+			{
+				Moves.Reset();
+				Board.GetLegalMoves(Moves);
+				Move = Moves[GameRandom.RandHelper(Moves.Num())];
+			}
+			const double TurnSeconds = FPlatformTime::Seconds() - TurnStart;
+
+			Turns.NumTurns++;
+			Turns.Seconds += TurnSeconds;
+			Turns.MaxSeconds = FMath::Max(Turns.MaxSeconds, TurnSeconds);
+
+			Board.ApplyTurn(Move);
+		}
+
+		if (Board.IsGameOver())
+		{
+			Result.Score = Game.Seats[static_cast<int32>(Board.GetCurrentPlayer()) - 1] == 0 ? 1.f : 0.f;
+		}
+	});
+	const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+	const int32 NumBots = Bots.Num();
+	TArray<float> PairScores;
+	TArray<int32> PairGames;
+	TArray<FTournamentBotTotals> Totals;
+	PairScores.Init(0.f, NumBots * NumBots);
+	PairGames.Init(0, NumBots * NumBots);
+	Totals.SetNum(NumBots);
+
+	for (int32 GameIndex = 0; GameIndex < Games.Num(); GameIndex++)
+	{
+		const FTournamentGame& Game = Games[GameIndex];
+		const FTournamentResult& Result = Results[GameIndex];
+
+		for (int32 Side = 0; Side < 2; Side++)
+		{
+			const int32 Bot = Game.Bots[Side];
+			const int32 Opponent = Game.Bots[1 - Side];
+			const float Score = Side == 0 ? Result.Score : 1.f - Result.Score;
+
+			PairScores[Bot * NumBots + Opponent] += Score;
+			PairGames[Bot * NumBots + Opponent]++;
+
+			FTournamentBotTotals& BotTotals = Totals[Bot];
+			BotTotals.Wins += Score == 1.f ? 1 : 0;
+			BotTotals.Draws += Score == 0.5f ? 1 : 0;
+			BotTotals.Losses += Score == 0.f ? 1 : 0;
+			BotTotals.Turns.NumTurns += Result.Turns[Side].NumTurns;
+			BotTotals.Turns.Seconds += Result.Turns[Side].Seconds;
+			BotTotals.Turns.MaxSeconds = FMath::Max(BotTotals.Turns.MaxSeconds, Result.Turns[Side].MaxSeconds);
+			BotTotals.Turns.DepthSum += Result.Turns[Side].DepthSum;
+		}
+	}
+
+	TArray<float> Ratings;
+	TArray<float> Errors;
+	FitRatings(NumBots, PairScores, PairGames, Ratings, Errors);
+
+	UE_LOG(LogColourWarsTournament, Display, TEXT("%d games in %.1f seconds, %.1f games/s."), Games.Num(), Elapsed, Games.Num() / Elapsed);
+
+	TArray<int32> Order;
+	for (int32 Bot = 0; Bot < NumBots; Bot++)
+	{
+		Order.Add(Bot);
+	}
+	Order.Sort([&Ratings](int32 A, int32 B) { return Ratings[A] > Ratings[B]; });
+
+	for (int32 Bot : Order)
+	{
+		const FTournamentBotTotals& BotTotals = Totals[Bot];
+		const int32 NumGames = BotTotals.Wins + BotTotals.Draws + BotTotals.Losses;
+		const int32 NumTurns = FMath::Max(BotTotals.Turns.NumTurns, 1);
+
+		// 95% confidence interval
+		UE_LOG(LogColourWarsTournament, Display, TEXT("%-24s Elo %+5.0f +/- %3.0f, %d games +%d =%d -%d (%.1f%%), %.2f ms/turn (max %.1f), depth %.1f"),
+			*Bots[Bot].Name, Ratings[Bot], 1.96f * Errors[Bot], NumGames, BotTotals.Wins, BotTotals.Draws, BotTotals.Losses,
+			NumGames > 0 ? 100.0 * (BotTotals.Wins + 0.5 * BotTotals.Draws) / NumGames : 0.0,
+			BotTotals.Turns.Seconds * 1000.0 / NumTurns, BotTotals.Turns.MaxSeconds * 1000.0, (double)BotTotals.Turns.DepthSum / NumTurns);
+	}
+
+	return 0;
+}
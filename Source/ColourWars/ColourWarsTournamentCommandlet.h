@@ -0,0 +1,29 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ColourWarsTournamentCommandlet.generated.h"
+
+/**
+ * Plays bots against each other on every core and rates them, to tell whether a change makes a bot stronger.
+ *
+ * Usage: ColourWars -run=ColourWarsTournament [-Bots=Search:10,Greedy,Random] [-Gauntlet] [-Sizes=7] [-Players=2]
+ *        [-Openings=8] [-OpeningTurns=4] [-Rounds=1] [-MaxTurns=400] [-Seed=1]
+ * Each bot is Random, Greedy[:<weights ini>], Depth:<plies>[:<weights ini>] or Search:<milliseconds>[:<weights ini>].
+ * Every pair of bots plays, or with -Gauntlet the first bot plays each of the others. Sizes and Players are lists;
+ * for each size and player count a set of openings is made by playing random turns from a seeded stream, and each
+ * pair plays every opening from every seating. With 3 or 4 players the seats alternate between the pair's bots, so
+ * every game is a win, loss or draw between two bots. Games stopped at MaxTurns count as draws.
+ */
+UCLASS()
+class UColourWarsTournamentCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UColourWarsTournamentCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,399 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsTrainingData.h"
+#include "Async/Async.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+
+namespace
+{
+	const int32 ChunkHeaderSize = 16;
+
+	/** Bytes a column of NumRows elements takes, padded so the next one stays aligned */
+	int64 ColumnBytes(int64 NumElements, int32 ElementSize)
+	{
+		return Align(NumElements * ElementSize, (int64)ColourWarsTrainingData::ColumnAlignment);
+	}
+
+	int64 PositionsChunkBytes(int32 NumRows, int32 NumCells)
+	{
+		return ChunkHeaderSize + ColumnBytes(NumRows, 4) * 4 + ColumnBytes(NumRows, 1) * 2 + ColumnBytes(NumRows, 2)
+			+ ColumnBytes((int64)NumRows * NumCells, 4) + ColumnBytes((int64)NumRows * NumCells, 1);
+	}
+
+	int64 GamesChunkBytes(int32 NumRows)
+	{
+		return ChunkHeaderSize + ColumnBytes(NumRows, 4) * 2 + ColumnBytes(NumRows, 1);
+	}
+
+	template<typename ElementType>
+	void AppendColumn(TArray<uint8>& Chunk, const TArray<ElementType>& Column)
+	{
+		Chunk.Append(reinterpret_cast<const uint8*>(Column.GetData()), Column.Num() * sizeof(ElementType));
+		Chunk.AddZeroed(Align(Chunk.Num(), ColourWarsTrainingData::ColumnAlignment) - Chunk.Num());
+	}
+
+	void AppendChunkHeader(TArray<uint8>& Chunk, uint32 Tag, int32 NumRows, int64 ChunkBytes)
+	{
+		Chunk.Reserve(ChunkBytes);
+		Chunk.Append(reinterpret_cast<const uint8*>(&Tag), sizeof(Tag));
+		Chunk.Append(reinterpret_cast<const uint8*>(&NumRows), sizeof(NumRows));
+		Chunk.Append(reinterpret_cast<const uint8*>(&ChunkBytes), sizeof(ChunkBytes));
+	}
+
+	/** Take the next column of a chunk being read */
+	template<typename ElementType>
+	const ElementType* TakeColumn(const uint8*& Cursor, int64 NumElements)
+	{
+		const ElementType* Column = reinterpret_cast<const ElementType*>(Cursor);
+		Cursor += ColumnBytes(NumElements, sizeof(ElementType));
+		return Column;
+	}
+}
+
+FColourWarsTrainingDataWriter::FColourWarsTrainingDataWriter()
+	: NumCells(0)
+{
+}
+
+FColourWarsTrainingDataWriter::~FColourWarsTrainingDataWriter()
+{
+	Finish();
+}
+
+bool FColourWarsTrainingDataWriter::Begin(const FString& Filename, int32 InSize, int32 InNumberOfPlayers)
+{
+	Finish();
+
+	Archive = MakeShareable(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Archive.IsValid())
+	{
+		return false;
+	}
+
+	NumCells = InSize * InSize;
+
+	uint32 Magic = ColourWarsTrainingData::FileMagic;
+	uint16 Version = ColourWarsTrainingData::Version;
+	uint16 Players = InNumberOfPlayers;
+	uint32 Size = InSize;
+	uint32 Reserved = 0;
+
+	*Archive << Magic;
+	*Archive << Version;
+	*Archive << Players;
+	*Archive << Size;
+	*Archive << Reserved;
+
+	return true;
+}
+
+void FColourWarsTrainingDataWriter::AddPosition(const FColourWarsTrainingPosition& Position, const int32* InScores, const uint8* InCells)
+{
+	if (!Archive.IsValid())
+	{
+		return;
+	}
+
+	GameIds.Add(Position.GameId);
+	Turns.Add(Position.Turn);
+	Players.Add(static_cast<uint8>(Position.Player));
+	NumLegalMoves.Add(FMath::Min(Position.NumLegalMoves, (int32)MAX_uint16));
+	MoveTypes.Add(static_cast<uint8>(Position.MoveType));
+	Froms.Add(Position.From);
+	Tos.Add(Position.To);
+	Scores.Append(InScores, NumCells);
+	Cells.Append(InCells, NumCells);
+
+	if (GameIds.Num() >= ColourWarsTrainingData::RowsPerChunk)
+	{
+		FlushPositions();
+	}
+}
+
+void FColourWarsTrainingDataWriter::AddPosition(const FColourWarsTrainingPosition& Position, const FColourWarsBoard& Board)
+{
+	BoardScores.SetNumUninitialized(NumCells);
+	BoardCells.SetNumUninitialized(NumCells);
+
+	for (int32 Index = 0; Index < NumCells; Index++)
+	{
+		BoardScores[Index] = Board.GetScore(Index);
+		BoardCells[Index] = static_cast<uint8>(Board.GetBlockType(Index)) | (Board.IsCapitalBlock(Index) ? 0x80 : 0);
+	}
+
+	AddPosition(Position, BoardScores.GetData(), BoardCells.GetData());
+}
+
+void FColourWarsTrainingDataWriter::AddResult(int32 GameId, eBlockType Winner, int32 NumTurns)
+{
+	if (!Archive.IsValid())
+	{
+		return;
+	}
+
+	ResultGameIds.Add(GameId);
+	Winners.Add(static_cast<uint8>(Winner));
+	ResultTurns.Add(NumTurns);
+
+	if (ResultGameIds.Num() >= ColourWarsTrainingData::RowsPerChunk)
+	{
+		FlushGames();
+	}
+}
+
+void FColourWarsTrainingDataWriter::Finish()
+{
+	if (!Archive.IsValid())
+	{
+		return;
+	}
+
+	FlushPositions();
+	FlushGames();
+
+	if (PendingWrite.IsValid())
+	{
+		PendingWrite.Wait();
+	}
+
+	Archive->Close();
+	Archive.Reset();
+}
+
+void FColourWarsTrainingDataWriter::FlushPositions()
+{
+	const int32 NumRows = GameIds.Num();
+	if (NumRows == 0)
+	{
+		return;
+	}
+
+	TArray<uint8> Chunk;
+	AppendChunkHeader(Chunk, ColourWarsTrainingData::PositionsTag, NumRows, PositionsChunkBytes(NumRows, NumCells));
+	AppendColumn(Chunk, GameIds);
+	AppendColumn(Chunk, Turns);
+	AppendColumn(Chunk, Players);
+	AppendColumn(Chunk, NumLegalMoves);
+	AppendColumn(Chunk, MoveTypes);
+	AppendColumn(Chunk, Froms);
+	AppendColumn(Chunk, Tos);
+	AppendColumn(Chunk, Scores);
+	AppendColumn(Chunk, Cells);
+	WriteChunk(MoveTemp(Chunk));
+
+	GameIds.Reset();
+	Turns.Reset();
+	Players.Reset();
+	NumLegalMoves.Reset();
+	MoveTypes.Reset();
+	Froms.Reset();
+	Tos.Reset();
+	Scores.Reset();
+	Cells.Reset();
+}
+
+void FColourWarsTrainingDataWriter::FlushGames()
+{
+	const int32 NumRows = ResultGameIds.Num();
+	if (NumRows == 0)
+	{
+		return;
+	}
+
+	TArray<uint8> Chunk;
+	AppendChunkHeader(Chunk, ColourWarsTrainingData::GamesTag, NumRows, GamesChunkBytes(NumRows));
+	AppendColumn(Chunk, ResultGameIds);
+	AppendColumn(Chunk, Winners);
+	AppendColumn(Chunk, ResultTurns);
+	WriteChunk(MoveTemp(Chunk));
+
+	ResultGameIds.Reset();
+	Winners.Reset();
+	ResultTurns.Reset();
+}
+
+/// <summary>
+/// Write a chunk on a worker thread, after the one before it. Only one write is in flight at a time,
+/// so chunks land in the file in order and at most two chunks are held in memory.
+/// </summary>
+void FColourWarsTrainingDataWriter::WriteChunk(TArray<uint8>&& Chunk)
+{
+	if (PendingWrite.IsValid())
+	{
+		PendingWrite.Wait();
+	}
+
+	TSharedPtr<FArchive, ESPMode::ThreadSafe> Writer = Archive;
+	PendingWrite = Async(EAsyncExecution::ThreadPool, [Writer, Chunk = MoveTemp(Chunk)]() mutable
+	{
+		Writer->Serialize(Chunk.GetData(), Chunk.Num());
+	});
+}
+
+FColourWarsTrainingDataReader::FColourWarsTrainingDataReader()
+	: Data(nullptr)
+	, DataSize(0)
+	, Size(0)
+	, NumberOfPlayers(0)
+{
+}
+
+FColourWarsTrainingDataReader::~FColourWarsTrainingDataReader()
+{
+	// The region has to go before the file it maps
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+/// <summary>
+/// Map the file and check the header, then walk the chunk headers to find every chunk. Chunks of a tag this
+/// version does not know are skipped, and a chunk cut short, as when a writer was stopped, ends the file.
+/// </summary>
+bool FColourWarsTrainingDataReader::Open(const FString& Filename)
+{
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	LoadedFile.Empty();
+	PositionsChunks.Reset();
+	GamesChunks.Reset();
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (MappedFile.IsValid() && MappedFile->GetFileSize() > 0)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion());
+	}
+
+	if (MappedRegion.IsValid())
+	{
+		Data = MappedRegion->GetMappedPtr();
+		DataSize = MappedRegion->GetMappedSize();
+	}
+	else if (FFileHelper::LoadFileToArray(LoadedFile, *Filename))
+	{
+		Data = LoadedFile.GetData();
+		DataSize = LoadedFile.Num();
+	}
+	else
+	{
+		return false;
+	}
+
+	if (DataSize < ColourWarsTrainingData::HeaderSize)
+	{
+		return false;
+	}
+
+	uint32 Magic;
+	uint16 Version;
+	uint16 Players;
+	uint32 PackedSize;
+	FMemory::Memcpy(&Magic, Data, sizeof(Magic));
+	FMemory::Memcpy(&Version, Data + 4, sizeof(Version));
+	FMemory::Memcpy(&Players, Data + 6, sizeof(Players));
+	FMemory::Memcpy(&PackedSize, Data + 8, sizeof(PackedSize));
+
+	if (Magic != ColourWarsTrainingData::FileMagic || Version > ColourWarsTrainingData::Version
+		|| PackedSize > (uint32)FColourWarsBoard::MaxSize || Players > 4)
+	{
+		return false;
+	}
+
+	Size = PackedSize;
+	NumberOfPlayers = Players;
+
+	int64 Offset = ColourWarsTrainingData::HeaderSize;
+	while (Offset + ChunkHeaderSize <= DataSize)
+	{
+		uint32 Tag;
+		int32 NumRows;
+		int64 ChunkBytes;
+		FMemory::Memcpy(&Tag, Data + Offset, sizeof(Tag));
+		FMemory::Memcpy(&NumRows, Data + Offset + 4, sizeof(NumRows));
+		FMemory::Memcpy(&ChunkBytes, Data + Offset + 8, sizeof(ChunkBytes));
+
+		if (NumRows < 0 || ChunkBytes < ChunkHeaderSize || Offset + ChunkBytes > DataSize)
+		{
+			break;
+		}
+
+		if (Tag == ColourWarsTrainingData::PositionsTag && ChunkBytes >= PositionsChunkBytes(NumRows, Size * Size))
+		{
+			PositionsChunks.Add(Offset);
+		}
+		else if (Tag == ColourWarsTrainingData::GamesTag && ChunkBytes >= GamesChunkBytes(NumRows))
+		{
+			GamesChunks.Add(Offset);
+		}
+
+		Offset += ChunkBytes;
+	}
+
+	return true;
+}
+
+FColourWarsPositionsChunk FColourWarsTrainingDataReader::GetPositionsChunk(int32 ChunkIndex) const
+{
+	const uint8* Cursor = Data + PositionsChunks[ChunkIndex];
+
+	FColourWarsPositionsChunk Chunk;
+	FMemory::Memcpy(&Chunk.NumRows, Cursor + 4, sizeof(Chunk.NumRows));
+	Cursor += ChunkHeaderSize;
+
+	const int32 NumRows = Chunk.NumRows;
+	Chunk.GameIds = TakeColumn<uint32>(Cursor, NumRows);
+	Chunk.Turns = TakeColumn<uint32>(Cursor, NumRows);
+	Chunk.Players = TakeColumn<uint8>(Cursor, NumRows);
+	Chunk.NumLegalMoves = TakeColumn<uint16>(Cursor, NumRows);
+	Chunk.MoveTypes = TakeColumn<uint8>(Cursor, NumRows);
+	Chunk.Froms = TakeColumn<uint32>(Cursor, NumRows);
+	Chunk.Tos = TakeColumn<uint32>(Cursor, NumRows);
+	Chunk.Scores = TakeColumn<int32>(Cursor, (int64)NumRows * Size * Size);
+	Chunk.Cells = TakeColumn<uint8>(Cursor, (int64)NumRows * Size * Size);
+
+	return Chunk;
+}
+
+FColourWarsGamesChunk FColourWarsTrainingDataReader::GetGamesChunk(int32 ChunkIndex) const
+{
+	const uint8* Cursor = Data + GamesChunks[ChunkIndex];
+
+	FColourWarsGamesChunk Chunk;
+	FMemory::Memcpy(&Chunk.NumRows, Cursor + 4, sizeof(Chunk.NumRows));
+	Cursor += ChunkHeaderSize;
+
+	Chunk.GameIds = TakeColumn<uint32>(Cursor, Chunk.NumRows);
+	Chunk.Winners = TakeColumn<uint8>(Cursor, Chunk.NumRows);
+	Chunk.NumTurns = TakeColumn<uint32>(Cursor, Chunk.NumRows);
+
+	return Chunk;
+}
+
+void FColourWarsTrainingDataReader::GetWinners(TMap<uint32, eBlockType>& OutWinners) const
+{
+	for (int32 ChunkIndex = 0; ChunkIndex < GamesChunks.Num(); ChunkIndex++)
+	{
+		const FColourWarsGamesChunk Chunk = GetGamesChunk(ChunkIndex);
+		for (int32 Row = 0; Row < Chunk.NumRows; Row++)
+		{
+			OutWinners.Add(Chunk.GameIds[Row], static_cast<eBlockType>(FMath::Min<uint8>(Chunk.Winners[Row], 4)));
+		}
+	}
+}
+
+void FColourWarsTrainingDataReader::GetBoard(const FColourWarsPositionsChunk& Chunk, int32 Row, FColourWarsBoard& OutBoard) const
+{
+	const int32 NumCells = Size * Size;
+	const int32* RowScores = Chunk.Scores + (int64)Row * NumCells;
+	const uint8* RowCells = Chunk.Cells + (int64)Row * NumCells;
+
+	OutBoard.Init(Size, NumberOfPlayers);
+	for (int32 Index = 0; Index < NumCells; Index++)
+	{
+		OutBoard.SetCell(Index, static_cast<eBlockType>(FMath::Min(RowCells[Index] & 0x7F, 4)), RowScores[Index], (RowCells[Index] & 0x80) != 0);
+	}
+
+	OutBoard.SetTurnFlow(static_cast<eBlockType>(FMath::Min<uint8>(Chunk.Players[Row], 4)), Chunk.Turns[Row], false);
+}
@@ -0,0 +1,180 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "ColourWarsBoard.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Training data files hold positions and game results in columns, a chunk of rows at a time, so a reader can
+ * memory map the file and use each column in place.
+ *
+ * Header: uint32 magic, uint16 version, uint16 players, uint32 size, uint32 reserved
+ * Chunk:  uint32 tag, uint32 row count, uint64 bytes in the chunk including this header, then each column
+ *
+ * Positions columns: uint32 game id, uint32 turn, uint8 player to move, uint16 legal move count, uint8 eMoveType
+ * played, uint32 From and To cell indices (0 when the move does not use that cell: both for a pass, To for AddOne
+ * and Combine), int32 score of every cell, uint8 type of every cell with the capital flag in the top bit. Games
+ * columns: uint32 game id, uint8 winner (None if the game was stopped), uint32 turns.
+ * Every column starts on a ColumnAlignment boundary, and the two cell columns hold a row's cells next to each
+ * other. Game ids are only unique within a file.
+ */
+namespace ColourWarsTrainingData
+{
+	const uint32 FileMagic = 0x44545743;
+	const uint16 Version = 1;
+	const uint32 PositionsTag = 0x534F5043;
+	const uint32 GamesTag = 0x4D414743;
+	const int32 RowsPerChunk = 4096;
+	const int32 ColumnAlignment = 16;
+	const int32 HeaderSize = 16;
+}
+
+/** A position as written to a training data file, besides its cells */
+struct FColourWarsTrainingPosition
+{
+	int32 GameId = 0;
+	int32 Turn = 0;
+	eBlockType Player = eBlockType::None;
+	int32 NumLegalMoves = 0;
+	eMoveType MoveType = eMoveType::Invalid;
+
+	/** Cell indices of the move, 0 for a cell the move type does not use */
+	int32 From = 0;
+	int32 To = 0;
+};
+
+/** Columns of a chunk of positions, pointing into the file */
+struct FColourWarsPositionsChunk
+{
+	int32 NumRows = 0;
+	const uint32* GameIds = nullptr;
+	const uint32* Turns = nullptr;
+	const uint8* Players = nullptr;
+	const uint16* NumLegalMoves = nullptr;
+	const uint8* MoveTypes = nullptr;
+	const uint32* Froms = nullptr;
+	const uint32* Tos = nullptr;
+
+	/** NumCells per row */
+	const int32* Scores = nullptr;
+	const uint8* Cells = nullptr;
+};
+
+/** Columns of a chunk of game results, pointing into the file */
+struct FColourWarsGamesChunk
+{
+	int32 NumRows = 0;
+	const uint32* GameIds = nullptr;
+	const uint8* Winners = nullptr;
+	const uint32* NumTurns = nullptr;
+};
+
+/**
+ * Buffers rows into columns and writes a chunk once enough have been added. The chunk is written on a worker
+ * thread while the next one fills, so adding rows never waits on the disk unless it falls a whole chunk behind.
+ */
+class COLOURWARS_API FColourWarsTrainingDataWriter
+{
+public:
+	FColourWarsTrainingDataWriter();
+	~FColourWarsTrainingDataWriter();
+
+	/** Create the file and write the header */
+	bool Begin(const FString& Filename, int32 InSize, int32 InNumberOfPlayers);
+
+	/** Add a position with its cells in board order, Cells as in FColourWarsBoard::Serialize */
+	void AddPosition(const FColourWarsTrainingPosition& Position, const int32* Scores, const uint8* Cells);
+
+	void AddPosition(const FColourWarsTrainingPosition& Position, const FColourWarsBoard& Board);
+
+	/** Add the result of a game, Winner is None for a game that was stopped before it finished */
+	void AddResult(int32 GameId, eBlockType Winner, int32 NumTurns);
+
+	/** Write what is left and close the file */
+	void Finish();
+
+	bool IsWriting() const { return Archive.IsValid(); }
+
+private:
+	/** Turn the buffered rows of a table into a chunk and start writing it */
+	void FlushPositions();
+	void FlushGames();
+	void WriteChunk(TArray<uint8>&& Chunk);
+
+	TSharedPtr<FArchive, ESPMode::ThreadSafe> Archive;
+
+	/** The chunk being written on a worker thread */
+	TFuture<void> PendingWrite;
+
+	int32 NumCells;
+
+	TArray<uint32> GameIds;
+	TArray<uint32> Turns;
+	TArray<uint8> Players;
+	TArray<uint16> NumLegalMoves;
+	TArray<uint8> MoveTypes;
+	TArray<uint32> Froms;
+	TArray<uint32> Tos;
+	TArray<int32> Scores;
+	TArray<uint8> Cells;
+
+	TArray<uint32> ResultGameIds;
+	TArray<uint8> Winners;
+	TArray<uint32> ResultTurns;
+
+	/** Cells of a board being added, kept to save allocating each time */
+	TArray<int32> BoardScores;
+	TArray<uint8> BoardCells;
+};
+
+/** Memory maps a training data file, or loads it where mapping is not supported, and finds its chunks */
+class COLOURWARS_API FColourWarsTrainingDataReader
+{
+public:
+	FColourWarsTrainingDataReader();
+	~FColourWarsTrainingDataReader();
+
+	bool Open(const FString& Filename);
+
+	int32 GetSize() const { return Size; }
+
+	int32 GetNumberOfPlayers() const { return NumberOfPlayers; }
+
+	int32 GetNumPositionsChunks() const { return PositionsChunks.Num(); }
+
+	int32 GetNumGamesChunks() const { return GamesChunks.Num(); }
+
+	/** Columns of a chunk, which stay valid while the reader is open */
+	FColourWarsPositionsChunk GetPositionsChunk(int32 ChunkIndex) const;
+	FColourWarsGamesChunk GetGamesChunk(int32 ChunkIndex) const;
+
+	/** Winner of every game in the file that has a result, None for games that were stopped */
+	void GetWinners(TMap<uint32, eBlockType>& OutWinners) const;
+
+	/** Set a board to a position of a chunk */
+	void GetBoard(const FColourWarsPositionsChunk& Chunk, int32 Row, FColourWarsBoard& OutBoard) const;
+
+private:
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	/** The whole file, when it could not be mapped */
+	TArray<uint8> LoadedFile;
+
+	const uint8* Data;
+
+	int64 DataSize;
+
+	int32 Size;
+
+	int32 NumberOfPlayers;
+
+	/** Offsets of the chunks of each table */
+	TArray<int64> PositionsChunks;
+	TArray<int64> GamesChunks;
+};
@@ -0,0 +1,187 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsTuneCommandlet.h"
+#include "ColourWarsTrainingData.h"
+#include "ColourWarsTuner.h"
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "Math/RandomStream.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogColourWarsTune, Log, All);
+
+namespace
+{
+	/** A replay file, or a chunk of positions in a training data file */
+	struct FSampleSource
+	{
+		/** Index of the replay, or of the training data file */
+		int32 File;
+
+		/** Positions chunk of the training data file, INDEX_NONE for a replay */
+		int32 Chunk;
+	};
+
+	/** A training data file, kept open for every epoch as it is only mapped */
+	struct FTrainingDataFile
+	{
+		FColourWarsTrainingDataReader Reader;
+
+		TMap<uint32, eBlockType> Winners;
+	};
+}
+
+UColourWarsTuneCommandlet::UColourWarsTuneCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UColourWarsTuneCommandlet::Main(const FString& Params)
+{
+	FString ReplayDir = FPaths::ProjectSavedDir() / TEXT("Replays");
+	FString DataDir;
+	FString Output = FPaths::ProjectSavedDir() / TEXT("ColourWarsEval.ini");
+	int32 NumEpochs = 10;
+	int32 ChunkSize = 65536;
+	float LearningRate = 0.01f;
+	int32 Seed = 1;
+	FParse::Value(*Params, TEXT("Replays="), ReplayDir);
+	FParse::Value(*Params, TEXT("Data="), DataDir);
+	FParse::Value(*Params, TEXT("Output="), Output);
+	FParse::Value(*Params, TEXT("Epochs="), NumEpochs);
+	FParse::Value(*Params, TEXT("ChunkSize="), ChunkSize);
+	FParse::Value(*Params, TEXT("LearningRate="), LearningRate);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	ChunkSize = FMath::Max(ChunkSize, 1);
+
+	TArray<FSampleSource> Sources;
+
+	TArray<FString> Replays;
+	IFileManager::Get().FindFiles(Replays, *(ReplayDir / TEXT("*.cwreplay")), true, false);
+	for (int32 Index = 0; Index < Replays.Num(); Index++)
+	{
+		Replays[Index] = ReplayDir / Replays[Index];
+		Sources.Add({ Index, INDEX_NONE });
+	}
+
+	TArray<FString> DataFilenames;
+	TArray<TUniquePtr<FTrainingDataFile>> DataFiles;
+	if (!DataDir.IsEmpty())
+	{
+		IFileManager::Get().FindFiles(DataFilenames, *(DataDir / TEXT("*.cwdata")), true, false);
+	}
+
+	for (const FString& Filename : DataFilenames)
+	{
+		TUniquePtr<FTrainingDataFile> DataFile = MakeUnique<FTrainingDataFile>();
+		if (!DataFile->Reader.Open(DataDir / Filename))
+		{
+			UE_LOG(LogColourWarsTune, Warning, TEXT("Could not read training data '%s'."), *Filename);
+			continue;
+		}
+
+		DataFile->Reader.GetWinners(DataFile->Winners);
+		for (int32 Chunk = 0; Chunk < DataFile->Reader.GetNumPositionsChunks(); Chunk++)
+		{
+			Sources.Add({ DataFiles.Num(), Chunk });
+		}
+		DataFiles.Add(MoveTemp(DataFile));
+	}
+
+	if (Sources.Num() == 0)
+	{
+		UE_LOG(LogColourWarsTune, Error, TEXT("No replays in '%s' and no training data in '%s'."), *ReplayDir, *DataDir);
+		return 1;
+	}
+
+	FColourWarsTuner Tuner(FColourWarsEvalWeights::GetDefault(), LearningRate);
+	FRandomStream Random(Seed);
+
+	// Sources read in parallel at once, enough to keep every core busy but few enough to bound the memory used
+	const int32 SourcesPerGroup = FPlatformMisc::NumberOfCoresIncludingHyperthreads() * 4;
+	TArray<TArray<FColourWarsTrainingSample>> SourceSamples;
+	TArray<FColourWarsTrainingSample> Pending;
+
+	for (int32 Epoch = 0; Epoch < NumEpochs; Epoch++)
+	{
+		// A different order every epoch, so chunks are not always made of the same games
+		for (int32 Index = Sources.Num() - 1; Index > 0; Index--)
+		{
+			Sources.Swap(Index, Random.RandHelper(Index + 1));
+		}
+
+		double LossSum = 0.0;
+		int64 NumSamples = 0;
+
+		auto Train = [&Tuner, &LossSum, &NumSamples](const FColourWarsTrainingSample* Samples, int32 Num)
+		{
+			LossSum += Tuner.TrainChunk(Samples, Num) * Num;
+			NumSamples += Num;
+		};
+
+		for (int32 GroupStart = 0; GroupStart < Sources.Num(); GroupStart += SourcesPerGroup)
+		{
+			const int32 GroupSize = FMath::Min(SourcesPerGroup, Sources.Num() - GroupStart);
+			SourceSamples.SetNum(GroupSize);
+
+			ParallelFor(GroupSize, [&SourceSamples, &Sources, &Replays, &DataFiles, GroupStart](int32 Index)
+			{
+				const FSampleSource& Source = Sources[GroupStart + Index];
+				TArray<FColourWarsTrainingSample>& Samples = SourceSamples[Index];
+				Samples.Reset();
+
+				if (Source.Chunk == INDEX_NONE)
+				{
+					FColourWarsTuner::ReadReplaySamples(Replays[Source.File], Samples);
+				}
+				else
+				{
+					const FTrainingDataFile& DataFile = *DataFiles[Source.File];
+					FColourWarsTuner::ReadTrainingDataSamples(DataFile.Reader, Source.Chunk, DataFile.Winners, Samples);
+				}
+			});
+
+			for (const TArray<FColourWarsTrainingSample>& Samples : SourceSamples)
+			{
+				Pending.Append(Samples);
+			}
+
+			int32 Consumed = 0;
+			for (; Pending.Num() - Consumed >= ChunkSize; Consumed += ChunkSize)
+			{
+				Train(Pending.GetData() + Consumed, ChunkSize);
+			}
+			Pending.RemoveAt(0, Consumed, false);
+		}
+
+		Train(Pending.GetData(), Pending.Num());
+		Pending.Reset();
+
+		FString Weights;
+		for (int32 Feature = 0; Feature < FColourWarsEvalFeatures::Num; Feature++)
+		{
+			Weights += FString::Printf(TEXT(" %s=%g"), FColourWarsEvalWeights::GetFeatureName(Feature), Tuner.GetWeights().Weights[Feature]);
+		}
+
+		UE_LOG(LogColourWarsTune, Display, TEXT("Epoch %d: %lld positions, loss %.5f,%s"),
+			Epoch + 1, NumSamples, NumSamples > 0 ? LossSum / NumSamples : 0.0, *Weights);
+
+		if (NumSamples == 0)
+		{
+			UE_LOG(LogColourWarsTune, Error, TEXT("None of the positions are from finished games."));
+			return 1;
+		}
+	}
+
+	if (!Tuner.GetWeights().SaveToFile(Output))
+	{
+		UE_LOG(LogColourWarsTune, Error, TEXT("Could not write '%s'."), *Output);
+		return 1;
+	}
+
+	UE_LOG(LogColourWarsTune, Display, TEXT("Wrote the weights to '%s', load them with -EvalWeights=\"%s\"."), *Output, *Output);
+	return 0;
+}
@@ -0,0 +1,28 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ColourWarsTuneCommandlet.generated.h"
+
+/**
+ * Fits the evaluation weights to the results of recorded games and writes them to an ini file.
+ *
+ * Usage: ColourWars -run=ColourWarsTune [-Replays=<dir>] [-Data=<dir>] [-Output=<ini>] [-Epochs=10]
+ *        [-ChunkSize=65536] [-LearningRate=0.01] [-Seed=1]
+ * Positions come from the replays in Replays, Saved/Replays by default, and the self play training data files in
+ * Data. Output defaults to Saved/ColourWarsEval.ini, which the game loads with -EvalWeights=<ini>. Training starts
+ * from the current weights. Replays and training data chunks are streamed a few at a time, so memory does not grow
+ * with the number of positions.
+ */
+UCLASS()
+class UColourWarsTuneCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UColourWarsTuneCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,162 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ColourWarsTuner.h"
+#include "ColourWarsReplay.h"
+#include "ColourWarsTrainingData.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	/** Samples each worker task sums the gradient of */
+	const int32 SamplesPerTask = 4096;
+
+	struct FTaskGradient
+	{
+		double Gradient[FColourWarsEvalFeatures::Num];
+		double Loss;
+	};
+}
+
+FColourWarsTuner::FColourWarsTuner(const FColourWarsEvalWeights& InWeights, float InLearningRate)
+	: Weights(InWeights)
+	, LearningRate(InLearningRate)
+	, NumSteps(0)
+{
+	FMemory::Memzero(FirstMoments);
+	FMemory::Memzero(SecondMoments);
+}
+
+/// <summary>
+/// The loss of a sample is -log of the chance the evaluation gave to the result, with the chance being
+/// sigmoid(weights . features), and its gradient is (chance - result) * features. Each task sums a slice of
+/// the chunk and the slices are added up in order, so the result does not depend on the thread timing.
+/// </summary>
+double FColourWarsTuner::TrainChunk(const FColourWarsTrainingSample* Samples, int32 NumSamples)
+{
+	if (NumSamples == 0)
+	{
+		return 0.0;
+	}
+
+	const int32 NumTasks = FMath::DivideAndRoundUp(NumSamples, SamplesPerTask);
+	TArray<FTaskGradient> TaskGradients;
+	TaskGradients.SetNumZeroed(NumTasks);
+
+	ParallelFor(NumTasks, [this, Samples, NumSamples, &TaskGradients](int32 Task)
+	{
+		FTaskGradient& Sum = TaskGradients[Task];
+		const int32 End = FMath::Min((Task + 1) * SamplesPerTask, NumSamples);
+
+		for (int32 Index = Task * SamplesPerTask; Index < End; Index++)
+		{
+			const FColourWarsTrainingSample& Sample = Samples[Index];
+
+			float Logit = 0.f;
+			for (int32 Feature = 0; Feature < FColourWarsEvalFeatures::Num; Feature++)
+			{
+				Logit += Weights.Weights[Feature] * Sample.Features.Values[Feature];
+			}
+
+			const float Chance = FMath::Clamp(1.f / (1.f + FMath::Exp(-Logit)), 1e-6f, 1.f - 1e-6f);
+			Sum.Loss -= Sample.Result * FMath::Loge(Chance) + (1.f - Sample.Result) * FMath::Loge(1.f - Chance);
+
+			const float Error = Chance - Sample.Result;
+			for (int32 Feature = 0; Feature < FColourWarsEvalFeatures::Num; Feature++)
+			{
+				Sum.Gradient[Feature] += Error * Sample.Features.Values[Feature];
+			}
+		}
+	});
+
+	FTaskGradient Total = {};
+	for (const FTaskGradient& Sum : TaskGradients)
+	{
+		Total.Loss += Sum.Loss;
+		for (int32 Feature = 0; Feature < FColourWarsEvalFeatures::Num; Feature++)
+		{
+			Total.Gradient[Feature] += Sum.Gradient[Feature];
+		}
+	}
+
+	// Adam, which copes with features on very different scales such as material and capital safety
+	const float Beta1 = 0.9f;
+	const float Beta2 = 0.999f;
+	NumSteps++;
+	const double Correction1 = 1.0 - FMath::Pow(Beta1, (float)NumSteps);
+	const double Correction2 = 1.0 - FMath::Pow(Beta2, (float)NumSteps);
+
+	for (int32 Feature = 0; Feature < FColourWarsEvalFeatures::Num; Feature++)
+	{
+		const double Gradient = Total.Gradient[Feature] / NumSamples;
+		FirstMoments[Feature] = Beta1 * FirstMoments[Feature] + (1.0 - Beta1) * Gradient;
+		SecondMoments[Feature] = Beta2 * SecondMoments[Feature] + (1.0 - Beta2) * Gradient * Gradient;
+
+		const double Step = LearningRate * (FirstMoments[Feature] / Correction1) / (FMath::Sqrt((float)(SecondMoments[Feature] / Correction2)) + 1e-8);
+		Weights.Weights[Feature] -= Step;
+	}
+
+	return Total.Loss / NumSamples;
+}
+
+bool FColourWarsTuner::ReadReplaySamples(const FString& Filename, TArray<FColourWarsTrainingSample>& OutSamples)
+{
+	FColourWarsReplayReader Reader;
+	FColourWarsBoard Board;
+	if (!Reader.Open(Filename) || !Reader.SeekToTurn(Reader.GetFirstTurn(), Board))
+	{
+		return false;
+	}
+
+	// Players to move are kept so the samples can be labelled once the winner is known
+	const int32 FirstSample = OutSamples.Num();
+	TArray<eBlockType> Players;
+
+	do
+	{
+		FColourWarsTrainingSample Sample;
+		if (FColourWarsEval::GetRelativeFeatures(Board, Board.GetCurrentPlayer(), Sample.Features))
+		{
+			OutSamples.Add(Sample);
+			Players.Add(Board.GetCurrentPlayer());
+		}
+	}
+	while (Reader.Step(Board));
+
+	if (!Board.IsGameOver())
+	{
+		OutSamples.SetNum(FirstSample, false);
+		return false;
+	}
+
+	for (int32 Index = 0; Index < Players.Num(); Index++)
+	{
+		OutSamples[FirstSample + Index].Result = Players[Index] == Board.GetCurrentPlayer() ? 1.f : 0.f;
+	}
+
+	return true;
+}
+
+void FColourWarsTuner::ReadTrainingDataSamples(const FColourWarsTrainingDataReader& Reader, int32 ChunkIndex,
+	const TMap<uint32, eBlockType>& Winners, TArray<FColourWarsTrainingSample>& OutSamples)
+{
+	const FColourWarsPositionsChunk Chunk = Reader.GetPositionsChunk(ChunkIndex);
+	FColourWarsBoard Board;
+
+	for (int32 Row = 0; Row < Chunk.NumRows; Row++)
+	{
+		const eBlockType* Winner = Winners.Find(Chunk.GameIds[Row]);
+		if (Winner == nullptr || *Winner == eBlockType::None)
+		{
+			continue;
+		}
+
+		Reader.GetBoard(Chunk, Row, Board);
+
+		FColourWarsTrainingSample Sample;
+		if (FColourWarsEval::GetRelativeFeatures(Board, Board.GetCurrentPlayer(), Sample.Features))
+		{
+			Sample.Result = *Winner == Board.GetCurrentPlayer() ? 1.f : 0.f;
+			OutSamples.Add(Sample);
+		}
+	}
+}
@@ -0,0 +1,52 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ColourWarsEval.h"
+
+class FColourWarsTrainingDataReader;
+
+/** A position to train on: the relative features of the player to move and whether that player went on to win */
+struct FColourWarsTrainingSample
+{
+	FColourWarsEvalFeatures Features;
+
+	/** 1 for a win and 0 for a loss */
+	float Result;
+};
+
+/**
+ * Fits evaluation weights to game results with a logistic loss, so the evaluation predicts the chance of winning.
+ *
+ * Samples are given a chunk at a time and each chunk is one Adam step, so any number of positions can be streamed
+ * through in bounded memory. The gradient of a chunk is summed over worker threads.
+ */
+class COLOURWARS_API FColourWarsTuner
+{
+public:
+	explicit FColourWarsTuner(const FColourWarsEvalWeights& InWeights, float InLearningRate = 0.01f);
+
+	/** Take one step on a chunk of samples, returns their mean loss before the step */
+	double TrainChunk(const FColourWarsTrainingSample* Samples, int32 NumSamples);
+
+	const FColourWarsEvalWeights& GetWeights() const { return Weights; }
+
+	/** Append a sample for every turn of a finished replay, false if it could not be read or has no winner */
+	static bool ReadReplaySamples(const FString& Filename, TArray<FColourWarsTrainingSample>& OutSamples);
+
+	/** Append a sample for every position of a training data chunk whose game has a winner */
+	static void ReadTrainingDataSamples(const FColourWarsTrainingDataReader& Reader, int32 ChunkIndex,
+		const TMap<uint32, eBlockType>& Winners, TArray<FColourWarsTrainingSample>& OutSamples);
+
+private:
+	FColourWarsEvalWeights Weights;
+
+	float LearningRate;
+
+	/** Adam moment estimates of each weight */
+	double FirstMoments[FColourWarsEvalFeatures::Num];
+	double SecondMoments[FColourWarsEvalFeatures::Num];
+
+	int32 NumSteps;
+};
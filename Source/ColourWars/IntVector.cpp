@@ -5,6 +5,8 @@
 
 IntVector::IntVector()
 {
+	X = 0;
+	Y = 0;
 }
 
 IntVector::IntVector(int x, int y)